@@ -178,6 +178,17 @@ namespace MFM {
 
     BV m_stg;
 
+    /**
+       The BitVector this storage wraps, for callers (like
+       UlamRefTyped) that know this storage's static type and want to
+       avoid the virtual accessors
+    */
+    typedef BV STORAGE_BV;
+
+    STORAGE_BV & GetBitVector() { return m_stg; }
+
+    const STORAGE_BV & GetBitVector() const { return m_stg; }
+
     virtual u32 Read(u32 pos, u32 len) const
     {
       return m_stg.Read(pos, len);
@@ -246,6 +257,17 @@ namespace MFM {
 
     T& m_stg;
 
+    /**
+       The BitVector this storage wraps, for callers (like
+       UlamRefTyped) that know this storage's static type and want to
+       avoid the virtual accessors
+    */
+    typedef BitVector<T::BPA> STORAGE_BV;
+
+    STORAGE_BV & GetBitVector() { return m_stg.GetBits(); }
+
+    const STORAGE_BV & GetBitVector() const { return m_stg.GetBits(); }
+
     virtual u32 Read(u32 pos, u32 len) const
     {
       return m_stg.GetBits().Read(pos, len);
@@ -79,6 +79,7 @@ namespace MFM {
 
   private:
     template <typename EC> friend class BitRef;
+    template <u32 OTHER_B> friend class BitVector;  // For CopyBV's unit-aligned path
     BitUnitType m_bits[ARRAY_LENGTH];
 
     /**
@@ -335,6 +336,22 @@ namespace MFM {
     inline void CopyBV(const u32 srcStartIdx, const u32 dstStartIdx, const u32 length, BitVector<BITS> & dstbv) const
     {
       MFM_API_ASSERT_ARG(((void*) this) != ((void*) &dstbv)); // Ensure distinct ptrs; can't move within yourself
+      if (((srcStartIdx | dstStartIdx) % BITS_PER_UNIT) == 0)
+      {
+        // Both ends unit-aligned (e.g., whole atoms): copy whole
+        // units, then at most one partial unit
+        MFM_API_ASSERT_ARG(srcStartIdx + length <= B);
+        MFM_API_ASSERT_ARG(dstStartIdx + length <= BITS);
+        const u32 srcUnit = srcStartIdx / BITS_PER_UNIT;
+        const u32 dstUnit = dstStartIdx / BITS_PER_UNIT;
+        const u32 units = length / BITS_PER_UNIT;
+        for (u32 i = 0; i < units; ++i)
+          dstbv.m_bits[dstUnit + i] = m_bits[srcUnit + i];
+        const u32 done = units * BITS_PER_UNIT;
+        if (done < length)
+          dstbv.Write(dstStartIdx + done, length - done, this->Read(srcStartIdx + done, length - done));
+        return;
+      }
       u32 amt = BITS_PER_UNIT;
       for (u32 i = 0; i < length; i += amt)
 	{
@@ -35,6 +35,7 @@
 #include "Packet.h"
 #include "ChannelEnd.h"
 #include "MDist.h"  /* for EVENT_WINDOW_SITES */
+#include "CacheProfile.h"
 #include "Logger.h"
 
 namespace MFM {
@@ -53,6 +54,8 @@ namespace MFM {
   template <class EC>
   class CacheProcessor
   {
+    friend class PacketIO;  // For the batched update encoding
+
     // Extract short names for parameter types
     typedef typename EC::ATOM_CONFIG AC;
     typedef typename AC::ATOM_TYPE T;
@@ -152,6 +155,32 @@ namespace MFM {
      */
     bool m_useAdaptiveRedundancy;
 
+    /**
+       If true, ship each cache update as a single binary
+       UPDATE_BATCH packet; otherwise use the original one-packet-
+       per-atom text format, which is easier to read when debugging.
+       Inbound packets of either format are always accepted.
+     */
+    bool m_useBinaryPackets;
+
+    /**
+       Total bytes (framing included) written to m_channelEnd by
+       ShipBufferAsPacket
+     */
+    u64 m_bytesShipped;
+
+    /**
+       When, if our Tile has a CacheProfile, we entered m_cpState, and
+       when we began shipping the current update; 0 if not known.
+     */
+    u64 m_stateEnteredNanos;
+    u64 m_updateStartNanos;
+
+    CacheProfile * GetCacheProfile()
+    {
+      return m_tile ? m_tile->GetCacheProfile() : 0;
+    }
+
     u32 GetCheckOdds() const
     {
       return m_checkOdds;
@@ -275,6 +304,13 @@ namespace MFM {
      */
     ChannelEnd m_channelEnd;
 
+    /**
+       Charge the time spent in m_cpState, and the update latency if
+       \c state finishes an update, to our Tile's CacheProfile if it
+       has one.
+     */
+    void ProfileStateChange(State state) ;
+
     void SetStateInternal(State state)
     {
       MFM_LOG_DBG6(("CP %s %s %d[%s %s %s] (%d,%d): %s->%s",
@@ -288,6 +324,7 @@ namespace MFM {
                     m_farSideOrigin.GetY(),
                     GetStateName(m_cpState),
                     GetStateName(state)));
+      ProfileStateChange(state);
       m_cpState = state;
     }
 
@@ -331,6 +368,21 @@ namespace MFM {
       }
     }
 
+    void SetBinaryPackets(bool binary)
+    {
+      m_useBinaryPackets = binary;
+    }
+
+    bool IsUsingBinaryPackets() const
+    {
+      return m_useBinaryPackets;
+    }
+
+    u64 GetBytesShipped() const
+    {
+      return m_bytesShipped;
+    }
+
     void ReportCacheProcessorStatus(Logger::Level level) ;
 
     /**
@@ -452,6 +504,15 @@ namespace MFM {
       return m_channelEnd.IsConnected();
     }
 
+    /**
+       True if this CacheProcessor is mid-update or has unread bytes
+       waiting in its channel.
+     */
+    bool HasBacklog()
+    {
+      return !IsIdle() || m_channelEnd.CanRead() > 0;
+    }
+
     void ClaimCacheProcessor(Tile<EC>& tile, AbstractChannel& channel, LonglivedLock & lock, Dir toCache)
     {
       MFM_API_ASSERT_STATE(!m_tile && !m_longlivedLock);
@@ -534,6 +595,10 @@ namespace MFM {
       , m_checkOdds(INITIAL_CHECK_ODDS)
       , m_remoteConsistentAtomCount(0)
       , m_useAdaptiveRedundancy(true)
+      , m_useBinaryPackets(true)
+      , m_bytesShipped(0)
+      , m_stateEnteredNanos(0)
+      , m_updateStartNanos(0)
       , m_cpState(UNCLAIMED)
       , m_eventCenter(0,0)
       , m_farSideOrigin(0,0)
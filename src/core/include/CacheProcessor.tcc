@@ -30,6 +30,47 @@ namespace MFM
     m_channelEnd.ReportChannelEndStatus(level);
   }
 
+  template <class EC>
+  void CacheProcessor<EC>::ProfileStateChange(State state)
+  {
+    CacheProfile * profile = GetCacheProfile();
+    if (!profile)
+    {
+      m_stateEnteredNanos = m_updateStartNanos = 0;
+      return;
+    }
+
+    u64 now = GetMonotonicNanos();
+    CacheProfile::Boundary & b = profile->GetBoundary(m_cacheDir);
+    if (m_stateEnteredNanos != 0)
+    {
+      u64 elapsed = now - m_stateEnteredNanos;
+      switch (m_cpState)
+      {
+      case SHIPPING:  b.m_nanos[CacheProfile::STATE_SHIPPING] += elapsed; break;
+      case RECEIVING: b.m_nanos[CacheProfile::STATE_RECEIVING] += elapsed; break;
+      case BLOCKING:  b.m_nanos[CacheProfile::STATE_BLOCKING] += elapsed; break;
+      case PASSIVE:   b.m_nanos[CacheProfile::STATE_PASSIVE] += elapsed; break;
+      default: break;
+      }
+    }
+
+    if (state == SHIPPING)
+    {
+      m_updateStartNanos = now;
+    }
+    else if (state == PASSIVE)
+    {
+      ++b.m_updatesReceived;
+    }
+    else if (state == IDLE && m_cpState == BLOCKING && m_updateStartNanos != 0)
+    {
+      profile->RecordLatency(m_cacheDir, now - m_updateStartNanos);
+      m_updateStartNanos = 0;
+    }
+    m_stateEnteredNanos = now;
+  }
+
   template <class EC>
   bool CacheProcessor<EC>::IsSiteNumberVisible(u16 siteNumber)
   {
@@ -62,6 +103,12 @@ namespace MFM
     // Now it's about shipping
     SetStateInternal(SHIPPING);
 
+    // (Batched updates send their begin along with everything else)
+    if (m_useBinaryPackets)
+    {
+      return;
+    }
+
     PacketIO pbuffer;
     if (!pbuffer.SendUpdateBegin(*this, m_eventCenter))
     {
@@ -122,6 +169,13 @@ namespace MFM
     cpi.m_atom = atom;
     cpi.m_siteNumber = siteNumber;
     cpi.m_type = changed ? PacketType::UPDATE : PacketType::CHECK;
+
+    CacheProfile * profile = GetCacheProfile();
+    if (profile)
+    {
+      CacheProfile::Boundary & b = profile->GetBoundary(m_cacheDir);
+      ++(changed ? b.m_atomsUpdated : b.m_atomsChecked);
+    }
   }
 
   template <class EC>
@@ -130,14 +184,37 @@ namespace MFM
     MFM_API_ASSERT(!pb.HasOverflowed(), OUT_OF_ROOM);
 
     u32 plen = pb.GetLength();
-    if (m_channelEnd.CanWrite() <= plen) // Total write will be plen+1
+
+    u8 header[3];
+    u32 hlen = 0;
+    if (plen < PacketFraming::EXTENDED_LENGTH)
+    {
+      header[hlen++] = (u8) plen;
+    }
+    else
+    {
+      MFM_API_ASSERT(plen <= U16_MAX, OUT_OF_ROOM);
+      header[hlen++] = PacketFraming::EXTENDED_LENGTH;
+      header[hlen++] = (u8) plen;
+      header[hlen++] = (u8) (plen >> 8);
+    }
+
+    if (m_channelEnd.CanWrite() < plen + hlen)
     {
       return false;
     }
 
-    u8 byte = (u8) plen;  // plen<128 since OString128..
-    m_channelEnd.Write(&byte, 1);  // Packet length, then data
+    m_channelEnd.Write(header, hlen);  // Packet length, then data
     m_channelEnd.Write((const u8 *) pb.GetBuffer(), plen);
+    m_bytesShipped += hlen + plen;
+
+    CacheProfile * profile = GetCacheProfile();
+    if (profile)
+    {
+      CacheProfile::Boundary & b = profile->GetBoundary(m_cacheDir);
+      ++b.m_packets;
+      b.m_bytes += hlen + plen;
+    }
     return true;
   }
 
@@ -266,6 +343,11 @@ namespace MFM
     if (consistentCount != m_toSendCount)
     {
       ReportCheckFailure();
+      CacheProfile * profile = GetCacheProfile();
+      if (profile)
+      {
+        ++profile->GetBoundary(m_cacheDir).m_checkFailures;
+      }
     }
     else
     {
@@ -347,6 +429,18 @@ namespace MFM
     bool didWork = false;
     PacketIO pbuffer;
 
+    // Ship the whole update at once, if we're batching
+    if (m_useBinaryPackets)
+    {
+      if (!pbuffer.SendUpdateBatch(*this))
+      {
+        return didWork;
+      }
+      m_sentCount = m_toSendCount;
+      SetStateInternal(RECEIVING);
+      return true;
+    }
+
     // Try to send any unsent packets
     while (m_sentCount < m_toSendCount)
     {
@@ -0,0 +1,237 @@
+/*                                              -*- mode:C++ -*-
+  CacheProfile.h Accumulated intertile cache protocol statistics
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file CacheProfile.h Accumulated intertile cache protocol statistics
+  \lgpl
+ */
+#ifndef CACHEPROFILE_H
+#define CACHEPROFILE_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Dirs.h"
+#include "Log2Histogram.h"
+
+namespace MFM
+{
+  /**
+   * Lock contention and cache protocol activity at each of a Tile's
+   * boundaries, summed while the profile was attached to the Tile
+   * (see Tile::SetCacheProfile, which also says when it is safe to
+   * read).
+   *
+   * Times are in GetMonotonicNanos() nanoseconds.
+   */
+  struct CacheProfile
+  {
+    /**
+     * The CacheProcessor states whose duration is recorded
+     */
+    enum State
+    {
+      STATE_SHIPPING,   //< Locked by us, shipping an update
+      STATE_RECEIVING,  //< Locked by us, awaiting the peer's reply
+      STATE_BLOCKING,   //< Locked by us, awaiting our sibling CacheProcessors
+      STATE_PASSIVE,    //< Locked by the peer, receiving its update
+      STATE_COUNT
+    };
+
+    static const char * GetStateName(u32 state)
+    {
+      switch (state)
+      {
+      case STATE_SHIPPING:  return "shipping";
+      case STATE_RECEIVING: return "receiving";
+      case STATE_BLOCKING:  return "blocking";
+      case STATE_PASSIVE:   return "passive";
+      default: FAIL(ILLEGAL_ARGUMENT);
+      }
+    }
+
+    /**
+     * Why EventWindow::AcquireDirLock returned LOCK_UNAVAILABLE
+     */
+    enum Stall
+    {
+      STALL_BUSY,       //< Our CacheProcessor was still finishing an update
+      STALL_CONTENDED,  //< The peer held the boundary's LonglivedLock
+      STALL_COUNT
+    };
+
+    static const char * GetStallName(u32 stall)
+    {
+      switch (stall)
+      {
+      case STALL_BUSY:      return "busy";
+      case STALL_CONTENDED: return "contended";
+      default: FAIL(ILLEGAL_ARGUMENT);
+      }
+    }
+
+    enum
+    {
+      HISTOGRAM_BUCKETS = 32    //< Bucket b counts updates taking [2**b, 2**(b+1)) ns; the last is open-ended
+    };
+
+    typedef Log2Histogram<HISTOGRAM_BUCKETS> Histogram;
+
+    struct Boundary
+    {
+      u64 m_nanos[STATE_COUNT];
+
+      u64 m_stalls[STALL_COUNT];
+
+      /** Updates we sent, counted when their reply unblocked us */
+      u64 m_updates;
+
+      /** Updates the peer sent us */
+      u64 m_updatesReceived;
+
+      /** Packets and bytes (framing included) shipped to the peer */
+      u64 m_packets;
+      u64 m_bytes;
+
+      /** Atoms shipped because the event changed them */
+      u64 m_atomsUpdated;
+
+      /** Unchanged atoms shipped as redundant checks */
+      u64 m_atomsChecked;
+
+      /** Replies reporting an inconsistent peer cache */
+      u64 m_checkFailures;
+
+      /** Time from starting to ship an update until it was unblocked */
+      Histogram m_latency;
+
+      void Clear()
+      {
+        for (u32 i = 0; i < STATE_COUNT; ++i)
+        {
+          m_nanos[i] = 0;
+        }
+        for (u32 i = 0; i < STALL_COUNT; ++i)
+        {
+          m_stalls[i] = 0;
+        }
+        m_updates = 0;
+        m_updatesReceived = 0;
+        m_packets = 0;
+        m_bytes = 0;
+        m_atomsUpdated = 0;
+        m_atomsChecked = 0;
+        m_checkFailures = 0;
+        m_latency.Clear();
+      }
+
+      u64 GetTotalStalls() const
+      {
+        u64 total = 0;
+        for (u32 i = 0; i < STALL_COUNT; ++i)
+        {
+          total += m_stalls[i];
+        }
+        return total;
+      }
+
+      void Add(const Boundary & other)
+      {
+        for (u32 i = 0; i < STATE_COUNT; ++i)
+        {
+          m_nanos[i] += other.m_nanos[i];
+        }
+        for (u32 i = 0; i < STALL_COUNT; ++i)
+        {
+          m_stalls[i] += other.m_stalls[i];
+        }
+        m_updates += other.m_updates;
+        m_updatesReceived += other.m_updatesReceived;
+        m_packets += other.m_packets;
+        m_bytes += other.m_bytes;
+        m_atomsUpdated += other.m_atomsUpdated;
+        m_atomsChecked += other.m_atomsChecked;
+        m_checkFailures += other.m_checkFailures;
+        m_latency.Add(other.m_latency);
+      }
+    };
+
+    Boundary m_boundaries[Dirs::DIR_COUNT];
+
+    CacheProfile()
+    {
+      Reset();
+    }
+
+    void Reset()
+    {
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        m_boundaries[d].Clear();
+      }
+    }
+
+    void Add(const CacheProfile & other)
+    {
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        m_boundaries[d].Add(other.m_boundaries[d]);
+      }
+    }
+
+    Boundary & GetBoundary(Dir dir)
+    {
+      MFM_API_ASSERT_ARG(dir < Dirs::DIR_COUNT);
+      return m_boundaries[dir];
+    }
+
+    const Boundary & GetBoundary(Dir dir) const
+    {
+      MFM_API_ASSERT_ARG(dir < Dirs::DIR_COUNT);
+      return m_boundaries[dir];
+    }
+
+    void RecordStall(Dir dir, Stall why)
+    {
+      ++GetBoundary(dir).m_stalls[why];
+    }
+
+    void RecordLatency(Dir dir, u64 nanos)
+    {
+      Boundary & b = GetBoundary(dir);
+      ++b.m_updates;
+      b.m_latency.Record(nanos);
+    }
+
+    /**
+     * Total stalls summed over all boundaries
+     */
+    u64 GetTotalStalls() const
+    {
+      u64 total = 0;
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        total += m_boundaries[d].GetTotalStalls();
+      }
+      return total;
+    }
+  };
+} /* namespace MFM */
+
+#endif /* CACHEPROFILE_H */
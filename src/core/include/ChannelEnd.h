@@ -55,11 +55,15 @@ namespace MFM
 
     /**
        Total packet length of the packet (being) received into
-       m_packetBuffer, or -1 to indicate no packet has currently been
-       started.
+       m_packetBuffer, or NO_PACKET to indicate no packet has
+       currently been started, or EXTENDED_LENGTH_PENDING if we have
+       read PacketFraming::EXTENDED_LENGTH but not yet the u16 length
+       that follows it.
      */
     s32 m_packetLength;
 
+    enum { NO_PACKET = -1, EXTENDED_LENGTH_PENDING = -2 };
+
     /**
        The channel transporting bytes to and from the far side
      */
@@ -158,7 +162,7 @@ namespace MFM
     PacketBuffer * ReceivePacket() ;
 
     ChannelEnd()
-      : m_packetLength(-1)
+      : m_packetLength(NO_PACKET)
       , m_channel(0)
       , m_onSideA(false)
       , m_owner(-1)
@@ -116,6 +116,48 @@ namespace MFM
      */
     const char* m_name;
 
+    enum { ATOM_COLOR_CACHE_SIZE = 256 };
+
+    /**
+     * A remembered GetAtomColor result.  m_seq is 0 if the entry was
+     * never written, odd while it is being written, and even
+     * otherwise; __atomic access, so renderer threads can share the
+     * cache.
+     */
+    struct AtomColorEntry
+    {
+      T m_atom;
+      u32 m_selector;
+      u32 m_parametersHash;
+      u32 m_color;
+      u32 m_seq;
+
+      AtomColorEntry()
+        : m_selector(0)
+        , m_parametersHash(0)
+        , m_color(0)
+        , m_seq(0)
+      { }
+    };
+
+    /**
+     * GetAtomColor results by hash of atom and selector, when
+     * m_cacheAtomColors
+     */
+    mutable AtomColorEntry m_atomColors[ATOM_COLOR_CACHE_SIZE];
+
+    bool m_cacheAtomColors;
+
+    static u32 HashAtomBits(const T & atom, u32 hash) ;
+
+    /**
+     * A hash of the values of all this Element's parameters, which
+     * invalidates remembered colors when any of them changes.
+     */
+    u32 GetParametersHash() const ;
+
+    u32 LookupAtomColor(const ElementTable<EC> & et, const UlamClassRegistry<EC> & ucr, const T& atom, u32 selector) const ;
+
    public:
 
     /**
@@ -251,6 +293,18 @@ namespace MFM
       m_name = name;
     }
 
+    /**
+     * Have GetDynamicColor remember GetAtomColor results, keyed by
+     * atom bits and selector, for Elements whose atom colors depend
+     * only on those and on this Element's parameters, and are costly
+     * to compute.
+     */
+    void SetCachingAtomColors(bool cache)
+    {
+      m_cacheAtomColors = cache;
+      ClearAtomColorCache();
+    }
+
    public:
 
     /**
@@ -264,7 +318,8 @@ namespace MFM
                                  m_hasType(false),
                                  m_renderLowlight(false),
                                  m_atomicSymbol("!!"),
-                                 m_name("UNNAMED")
+                                 m_name("UNNAMED"),
+                                 m_cacheAtomColors(false)
     {
       LOG.Debug("Constructed %@ at %p", &m_UUID, this);
     }
@@ -521,7 +576,9 @@ namespace MFM
      */
     u32 GetDynamicColor(const ElementTable<EC> & et, const UlamClassRegistry<EC> & ucr, const T& atom, u32 selector) const
     {
-      u32 baseColor = this->GetAtomColor(et, ucr, atom, selector);
+      u32 baseColor = (m_cacheAtomColors && selector != 0) ?
+        LookupAtomColor(et, ucr, atom, selector) :
+        this->GetAtomColor(et, ucr, atom, selector);
 
       if(m_renderLowlight)
       {
@@ -531,6 +588,35 @@ namespace MFM
       return baseColor;
     }
 
+    /**
+     * A hash of what GetStaticColor and GetDynamicColor depend on
+     * besides the atom and selector, as far as this Element can tell:
+     * its parameter values and lowlighting.  Whoever keeps drawn
+     * colors can watch it to know when to redraw.
+     */
+    u32 GetColorStateHash() const
+    {
+      return GetParametersHash() ^ (m_renderLowlight ? 0x9e3779b9 : 0);
+    }
+
+    /**
+     * Forget all the atom colors remembered for GetDynamicColor, when
+     * something besides the atom, the selector, and this Element's
+     * parameters has changed how they would be computed.
+     */
+    void ClearAtomColorCache()
+    {
+      for (u32 i = 0; i < ATOM_COLOR_CACHE_SIZE; ++i)
+      {
+        __atomic_store_n(&m_atomColors[i].m_seq, 0, __ATOMIC_RELEASE);
+      }
+    }
+
+    bool IsCachingAtomColors() const
+    {
+      return m_cacheAtomColors;
+    }
+
     /**
      * On entry, the Atom at \a nowAt will be an instance of the type
      * of this Element.  How much does that atom like the idea that it
@@ -4,4 +4,74 @@
 
 namespace MFM
 {
+  template <class EC>
+  u32 Element<EC>::HashAtomBits(const T & atom, u32 hash)
+  {
+    const BitVector<BPA> & bits = GetBits(atom);
+    for (u32 i = 0; i < BPA; i += 32)
+    {
+      const u32 len = BPA - i < 32 ? BPA - i : 32;
+      hash = (hash ^ bits.Read(i, len)) * 0x01000193;  // FNV-1a, a word at a time
+      hash ^= hash >> 15;
+    }
+    return hash;
+  }
+
+  template <class EC>
+  u32 Element<EC>::GetParametersHash() const
+  {
+    u32 hash = 0x811c9dc5;
+    for (const ElementParameter<EC> * p = m_elementParameters.GetFirstParameter();
+         p != 0;
+         p = p->GetNextParameter())
+    {
+      hash = HashAtomBits(p->GetAtom(), hash);
+    }
+    return hash;
+  }
+
+  template <class EC>
+  u32 Element<EC>::LookupAtomColor(const ElementTable<EC> & et, const UlamClassRegistry<EC> & ucr,
+                                   const T& atom, u32 selector) const
+  {
+    const u32 parametersHash = GetParametersHash();
+    AtomColorEntry & entry =
+      m_atomColors[HashAtomBits(atom, 0x811c9dc5 ^ selector) % ATOM_COLOR_CACHE_SIZE];
+
+    // A seqlock: trust what we read only if no write began or ended meanwhile
+    u32 seq = __atomic_load_n(&entry.m_seq, __ATOMIC_ACQUIRE);
+    if (seq != 0 && (seq & 1) == 0)
+    {
+      const bool hit =
+        entry.m_selector == selector &&
+        entry.m_parametersHash == parametersHash &&
+        entry.m_atom == atom;
+      const u32 color = entry.m_color;
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (hit && __atomic_load_n(&entry.m_seq, __ATOMIC_RELAXED) == seq)
+      {
+        return color;
+      }
+    }
+
+    const u32 color = this->GetAtomColor(et, ucr, atom, selector);
+
+    // Skip remembering it if another thread is writing this entry
+    if ((seq & 1) == 0 &&
+        __atomic_compare_exchange_n(&entry.m_seq, &seq, seq + 1, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+      entry.m_atom = atom;
+      entry.m_selector = selector;
+      entry.m_parametersHash = parametersHash;
+      entry.m_color = color;
+      u32 next = seq + 2;
+      if (next == 0)
+      {
+        next = 2;  // 0 means never written
+      }
+      __atomic_store_n(&entry.m_seq, next, __ATOMIC_RELEASE);
+    }
+    return color;
+  }
 }
@@ -0,0 +1,202 @@
+/*                                              -*- mode:C++ -*-
+  ElementProfile.h Accumulated event costs broken down by element type
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file ElementProfile.h Accumulated event costs broken down by element type
+  \lgpl
+ */
+#ifndef ELEMENTPROFILE_H
+#define ELEMENTPROFILE_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Util.h"
+#include "Log2Histogram.h"
+
+namespace MFM
+{
+  /**
+   * Event counts and costs, per element type, summed over all the
+   * events a Tile performed while the profile was attached to it
+   * (see Tile::SetElementProfile, which also says when it is safe
+   * to read).
+   *
+   * Costs are in GetCycleCount() ticks.
+   */
+  struct ElementProfile
+  {
+    enum
+    {
+      SIZE = 251,               //< Entries; prime, and twice ElementTable's capacity
+      HISTOGRAM_BUCKETS = 24    //< Bucket b counts events costing [2**b, 2**(b+1)) ticks; the last is open-ended
+    };
+
+    typedef Log2Histogram<HISTOGRAM_BUCKETS> Histogram;
+
+    struct Entry
+    {
+      u32 m_type;
+      bool m_inUse;
+
+      /** Events whose behavior ran, including those that FAILed */
+      u64 m_events;
+
+      /** Events whose behavior FAILed, batched or not */
+      u64 m_behaviorFailures;
+
+      /** Events abandoned because EventWindow::AcquireAllLocks failed */
+      u64 m_lockFailures;
+
+      /** Total ticks spent in EventWindow::ExecuteBehavior */
+      u64 m_ticks;
+
+      /** Total atoms EventWindow::StoreToTile wrote back changed */
+      u64 m_sitesChanged;
+
+      Histogram m_histogram;
+
+      void Clear()
+      {
+        m_type = 0;
+        m_inUse = false;
+        m_events = 0;
+        m_behaviorFailures = 0;
+        m_lockFailures = 0;
+        m_ticks = 0;
+        m_sitesChanged = 0;
+        m_histogram.Clear();
+      }
+    };
+
+    Entry m_entries[SIZE];
+
+    ElementProfile()
+    {
+      Reset();
+    }
+
+    void Reset()
+    {
+      for (u32 i = 0; i < SIZE; ++i)
+      {
+        m_entries[i].Clear();
+      }
+    }
+
+    /**
+     * Get the entry for \c type, claiming one if \c type has none
+     * yet.  Returns 0 only if all SIZE entries are claimed by other
+     * types.
+     */
+    Entry * GetEntry(u32 type)
+    {
+      u32 slot = type % SIZE;
+      for (u32 probes = 0; probes < SIZE; ++probes)
+      {
+        Entry & e = m_entries[slot];
+        if (e.m_inUse && e.m_type == type)
+        {
+          return &e;
+        }
+        if (!e.m_inUse)
+        {
+          e.m_inUse = true;
+          e.m_type = type;
+          return &e;
+        }
+        slot = (slot + 1) % SIZE;
+      }
+      return 0;
+    }
+
+    /**
+     * Find the entry for \c type, if it has one
+     */
+    const Entry * FindEntry(u32 type) const
+    {
+      u32 slot = type % SIZE;
+      for (u32 probes = 0; probes < SIZE; ++probes)
+      {
+        const Entry & e = m_entries[slot];
+        if (!e.m_inUse)
+        {
+          return 0;
+        }
+        if (e.m_type == type)
+        {
+          return &e;
+        }
+        slot = (slot + 1) % SIZE;
+      }
+      return 0;
+    }
+
+    void RecordEvent(u32 type, u64 ticks, u32 sitesChanged, bool failed)
+    {
+      Entry * e = GetEntry(type);
+      if (!e)
+      {
+        return;
+      }
+      ++e->m_events;
+      if (failed)
+      {
+        ++e->m_behaviorFailures;
+      }
+      e->m_ticks += ticks;
+      e->m_sitesChanged += sitesChanged;
+      e->m_histogram.Record(ticks);
+    }
+
+    void RecordLockFailure(u32 type)
+    {
+      Entry * e = GetEntry(type);
+      if (e)
+      {
+        ++e->m_lockFailures;
+      }
+    }
+
+    void Add(const ElementProfile & other)
+    {
+      for (u32 i = 0; i < SIZE; ++i)
+      {
+        const Entry & o = other.m_entries[i];
+        if (!o.m_inUse)
+        {
+          continue;
+        }
+        Entry * e = GetEntry(o.m_type);
+        if (!e)
+        {
+          continue;
+        }
+        e->m_events += o.m_events;
+        e->m_behaviorFailures += o.m_behaviorFailures;
+        e->m_lockFailures += o.m_lockFailures;
+        e->m_ticks += o.m_ticks;
+        e->m_sitesChanged += o.m_sitesChanged;
+        e->m_histogram.Add(o.m_histogram);
+      }
+    }
+  };
+} /* namespace MFM */
+
+#endif /* ELEMENTPROFILE_H */
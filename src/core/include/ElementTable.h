@@ -155,6 +155,13 @@ namespace MFM
      */
     const Element<EC> * Lookup(const u8 * symbol) const;
 
+    /**
+     * Combine the Element::GetColorStateHash of every Element in this
+     * ElementTable, so it changes when an Element is registered or
+     * replaced, or any of them would color atoms differently.
+     */
+    u32 GetColorStateHash() const;
+
 #if 0 /* Now handled in eventwindow */
     /**
      * Executes the behavior method of the Element in the center of a
@@ -14,6 +14,20 @@ namespace MFM {
     return (s32) slot;
   }
 
+  template <class EC>
+  u32 ElementTable<EC>::GetColorStateHash() const
+  {
+    u32 hash = 0x811c9dc5;
+    for (u32 i = 0; i < SIZE; ++i)
+    {
+      const Element<EC> * elt = m_hash[i].m_element;
+      if (elt == 0) continue;
+      hash = (hash ^ (u32) (size_t) elt) * 0x01000193;  // FNV-1a, a word at a time
+      hash = (hash ^ elt->GetColorStateHash()) * 0x01000193;
+    }
+    return hash;
+  }
+
   template <class EC>
   u32 ElementTable<EC>::SlotFor(u32 elementType) const
   {
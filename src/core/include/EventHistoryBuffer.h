@@ -28,6 +28,7 @@
 #define EVENTHISTORYBUFFER_H
 
 #include "EventHistoryItem.h"
+#include "EventHistorySink.h"
 #include "Base.h"
 #include "Sense.h"
 #include "MDist.h"
@@ -78,6 +79,7 @@ namespace MFM
       , m_itemsInEvent(0)
       , m_makingEvent(false)
       , m_makingEventStart(0)
+      , m_sink(0)
     {
       MFM_API_ASSERT_NONNULL(buffer);
       MFM_API_ASSERT_ARG(m_bufferSize > 100); // ?? what is safe here, if we always want at least one event in the buffer??
@@ -196,6 +198,15 @@ namespace MFM
 
     void SetHistoryActive(bool active) { m_historyActive = active; }
 
+    /**
+       Also pass each recorded event to \c sink, or stop if \c sink
+       is null.  Only events recorded while history is active reach
+       the sink.  Call this only while the Tile is not running.
+     */
+    void SetSink(EventHistorySink * sink) { m_sink = sink; }
+
+    EventHistorySink * GetSink() const { return m_sink; }
+
     /**
        Adds all observable changes associated with \c ew and its tile.
        Used for local events.
@@ -219,9 +230,16 @@ namespace MFM
 
     u32 CountEventsInHistory() const ;
 
+    /**
+       Write the new (if \c toNewer) or old value recorded in \c di
+       into \c tile, for an event centered at \c ctr.
+     */
+    static void ApplyDelta(bool toNewer, const EventHistoryItem::DeltaItem & di, Tile<EC>& tile, const SPoint ctr) ;
+
   private:
 
-    void ApplyDelta(bool toNewer, EventHistoryItem::DeltaItem & di, Tile<EC>& tile, const SPoint ctr) ;
+    // Passes the just-completed event starting at startIndex to m_sink
+    void SendEventToSink(u32 startIndex) ;
 
     // Updates m_itemsInEvent
     void RecordAtomChanges(u32 siteInWindow, const T& oldAtom, const T& newAtom) ;
@@ -317,6 +335,7 @@ namespace MFM
     u32 m_itemsInEvent;
     bool m_makingEvent;  // true between AddEventStart and AddEventEnd
     u32 m_makingEventStart;  // index of start item of in-progress event
+    EventHistorySink * m_sink;  // Also gets each recorded event, if non-null
 
     u32 GetWrappedIndex(s32 index) const
     {
@@ -38,31 +38,70 @@ namespace MFM {
   }
 
   template <class EC>
-  void EventHistoryBuffer<EC>::ApplyDelta(bool toNewer, EventHistoryItem::DeltaItem & di, Tile<EC>& tile, const SPoint ctr)
+  void EventHistoryBuffer<EC>::ApplyDelta(bool toNewer, const EventHistoryItem::DeltaItem & di, Tile<EC>& tile, const SPoint ctr)
   {
     const MDist<R> & md = MDist<R>::get();
     u32 site = di.m_site;
+    u32 idx = di.m_word;
+    u32 val = toNewer ? di.m_newValue : di.m_oldValue;
     if (site < md.GetSiteCount())
     {
       const SPoint pt = md.GetPoint(site) + ctr;
       T& atom = *tile.GetWritableAtom(pt);
-      u32 idx = di.m_word;
-      u32 val = toNewer ? di.m_newValue : di.m_oldValue;
       atom.GetBits().Write(idx*32, 32, val);
     }
     else
     {
-      // base info
-      FAIL(INCOMPLETE_CODE);
+      // base info, which RecordBaseChanges took from the center site
+      Base<AC> & base = tile.GetSite(ctr).GetBase();
+      switch (site)
+      {
+      case BASE_ATOM:
+        base.GetBaseAtom().GetBits().Write(idx*32, 32, val);
+        break;
+      case BASE_PAINT:
+        base.SetPaint(val);
+        break;
+      case SITE_SENSORS:
+      {
+        SiteTouchSensor & sts = base.GetSensory().m_touchSensor;
+        if (idx == 0)
+        {
+          sts.m_touchType = (SiteTouchType) val;
+        }
+        else
+        {
+          const u32 shift = (idx - 1) * 32;
+          sts.m_lastTouchEventCount =
+            (sts.m_lastTouchEventCount & ~(((u64) U32_MAX) << shift)) | (((u64) val) << shift);
+        }
+        break;
+      }
+      default:
+        FAIL(ILLEGAL_ARGUMENT);
+      }
     }
     tile.NeedAtomRecount();
   }
 
+  template <class EC>
+  void EventHistoryBuffer<EC>::SendEventToSink(u32 startIndex)
+  {
+    const u32 count = m_historyBuffer[startIndex].GetHeaderItems() + 1;  // START too
+    const u32 unwrapped = MIN(count, m_bufferSize - startIndex);
+    m_sink->AppendItems(&m_historyBuffer[startIndex], unwrapped);
+    if (unwrapped < count)
+    {
+      m_sink->AppendItems(&m_historyBuffer[0], count - unwrapped);
+    }
+  }
+
   template <class EC>
   void EventHistoryBuffer<EC>::AddEventStart(const SPoint ctr) 
   {
     if (!m_historyActive) return;
     MFM_API_ASSERT_STATE(!m_makingEvent);
+    if (m_sink) m_sink->BeginEvent();
     EventHistoryItem & s = AllocateNextItem();
     m_makingEventStart = m_newestEventEnd; // well that's confusing
     s.MakeStart(ctr, ++m_eventsAdded);
@@ -96,6 +135,7 @@ namespace MFM {
       e.MakeEnd(s, m_itemsInEvent);
       m_cursor = (s32) m_newestEventEnd;
       s.mHeaderItem.m_count = m_itemsInEvent;  // Point start header back to us
+      if (m_sink) SendEventToSink(m_makingEventStart);
     }
     m_makingEvent = false;
   }
@@ -108,6 +148,8 @@ namespace MFM {
 
     SPoint ctr = ew.GetCenterInTile();
 
+    if (m_sink) m_sink->BeginEvent();
+
     EventHistoryItem & s = AllocateNextItem();
     s.MakeStart(ctr, ++m_eventsAdded);
     m_itemsInEvent = 0;
@@ -131,6 +173,7 @@ namespace MFM {
        e.MakeEnd(s, m_itemsInEvent);
        m_cursor = (s32) m_newestEventEnd;
        s.mHeaderItem.m_count = m_itemsInEvent;  // Point start header back to us
+       if (m_sink) SendEventToSink(GetWrappedIndex((s32) m_newestEventEnd - (s32) m_itemsInEvent));
      }
    }
 
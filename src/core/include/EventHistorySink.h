@@ -0,0 +1,75 @@
+/*                                              -*- mode:C++ -*-
+  EventHistorySink.h Receiver of completed event history records
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file EventHistorySink.h Receiver of completed event history records
+  \lgpl
+ */
+#ifndef EVENTHISTORYSINK_H
+#define EVENTHISTORYSINK_H
+
+#include "itype.h"
+#include "EventHistoryItem.h"
+
+namespace MFM
+{
+  /**
+     An EventHistorySink receives a copy of every event an
+     EventHistoryBuffer records (see EventHistoryBuffer::SetSink),
+     so history can outlive the buffer's ring.  BeginEvent and
+     AppendItems are called only by the thread advancing the buffer's
+     Tile; Paused and Resuming only while the Tile is not running.
+   */
+  class EventHistorySink
+  {
+  public:
+    virtual ~EventHistorySink() { }
+
+    /**
+       Called as the buffer starts recording an event, while the Tile
+       still reflects all previously recorded events and nothing of
+       this one.
+     */
+    virtual void BeginEvent() = 0;
+
+    /**
+       Called with the items of a recorded event, from its START to
+       its END item.  An event that wraps around the end of the
+       buffer's ring arrives in two calls.  Events that changed
+       nothing are not recorded and never arrive here.
+     */
+    virtual void AppendItems(const EventHistoryItem * items, u32 count) = 0;
+
+    /**
+       Called by the Grid once the Tile has stopped running.  Until
+       the matching Resuming, the Tile may be changed outside of any
+       event, by tools or by loading a configuration, say.
+     */
+    virtual void Paused() { }
+
+    /**
+       Called by the Grid just before the Tile runs again, including
+       the first time it runs.
+     */
+    virtual void Resuming() { }
+  };
+} /* namespace MFM */
+
+#endif /* EVENTHISTORYSINK_H */
@@ -0,0 +1,108 @@
+/*                                              -*- mode:C++ -*-
+  EventPhaseProfile.h Accumulated time spent in each phase of events
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file EventPhaseProfile.h Accumulated time spent in each phase of events
+  \lgpl
+ */
+#ifndef EVENTPHASEPROFILE_H
+#define EVENTPHASEPROFILE_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Util.h"
+
+namespace MFM
+{
+  /**
+   * Nanoseconds spent in each phase of event processing, summed over
+   * all the events a Tile performed while the profile was attached
+   * to it (see Tile::SetEventPhaseProfile, which also says when it
+   * is safe to read).
+   */
+  struct EventPhaseProfile
+  {
+    enum Phase
+    {
+      PHASE_LOCK,    //< EventWindow::AcquireAllLocks
+      PHASE_LOAD,    //< EventWindow::LoadFromTile
+      PHASE_BEHAVE,  //< EventWindow::ExecuteBehavior
+      PHASE_STORE,   //< EventWindow::StoreToTile
+      PHASE_SHIP,    //< CacheProcessor advancing in Tile::AdvanceCommunication
+      PHASE_COUNT
+    };
+
+    static const char * GetPhaseName(u32 phase)
+    {
+      switch (phase)
+      {
+      case PHASE_LOCK:   return "lock";
+      case PHASE_LOAD:   return "load";
+      case PHASE_BEHAVE: return "behave";
+      case PHASE_STORE:  return "store";
+      case PHASE_SHIP:   return "ship";
+      default: FAIL(ILLEGAL_ARGUMENT);
+      }
+    }
+
+    u64 m_nanos[PHASE_COUNT];
+
+    /**
+     * Events completed (not merely attempted) while profiling
+     */
+    u64 m_events;
+
+    EventPhaseProfile()
+    {
+      Reset();
+    }
+
+    void Reset()
+    {
+      for (u32 i = 0; i < PHASE_COUNT; ++i)
+      {
+        m_nanos[i] = 0;
+      }
+      m_events = 0;
+    }
+
+    void Add(const EventPhaseProfile & other)
+    {
+      for (u32 i = 0; i < PHASE_COUNT; ++i)
+      {
+        m_nanos[i] += other.m_nanos[i];
+      }
+      m_events += other.m_events;
+    }
+
+    /**
+     * Charge the time since \c startNanos to \c phase, and return the
+     * current time so consecutive phases can be chained.
+     */
+    u64 Charge(Phase phase, u64 startNanos)
+    {
+      u64 now = GetMonotonicNanos();
+      m_nanos[phase] += now - startNanos;
+      return now;
+    }
+  };
+} /* namespace MFM */
+
+#endif /* EVENTPHASEPROFILE_H */
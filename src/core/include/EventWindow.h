@@ -37,6 +37,9 @@
 #include "Base.h"
 #include "ByteSink.h"
 #include "BitStorage.h"
+#include "EventPhaseProfile.h"
+#include "ElementProfile.h"
+#include "SiteTypeMatch.h"
 
 namespace MFM
 {
@@ -97,6 +100,7 @@ namespace MFM
     enum { R = EC::EVENT_WINDOW_RADIUS };
   public:
     enum { SITE_COUNT = EVENT_WINDOW_SITES(R) };
+    enum { SITE_MASK_WORDS = (SITE_COUNT + 31) / 32 };  // u32s holding one bit per site
     enum {MAX_LOCK_DIRS = 3 };
     typedef Dir THREEDIR[MAX_LOCK_DIRS]; //copy of CacheProcessor.h
 
@@ -111,6 +115,10 @@ namespace MFM
     u64 m_eventWindowsAttempted;
     u64 m_eventWindowsExecuted;
     u64 m_eventWindowSitesAccessed; // Sum of within-boundary sites
+    u32 m_sitesChanged;  // Atoms changed by the last StoreToTile
+    u64 m_behaveStartNanos;  // For the EventPhaseProfile, if any
+    u64 m_behaveStartTicks;  // For the ElementProfile, if any
+    bool m_behaviorFailed;   // Since the last ExecuteEvent
 
     void RecordEventAtTileCoord(const SPoint tcoord) ;
 
@@ -123,6 +131,55 @@ namespace MFM
     AtomBitStorage<EC>  m_atomBuffer[SITE_COUNT];
     bool m_isLiveSite[SITE_COUNT];
 
+    /**
+     * Site-in-tile number offsets of each event window site (in
+     * MDist order, so every boundary is a prefix) from the center,
+     * given the width of m_tile.  Lets LoadFromTile and StoreToTile
+     * walk the window as flat offsets from the center's site number.
+     */
+    s32 m_siteNumberDeltas[SITE_COUNT];
+
+    /**
+     * One bit per event window site (in direct coordinates), set by
+     * anything that might have written that site of m_atomBuffer since
+     * LoadFromTile.  StoreToTile only compares and writes back the
+     * sites marked here.
+     */
+    enum { DIRTY_WORDS = SITE_MASK_WORDS };
+    u32 m_dirtySites[DIRTY_WORDS];
+
+    void MarkSiteDirty(u32 siteNumber)
+    {
+      m_dirtySites[siteNumber / 32] |= 1u << (siteNumber % 32);
+    }
+
+    bool IsSiteDirty(u32 siteNumber) const
+    {
+      return (m_dirtySites[siteNumber / 32] & (1u << (siteNumber % 32))) != 0;
+    }
+
+    void ClearDirtySites()
+    {
+      for (u32 i = 0; i < DIRTY_WORDS; m_dirtySites[i++] = 0);
+    }
+
+    /**
+     * The type of each site's atom in m_atomBuffer (in direct
+     * coordinates), packed for the type queries, padded with zeros to
+     * whole words of sites.  Filled by LoadFromTile; entries for sites
+     * marked dirty since are refreshed by SyncSiteTypes before each
+     * query.
+     */
+    mutable u16 m_siteTypes[SITE_MASK_WORDS * 32];
+
+    /**
+     * One bit per event window site (in direct coordinates), set for
+     * live sites within the current boundary by LoadFromTile.
+     */
+    u32 m_liveSites[SITE_MASK_WORDS];
+
+    void SyncSiteTypes() const ;
+
     Base<AC> m_centerBase;
 
     SPoint m_center;
@@ -133,6 +190,12 @@ namespace MFM
 
     PointSymmetry m_sym;
 
+    /**
+     * MDist<R>::GetSymPermutation(m_sym), so the Sym accessors map
+     * site numbers by one table lookup rather than through points.
+     */
+    const u8 * m_symSiteNum;
+
     bool AcquireAllLocks(const SPoint& centerSite, const u32 eventWindowBoundary) ;
 
     bool AcquireRegionLocks(const u32 neededArg, const THREEDIR& lockRegionsArg);
@@ -193,8 +256,23 @@ namespace MFM
 
     void ExecuteBehavior() ;
 
+    /**
+     * Log a failure of the current behavior, with its backtrace, and
+     * erase the center atom.
+     */
+    void RecoverFromBehaviorFailure(int failCode, const char * failFile, unsigned lineno,
+                                    void * const * backtraceArray, unsigned backtraceSize) ;
+
     void InitiateCommunications() ;
 
+    /**
+     * Everything in ExecuteEvent after ExecuteBehavior: store the
+     * window back to the tile, and charge the event to the tile's
+     * profiles, if any.  Tile::RecoverBatchFailure uses this to
+     * finish an event whose behavior failed.
+     */
+    void FinishEvent() ;
+
     void LoadFromTile() ;
 
     void StoreToTile() ;
@@ -253,7 +331,7 @@ namespace MFM
      */
     bool InitForEvent(const SPoint & center) ;
 
-    const Site<AC> & GetSite() const
+    const S & GetSite() const
     {
       return GetTile().GetSite(m_center);
     }
@@ -364,8 +442,10 @@ namespace MFM
      */
     u32 MapIndexToIndexSymValid(const u32 siteNumber) const
     {
-      SPoint sym = MapToPointSymValid(siteNumber);
-      return MapToIndexDirectValid(sym);
+      MFM_API_ASSERT_ARG(siteNumber < SITE_COUNT);
+      const u32 symSiteNumber = m_symSiteNum[siteNumber];
+      MFM_API_ASSERT_ARG(symSiteNumber < m_boundedSiteCount);
+      return symSiteNumber;
     }
 
     /**
@@ -399,6 +479,7 @@ namespace MFM
     void SetSymmetry(const PointSymmetry psym)
     {
       m_sym = psym;
+      m_symSiteNum = MDist<R>::get().GetSymPermutation(psym);
     }
 
     /**
@@ -484,6 +565,41 @@ namespace MFM
       return m_isLiveSite[MapIndexToIndexSymValid(siteNumber)];
     }
 
+    /**
+     * Set bit i of \c matches (bit i % 32 of word i / 32) for each
+     * live site number i, in direct coordinates, within \c radius of
+     * the center but not the center itself, whose atom is of type \c
+     * type, and return how many there are.  Sites beyond the current
+     * boundary are never marked.  FAILs ILLEGAL_ARGUMENT unless 0 <
+     * \c radius <= R.
+     */
+    u32 GetSitesOfType(const u32 type, const u32 radius, u32 (&matches)[SITE_MASK_WORDS]) const ;
+
+    /**
+     * Count the sites GetSitesOfType would mark.
+     */
+    u32 CountSitesOfType(const u32 type, const u32 radius) const
+    {
+      u32 matches[SITE_MASK_WORDS];
+      return GetSitesOfType(type, radius, matches);
+    }
+
+    /**
+     * Return true if GetSitesOfType would mark any site.
+     */
+    bool HasSiteOfType(const u32 type, const u32 radius) const
+    {
+      return CountSitesOfType(type, radius) > 0;
+    }
+
+    /**
+     * Choose one of the sites GetSitesOfType would mark, uniformly at
+     * random, and set \c siteNumber to its direct site number.
+     * Returns how many sites there were to choose from; \c siteNumber
+     * is unchanged if that is 0.
+     */
+    u32 PickSiteOfType(const u32 type, const u32 radius, u32 & siteNumber) ;
+
     /**
      * Constructs a new EventWindow which takes place on a specified
      * Tile with the default PointSymmetry of PSYM_NORMAL .
@@ -527,7 +643,9 @@ namespace MFM
      */
     AtomBitStorage<EC>& GetAtomBitStorage(u32 siteNumber)
     {
-      return m_atomBuffer[MapIndexToIndexSymValid(siteNumber)];
+      u32 idx = MapIndexToIndexSymValid(siteNumber);
+      MarkSiteDirty(idx);  // Caller may write through the reference
+      return m_atomBuffer[idx];
     }
 
     /**
@@ -536,6 +654,7 @@ namespace MFM
      */
     AtomBitStorage<EC>& GetCenterAtomBitStorage()
     {
+      MarkSiteDirty(0);  // Caller may write through the reference
       return m_atomBuffer[0];
     }
 
@@ -591,6 +710,7 @@ namespace MFM
     void SetAtomDirect(u32 siteNumber, const T & newAtom)
     {
       MFM_API_ASSERT_ARG(siteNumber < SITE_COUNT);
+      MarkSiteDirty(siteNumber);
       m_atomBuffer[siteNumber].WriteAtom(newAtom);
     }
 
@@ -600,7 +720,9 @@ namespace MFM
      */
     void SetAtomSym(u32 siteNumber, const T & newAtom)
     {
-      m_atomBuffer[MapIndexToIndexSymValid(siteNumber)].WriteAtom(newAtom);
+      u32 idx = MapIndexToIndexSymValid(siteNumber);
+      MarkSiteDirty(idx);
+      m_atomBuffer[idx].WriteAtom(newAtom);
     }
 
     /**
@@ -612,6 +734,7 @@ namespace MFM
      */
     void SetCenterAtomDirect(const T& atom)
     {
+      MarkSiteDirty(0);
       m_atomBuffer[0].WriteAtom(atom);
     }
 
@@ -625,6 +748,7 @@ namespace MFM
      */
     void SetCenterAtomSym(const T& atom)
     {
+      MarkSiteDirty(0);
       m_atomBuffer[0].WriteAtom(atom);
     }
 
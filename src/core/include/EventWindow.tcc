@@ -104,9 +104,51 @@ namespace MFM {
     MFM_LOG_DBG6(("EW::ExecuteEvent %s", GetTile().GetLabel()));
     MFM_API_ASSERT_STATE(m_ewState == COMPUTE);
 
+    EventPhaseProfile * profile = GetTile().GetEventPhaseProfile();
+    ElementProfile * elementProfile = GetTile().GetElementProfile();
+    if (!profile && !elementProfile)
+    {
+      ExecuteBehavior();
+      InitiateCommunications();
+      return;
+    }
+
+    // Members, not locals, so FinishEvent can use them after a
+    // batched behavior failure
+    m_behaveStartNanos = profile ? GetMonotonicNanos() : 0;
+    m_behaveStartTicks = elementProfile ? GetCycleCount() : 0;
+    m_behaviorFailed = false;
     ExecuteBehavior();
+    FinishEvent();
+  }
+
+  template <class EC>
+  void EventWindow<EC>::FinishEvent()
+  {
+    EventPhaseProfile * profile = GetTile().GetEventPhaseProfile();
+    ElementProfile * elementProfile = GetTile().GetElementProfile();
+    if (!profile && !elementProfile)
+    {
+      InitiateCommunications();
+      return;
+    }
 
+    const u64 ticks = elementProfile ? GetCycleCount() - m_behaveStartTicks : 0;
+    u64 nanos = 0;
+    if (profile)
+    {
+      nanos = profile->Charge(EventPhaseProfile::PHASE_BEHAVE, m_behaveStartNanos);
+    }
     InitiateCommunications();
+    if (profile)
+    {
+      profile->Charge(EventPhaseProfile::PHASE_STORE, nanos);
+      ++profile->m_events;
+    }
+    if (elementProfile)
+    {
+      elementProfile->RecordEvent(m_element->GetType(), ticks, m_sitesChanged, m_behaviorFailed);
+    }
   }
 
   template <class EC>
@@ -138,50 +180,23 @@ namespace MFM {
 
     MFM_LOG_DBG6(("EW::ExecuteBehavior %s",t.GetLabel()));
 
-    unwind_protect(
+    if (t.IsUnwindBatched())
     {
-      OString256 buff;
-      PrintEventSite(buff);
-      buff.Printf(":");
-
-      const char * failFile = MFMThrownFromFile;
-      const unsigned lineno = MFMThrownFromLineNo;
-      const char * failMsg = MFMFailCodeReason(MFMThrownFailCode);
-      if(!GetCenterAtomDirect().IsSane())
-      {
-        MFM_LOG_DBG4(("%s FE(INSANE)",buff.GetZString()));
-      }
-      else if (failMsg)
-      {
-        MFM_LOG_DBG3(("%s behave() failed at %s:%d: %s (site type 0x%04x)",
-		      buff.GetZString(),
-		      failFile,
-		      lineno,
-		      failMsg,
-		      GetCenterAtomDirect().GetType()));
-      }
-      else
-      {
-        MFM_LOG_DBG3(("%s behave() failed at %s:%d: fail(%d/0x%08x) (site type 0x%04x)",
-		      buff.GetZString(),
-		      failFile,
-		      lineno,
-		      MFMThrownFailCode,
-		      MFMThrownFailCode,
-		      GetCenterAtomDirect().GetType()));
-      }
-      {
-        OverflowableCharBufferByteSink<4096 + 2> bt;
-        char ** strings = backtrace_symbols (MFMThrownBacktraceArray, MFMThrownBacktraceSize);
-
-        for (u32 i = 0; i < MFMThrownBacktraceSize; i++)
-          bt.Printf("%s\n", strings[i]);
-        free (strings);
-
-        LOG.Message("BACKTRACE %s",bt.GetZString());
-      }
+      // Our caller's unwind_protect covers this; see Tile::RecoverBatchFailure
+      t.SetUnwindPhase(Tile<EC>::UNWIND_BEHAVING);
+      MFM_LOG_DBG6(("ET::Execute %s",t.GetLabel()));
+      m_element->Behavior(*this);
+      t.SetUnwindPhase(Tile<EC>::UNWIND_OTHER);
+      return;
+    }
 
-      SetCenterAtomDirect(t.GetEmptyAtom());
+    unwind_protect(
+    {
+      RecoverFromBehaviorFailure(MFMThrownFailCode,
+                                 MFMThrownFromFile,
+                                 MFMThrownFromLineNo,
+                                 MFMThrownBacktraceArray,
+                                 MFMThrownBacktraceSize);
     },
     {
       MFM_LOG_DBG6(("ET::Execute %s",t.GetLabel()));
@@ -189,6 +204,54 @@ namespace MFM {
     });
   }
 
+  template <class EC>
+  void EventWindow<EC>::RecoverFromBehaviorFailure(int failCode, const char * failFile, unsigned lineno,
+                                                   void * const * backtraceArray, unsigned backtraceSize)
+  {
+    Tile<EC> & t = GetTile();
+    m_behaviorFailed = true;
+    OString256 buff;
+    PrintEventSite(buff);
+    buff.Printf(":");
+
+    const char * failMsg = MFMFailCodeReason(failCode);
+    if(!GetCenterAtomDirect().IsSane())
+    {
+      MFM_LOG_DBG4(("%s FE(INSANE)",buff.GetZString()));
+    }
+    else if (failMsg)
+    {
+      MFM_LOG_DBG3(("%s behave() failed at %s:%d: %s (site type 0x%04x)",
+		    buff.GetZString(),
+		    failFile,
+		    lineno,
+		    failMsg,
+		    GetCenterAtomDirect().GetType()));
+    }
+    else
+    {
+      MFM_LOG_DBG3(("%s behave() failed at %s:%d: fail(%d/0x%08x) (site type 0x%04x)",
+		    buff.GetZString(),
+		    failFile,
+		    lineno,
+		    failCode,
+		    failCode,
+		    GetCenterAtomDirect().GetType()));
+    }
+    {
+      OverflowableCharBufferByteSink<4096 + 2> bt;
+      char ** strings = backtrace_symbols (backtraceArray, backtraceSize);
+
+      for (u32 i = 0; i < backtraceSize; i++)
+        bt.Printf("%s\n", strings[i]);
+      free (strings);
+
+      LOG.Message("BACKTRACE %s",bt.GetZString());
+    }
+
+    SetCenterAtomDirect(t.GetEmptyAtom());
+  }
+
   template <class EC>
   void EventWindow<EC>::Diffuse()
   {
@@ -282,8 +345,22 @@ namespace MFM {
 
     SetBoundary(m_element->GetEventWindowBoundary());
 
-    if (!AcquireAllLocks(center, m_eventWindowBoundary))
+    EventPhaseProfile * profile = tile.GetEventPhaseProfile();
+    u64 nanos = profile ? GetMonotonicNanos() : 0;
+
+    bool locked = AcquireAllLocks(center, m_eventWindowBoundary);
+    if (profile)
     {
+      nanos = profile->Charge(EventPhaseProfile::PHASE_LOCK, nanos);
+    }
+
+    if (!locked)
+    {
+      ElementProfile * elementProfile = tile.GetElementProfile();
+      if (elementProfile)
+      {
+        elementProfile->RecordLockFailure(type);
+      }
       MFM_LOG_DBG6(("EW::InitForEvent (%d,%d) %s - abandoned",
 		    center.GetX(),center.GetY(),
 		    tile.GetLabel()));
@@ -293,9 +370,13 @@ namespace MFM {
     m_eventWindowSitesAccessed += m_boundedSiteCount;
     m_center = center;
     m_ewState = COMPUTE;
-    m_sym = PSYM_NORMAL;
+    SetSymmetry(PSYM_NORMAL);
 
     LoadFromTile();
+    if (profile)
+    {
+      profile->Charge(EventPhaseProfile::PHASE_LOAD, nanos);
+    }
     return true;
   }
 
@@ -326,6 +407,10 @@ namespace MFM {
       MFM_LOG_DBG6(("EW::AcquireRegionLocks %s - fail: %s cp not idle",
 		    ewtile.GetLabel(),
                     Dirs::GetName(dir)));
+      if (ewtile.GetCacheProfile())
+      {
+        ewtile.GetCacheProfile()->RecordStall(dir, CacheProfile::STALL_BUSY);
+      }
       return LOCK_UNAVAILABLE;
     }
 
@@ -335,6 +420,10 @@ namespace MFM {
       MFM_LOG_DBG6(("EW::AcquireRegionLocks %s - fail: didn't get %s lock",
 		    ewtile.GetLabel(),
                     Dirs::GetName(dir)));
+      if (ewtile.GetCacheProfile())
+      {
+        ewtile.GetCacheProfile()->RecordStall(dir, CacheProfile::STALL_CONTENDED);
+      }
       return LOCK_UNAVAILABLE;
     }
     MFM_LOG_DBG6(("EW::AcquireRegionLocks %s, %s got lock"
@@ -500,13 +589,30 @@ namespace MFM {
     , m_eventWindowsAttempted(0)
     , m_eventWindowsExecuted(0)
     , m_eventWindowSitesAccessed(0)
+    , m_sitesChanged(0)
+    , m_behaveStartNanos(0)
+    , m_behaveStartTicks(0)
+    , m_behaviorFailed(false)
     , m_center(0,0)
     , m_sym(PSYM_NORMAL)
+    , m_symSiteNum(MDist<R>::get().GetSymPermutation(PSYM_NORMAL))
     , m_ewState(FREE)
   {
     m_cpli.Shuffle(GetRandom());
 
     for (u32 i = 0; i < SITE_COUNT; m_isLiveSite[i++] = false);
+    for (u32 i = 0; i < SITE_MASK_WORDS * 32; m_siteTypes[i++] = 0);
+    for (u32 i = 0; i < SITE_MASK_WORDS; m_liveSites[i++] = 0);
+
+    ClearDirtySites();
+
+    const MDist<R> & md = MDist<R>::get();
+    const s32 width = (s32) tile.TILE_WIDTH;
+    for (u32 i = 0; i < SITE_COUNT; ++i)
+    {
+      const SPoint & pt = md.GetPoint(i);
+      m_siteNumberDeltas[i] = pt.GetY() * width + pt.GetX();
+    }
 
     for (u32 i = 0; i < MAX_CACHES_TO_UPDATE; m_cacheProcessorsLocked[i++] = 0);
 
@@ -522,7 +628,10 @@ namespace MFM {
   template <class EC>
   u32 EventWindow<EC>::MapToIndexSymValid(const SPoint & loc) const
   {
-    return MapToIndexDirectValid(SymMap(loc, m_sym, SPoint(2*R, 2*R)));
+    const MDist<R> & md = MDist<R>::get();
+    s32 index = md.FromPoint(loc,R);
+    MFM_API_ASSERT_ARG(index >= 0);
+    return MapIndexToIndexSymValid((u32) index);
   }
 
   template <class EC>
@@ -539,15 +648,99 @@ namespace MFM {
   {
     Tile<EC> & tile = GetTile();
 
-    m_centerBase = tile.GetSite(m_center).GetBase();
-    const MDist<R> & md = MDist<R>::get();
+    const u32 centerNumber = tile.GetSiteInTileNumber(m_center);
+    m_centerBase = tile.GetSiteByNumber(centerNumber).GetBase();
+    for (u32 i = 0; i < m_boundedSiteCount; ++i)
+    {
+      const u32 siteNumber = centerNumber + m_siteNumberDeltas[i];
+      m_atomBuffer[i].WriteAtom(tile.GetAtomForEventWindow(siteNumber));
+      m_isLiveSite[i] = tile.IsLiveSite(siteNumber);
+    }
+    for (u32 w = 0; w < SITE_MASK_WORDS; ++w)
+    {
+      m_liveSites[w] = 0;
+    }
     for (u32 i = 0; i < m_boundedSiteCount; ++i)
     {
-      const SPoint & pt = md.GetPoint(i) + m_center;
-      //m_atomBuffer[i] = tile.GetAtomForEventWindow(pt);
-      m_atomBuffer[i].WriteAtom(tile.GetAtomForEventWindow(pt));
-      m_isLiveSite[i] = tile.IsLiveSite(pt);
+      m_siteTypes[i] = (u16) m_atomBuffer[i].GetAtom().GetType();
+      m_liveSites[i / 32] |= ((u32) m_isLiveSite[i]) << (i % 32);
     }
+    ClearDirtySites();
+  }
+
+  template <class EC>
+  void EventWindow<EC>::SyncSiteTypes() const
+  {
+    for (u32 w = 0; w < DIRTY_WORDS; ++w)
+    {
+      for (u32 bits = m_dirtySites[w]; bits != 0; bits &= bits - 1)
+      {
+        const u32 i = w * 32 + __builtin_ctz(bits);
+        m_siteTypes[i] = (u16) m_atomBuffer[i].GetAtom().GetType();
+      }
+    }
+  }
+
+  template <class EC>
+  u32 EventWindow<EC>::GetSitesOfType(const u32 type, const u32 radius,
+                                      u32 (&matches)[SITE_MASK_WORDS]) const
+  {
+    const MDist<R> & md = MDist<R>::get();
+    MFM_API_ASSERT_ARG(radius != 0 && radius <= R);
+    const u32 last = md.GetLastIndex(radius);
+
+    SyncSiteTypes();
+
+    // Sites within radius are the MDist prefix 0..last; skip the
+    // center.  m_liveSites is clear beyond the current boundary.
+    u32 count = 0;
+    for (u32 w = 0; w < SITE_MASK_WORDS; ++w)
+    {
+      const u32 first = w * 32;
+      u32 inRange = 0;
+      if (first <= last)
+      {
+        const u32 span = last - first + 1;
+        inRange = span >= 32 ? 0xffffffff : (1u << span) - 1;
+      }
+      if (w == 0)
+      {
+        inRange &= ~1u;
+      }
+      matches[w] = MatchSiteTypes32(&m_siteTypes[first], (u16) type) & m_liveSites[w] & inRange;
+      count += __builtin_popcount(matches[w]);
+    }
+    return count;
+  }
+
+  template <class EC>
+  u32 EventWindow<EC>::PickSiteOfType(const u32 type, const u32 radius, u32 & siteNumber)
+  {
+    u32 matches[SITE_MASK_WORDS];
+    const u32 count = GetSitesOfType(type, radius, matches);
+    if (count == 0)
+    {
+      return 0;
+    }
+
+    u32 pick = GetRandom().Create(count);
+    for (u32 w = 0; w < SITE_MASK_WORDS; ++w)
+    {
+      u32 bits = matches[w];
+      const u32 here = __builtin_popcount(bits);
+      if (pick >= here)
+      {
+        pick -= here;
+        continue;
+      }
+      while (pick-- > 0)
+      {
+        bits &= bits - 1;  // Drop the lowest match
+      }
+      siteNumber = w * 32 + __builtin_ctz(bits);
+      break;
+    }
+    return count;
   }
 
   template <class EC>
@@ -579,31 +772,39 @@ namespace MFM {
     ehb.AddEventWindow(*this);
 
     // Write back base changes if any
-    tile.GetSite(m_center).GetBase() = m_centerBase;
+    const u32 centerNumber = tile.GetSiteInTileNumber(m_center);
+    tile.GetSiteByNumber(centerNumber).GetBase() = m_centerBase;
 
+    m_sitesChanged = 0;
     for (u32 i = 0; i < m_boundedSiteCount; ++i)
     {
-      const SPoint & pt = md.GetPoint(i) + m_center;
+      if (!m_isLiveSite[i])
+      {
+        continue;
+      }
+
+      const u32 siteNumber = centerNumber + m_siteNumberDeltas[i];
+      const T & tileAtom = tile.GetAtomByNumber(siteNumber);
       bool dirty = false;
-      if (m_isLiveSite[i])
+
+      // Sites nobody wrote since LoadFromTile still match the tile
+      if (IsSiteDirty(i) && m_atomBuffer[i].GetAtom() != tileAtom)
       {
-        //if (m_atomBuffer[i] != *tile.GetAtom(pt))
-	if (m_atomBuffer[i].GetAtom() != *tile.GetAtom(pt))
-        {
-          tile.PlaceAtom(m_atomBuffer[i].GetAtom(), pt);
-          dirty = true;
-        }
+        tile.PlaceAtom(m_atomBuffer[i].GetAtom(), md.GetPoint(i) + m_center);
+        dirty = true;
+        ++m_sitesChanged;
+      }
 
-        // Let the CPs see even some unchanged atoms, for spot checks
-        for (u32 j = 0; j < MAX_CACHES_TO_UPDATE; ++j)
+      // Let the CPs see even some unchanged atoms, for spot checks
+      for (u32 j = 0; j < MAX_CACHES_TO_UPDATE; ++j)
+      {
+        if (m_cacheProcessorsLocked[j] != 0)
         {
-          if (m_cacheProcessorsLocked[j] != 0)
-          {
-            m_cacheProcessorsLocked[j]->MaybeSendAtom( *tile.GetAtom(pt), dirty, i);
-          }
+          m_cacheProcessorsLocked[j]->MaybeSendAtom(tileAtom, dirty, i);
         }
       }
     }
+    ClearDirtySites();
 
     MFM_LOG_DBG6(("EW::StoreToTile releasing %s",tile.GetLabel()));
     // Finally, release the cache processors to take it from here
@@ -627,6 +828,7 @@ namespace MFM {
     if (m_isLiveSite[idx])
     {
       //m_atomBuffer[idx] = atom;
+      MarkSiteDirty(idx);
       m_atomBuffer[idx].WriteAtom(atom); //a copy
       return true;
     }
@@ -641,6 +843,7 @@ namespace MFM {
     if (m_isLiveSite[idx])
     {
       //m_atomBuffer[idx] = atom;
+      MarkSiteDirty(idx);
       m_atomBuffer[idx].WriteAtom(atom);
       return true;
     }
@@ -694,6 +897,9 @@ namespace MFM {
     MFM_API_ASSERT_ARG(idxa < m_boundedSiteCount);
     MFM_API_ASSERT_ARG(idxb < m_boundedSiteCount);
 
+    MarkSiteDirty(idxa);
+    MarkSiteDirty(idxb);
+
     T tmp = m_atomBuffer[idxa].GetAtom();
     //m_atomBuffer[idxa] = m_atomBuffer[idxb];
     //m_atomBuffer[idxb] = tmp;
@@ -0,0 +1,88 @@
+/*                                              -*- mode:C++ -*-
+  Log2Histogram.h Counts of values binned by their power of two
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file Log2Histogram.h Counts of values binned by their power of two
+  \lgpl
+ */
+#ifndef LOG2HISTOGRAM_H
+#define LOG2HISTOGRAM_H
+
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  /**
+   * A histogram of u64 values in which bucket b counts the values in
+   * [2**b, 2**(b+1)), except that bucket 0 also counts 0 and the last
+   * bucket also counts everything larger.
+   */
+  template <u32 BUCKETS>
+  struct Log2Histogram
+  {
+    enum { BUCKET_COUNT = BUCKETS };
+
+    u64 m_counts[BUCKETS];
+
+    Log2Histogram()
+    {
+      Clear();
+    }
+
+    void Clear()
+    {
+      for (u32 i = 0; i < BUCKETS; ++i)
+      {
+        m_counts[i] = 0;
+      }
+    }
+
+    static u32 GetBucket(u64 value)
+    {
+      const u32 high = (u32) (value >> 32);
+      const u32 log2 = high ?
+        63 - __builtin_clz(high) :
+        31 - __builtin_clz(((u32) value) | 1);
+      return log2 < BUCKETS ? log2 : BUCKETS - 1;
+    }
+
+    void Record(u64 value)
+    {
+      ++m_counts[GetBucket(value)];
+    }
+
+    u64 GetCount(u32 bucket) const
+    {
+      MFM_API_ASSERT_ARG(bucket < BUCKETS);
+      return m_counts[bucket];
+    }
+
+    void Add(const Log2Histogram & other)
+    {
+      for (u32 i = 0; i < BUCKETS; ++i)
+      {
+        m_counts[i] += other.m_counts[i];
+      }
+    }
+  };
+} /* namespace MFM */
+
+#endif /* LOG2HISTOGRAM_H */
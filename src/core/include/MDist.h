@@ -34,6 +34,7 @@
 #include "Point.h"
 #include "Random.h"
 #include "Dirs.h"
+#include "PSym.h"
 
 namespace MFM
 {
@@ -217,6 +218,41 @@ namespace MFM
       return m_siteNumToRaster[sitenum];
     }
 
+    /**
+       Get the site number that \c siteNumber moves to under the
+       point symmetry \c psym.  Equivalent to mapping GetPoint(siteNumber)
+       through SymMap and back through GetSiteNumber, but by table
+       lookup.  Point symmetries preserve Manhattan distance, so the
+       result is in the same ring as \c siteNumber.
+
+       \fails ILLEGAL_ARGUMENT if siteNumber is greater than or equal
+       to ARRAY_LENGTH, or psym is not a legal PointSymmetry
+
+       \sa GetSymPermutation
+     */
+    u32 GetSymSiteNumber(const u32 siteNumber, const PointSymmetry psym) const
+    {
+      MFM_API_ASSERT_ARG(siteNumber < ARRAY_LENGTH);
+      MFM_API_ASSERT_ARG(psym < PSYM_SYMMETRY_COUNT);
+      return m_symSiteNum[psym][siteNumber];
+    }
+
+    /**
+       Get the whole ARRAY_LENGTH site number permutation for \c psym,
+       for callers that map many site numbers through one symmetry.
+       If psym is not a legal PointSymmetry, every entry of the
+       returned table is ARRAY_LENGTH, so a caller that range checks
+       its results will reject them.
+
+       \sa GetSymSiteNumber
+     */
+    const u8 * GetSymPermutation(const PointSymmetry psym) const
+    {
+      if (psym >= PSYM_SYMMETRY_COUNT)
+        return m_symSiteNum[PSYM_SYMMETRY_COUNT];
+      return m_symSiteNum[psym];
+    }
+
     /**
      * Return the coding of offset as a bond if possible.  Returns -1 if
      * the given offset cannot be expressed as a max length radius bond.
@@ -260,6 +296,9 @@ namespace MFM
     void InitHorizonsByDirTable();
     u8 m_horizonsByDirection[Dirs::DIR_COUNT][ARRAY_LENGTH];
 
+    void InitSymTables();
+    u8 m_symSiteNum[PSYM_SYMMETRY_COUNT + 1][ARRAY_LENGTH]; // last row for illegal psyms
+
   };
 
   template <u32 R>
@@ -64,6 +64,23 @@ namespace MFM {
     InitHorizonsByDirTable();
     InitRasterTables();
     InitESLTables();
+    InitSymTables();
+  }
+
+  template<u32 R>
+  void MDist<R>::InitSymTables()
+  {
+    for (u32 i = 0; i < ARRAY_LENGTH; ++i)
+    {
+      const SPoint & direct = GetPoint(i);
+      for (u32 psym = 0; psym < PSYM_SYMMETRY_COUNT; ++psym)
+      {
+        s32 sn = GetSiteNumber(SymMap(direct, (PointSymmetry) psym, direct));
+        MFM_API_ASSERT_STATE(sn >= 0);
+        m_symSiteNum[psym][i] = (u8) sn;
+      }
+      m_symSiteNum[PSYM_SYMMETRY_COUNT][i] = ARRAY_LENGTH;
+    }
   }
 
   template<u32 R>
@@ -29,7 +29,8 @@
 #define MUTEX_H
 
 #include <pthread.h>  /* for pthread_mutex_t etc */
-#include <errno.h>    /* for EBUSY */
+#include <errno.h>    /* for EBUSY, ETIMEDOUT */
+#include <time.h>     /* for struct timespec, clock_gettime */
 #include "itype.h"
 #include "Fail.h"
 
@@ -76,6 +77,28 @@ namespace MFM
       m_locked = true;
     }
 
+    /**
+     * Like CondWait, but give up at \c deadline (on the
+     * CLOCK_MONOTONIC clock).  Returns false if the wait timed out.
+     * Since a timed out waiter gets the lock back without anyone
+     * else having taken it, the lock is marked released for the
+     * duration of the wait.
+     */
+    bool CondTimedWait(pthread_cond_t & condvar, const timespec & deadline)
+    {
+      m_locked = false;
+      m_threadId = 0;
+
+      int status = pthread_cond_timedwait(&condvar, &m_lock, &deadline);
+      MFM_API_ASSERT(status == 0 || status == ETIMEDOUT, LOCK_FAILURE);
+
+      MFM_API_ASSERT(!m_locked, LOCK_FAILURE);
+
+      m_threadId = pthread_self();
+      m_locked = true;
+      return status == 0;
+    }
+
    public:
 
     class ScopeLock
@@ -147,6 +170,89 @@ namespace MFM
       }
     };
 
+    /**
+     * A condition variable for waits, possibly by several threads and
+     * possibly bounded in time, on state guarded by a Mutex.  Unlike
+     * Predicate, a Condition knows nothing about what is being waited
+     * for: callers re-check their own state, under the lock, around
+     * every Wait or WaitUsec, since both may return spuriously.
+     */
+    class Condition
+    {
+     private:
+      Mutex & m_mutex;
+      pthread_cond_t m_condvar;
+
+      Condition() ; // Declare away
+      Condition(const Condition &) ; // Declare away
+      Condition & operator=(const Condition &) ; // Declare away
+    public:
+
+      Condition(Mutex & mutex) : m_mutex(mutex)
+      {
+        pthread_condattr_t attr;
+        MFM_API_ASSERT(!pthread_condattr_init(&attr), LOCK_FAILURE);
+        MFM_API_ASSERT(!pthread_condattr_setclock(&attr, CLOCK_MONOTONIC), LOCK_FAILURE);
+        MFM_API_ASSERT(!pthread_cond_init(&m_condvar, &attr), LOCK_FAILURE);
+        MFM_API_ASSERT(!pthread_condattr_destroy(&attr), LOCK_FAILURE);
+      }
+
+      ~Condition()
+      {
+        MFM_API_ASSERT(!pthread_cond_destroy(&m_condvar), LOCK_FAILURE);
+      }
+
+      /**
+       * Release the mutex, which the caller must hold, until signaled.
+       */
+      void Wait()
+      {
+        m_mutex.AssertIHoldTheLock();
+        m_mutex.m_locked = false;
+        m_mutex.m_threadId = 0;
+        m_mutex.CondWait(m_condvar);
+      }
+
+      /**
+       * Release the mutex, which the caller must hold, until signaled
+       * or until \c usec microseconds have passed.  Returns false if
+       * the wait timed out.
+       */
+      bool WaitUsec(u32 usec)
+      {
+        m_mutex.AssertIHoldTheLock();
+
+        timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += usec / 1000000;
+        deadline.tv_nsec += (usec % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+          deadline.tv_nsec -= 1000000000;
+          ++deadline.tv_sec;
+        }
+        return m_mutex.CondTimedWait(m_condvar, deadline);
+      }
+
+      /**
+       * Wake one waiter, if any.  The caller must hold the mutex.
+       */
+      void Signal()
+      {
+        m_mutex.AssertIHoldTheLock();
+        MFM_API_ASSERT(!pthread_cond_signal(&m_condvar), LOCK_FAILURE);
+      }
+
+      /**
+       * Wake all waiters, if any.  The caller must hold the mutex.
+       */
+      void Broadcast()
+      {
+        m_mutex.AssertIHoldTheLock();
+        MFM_API_ASSERT(!pthread_cond_broadcast(&m_condvar), LOCK_FAILURE);
+      }
+    };
+
     /**
      * Create a new unlocked Mutex
      *
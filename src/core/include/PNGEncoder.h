@@ -0,0 +1,79 @@
+/*                                              -*- mode:C++ -*-
+  PNGEncoder.h Dependency-free PNG image writer
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file PNGEncoder.h Dependency-free PNG image writer
+  \lgpl
+ */
+#ifndef PNGENCODER_H
+#define PNGENCODER_H
+
+#include "itype.h"
+#include "ByteSink.h"
+
+namespace MFM
+{
+  /**
+   * Writes 8-bit RGB PNG images without zlib or any other library,
+   * so images can be made by headless builds.  Rows are Sub-filtered
+   * and deflated with the fixed Huffman codes, matching only runs of
+   * repeated bytes.  That is fast and compresses the large uniform
+   * regions typical of grid images well, though general-purpose
+   * encoders will do better on busy images.
+   */
+  class PNGEncoder
+  {
+  public:
+    /**
+     * Write a \c width by \c height PNG of the ARGB pixels \c argb,
+     * in row-major order, to \c sink.  Alpha is ignored.
+     */
+    static void WriteRGB(ByteSink & sink, const u32 * argb, u32 width, u32 height) ;
+
+    /**
+     * The CRC-32 used by PNG chunks, continuing from \c crc (0 to
+     * start).
+     */
+    static u32 CRC32(const u8 * data, u32 length, u32 crc = 0) ;
+
+    /**
+     * The Adler-32 checksum ending zlib streams, continuing from \c
+     * adler (1 to start).
+     */
+    static u32 Adler32(const u8 * data, u32 length, u32 adler = 1) ;
+
+  private:
+    static void WriteChunk(ByteSink & sink, const char * type, const u8 * data, u32 length) ;
+
+    /**
+     * Deflate \c length bytes of \c data into a zlib stream at \c
+     * out, which must hold at least GetMaxDeflatedLength(length)
+     * bytes.  Returns the stream length.
+     */
+    static u32 Deflate(const u8 * data, u32 length, u8 * out) ;
+
+    static u32 GetMaxDeflatedLength(u32 length)
+    {
+      return length + length / 8 + 16;  // Literals take at most 9 bits
+    }
+  };
+} /* namespace MFM */
+
+#endif /* PNGENCODER_H */
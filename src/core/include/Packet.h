@@ -36,9 +36,10 @@ namespace MFM
 {
 
   /**
-     The type of variable that can contain a raw, unparsed Packet
+     The type of variable that can contain a raw, unparsed Packet.
+     Sized to hold an entire UPDATE_BATCH.
    */
-  typedef OString128 PacketBuffer;
+  typedef OString2048 PacketBuffer;
 
   /**
      The type of a variable that can contain a PacketType value
@@ -84,8 +85,31 @@ namespace MFM
      */
     static const u8 UPDATE_ACK = 'a';
 
+    /**
+     * The PacketType when an updater is supplying an entire cache
+     * update -- the equivalent of UPDATE_BEGIN, all UPDATE and CHECK
+     * packets, and UPDATE_END -- in one binary packet.  Format:
+     * UPDATE_BATCH + s16:CX + s16:CY + u8:COUNT + COUNT * (u8:TYPE +
+     * u8:SITENO + u32[]:ATOM), where TYPE is UPDATE or CHECK, ATOM is
+     * the raw BitVector words of the atom, and all multibyte values
+     * are in host byte order.
+     */
+    static const u8 UPDATE_BATCH = 'B';
+
   } /* namespace PacketType */
 
+  /**
+     Constants for framing Packets on an AbstractChannel.  Each Packet
+     is preceded by its length as a single byte, unless the length is
+     EXTENDED_LENGTH or more, in which case it is preceded by
+     EXTENDED_LENGTH and then the length as a little-endian u16.
+   */
+  namespace PacketFraming
+  {
+    static const u8 EXTENDED_LENGTH = 0xff;
+
+  } /* namespace PacketFraming */
+
 } /* namespace MFM */
 
 #endif /*PACKET_H*/
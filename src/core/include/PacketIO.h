@@ -53,6 +53,14 @@ namespace MFM
     template <class EC>
     bool SendReply(PacketTypeCode ptype, CacheProcessor<EC> & cxn) ;
 
+    /**
+       Ship the entire pending cache update of cxn as a single binary
+       UPDATE_BATCH packet.  \returns false if the channel does not
+       currently have room for it.
+     */
+    template <class EC>
+    bool SendUpdateBatch(CacheProcessor<EC> & cxn) ;
+
     /**
        Parse (and dispatch to ReceiveXXX methods herein) to deal with
        the packet in buf.  \returns true if all went well, \returns
@@ -73,6 +81,9 @@ namespace MFM
     template <class EC>
     bool ReceiveReply(CacheProcessor<EC> & cxn, ByteSource & buf) ;
 
+    template <class EC>
+    bool ReceiveUpdateBatch(CacheProcessor<EC> & cxn, PacketBuffer & buf) ;
+
   };
 
 } /* namespace MFM */
@@ -2,6 +2,7 @@
 
 #include "CacheProcessor.h"
 #include "CharBufferByteSource.h"
+#include <string.h>  /* For memcpy */
 
 namespace MFM
 {
@@ -108,6 +109,92 @@ namespace MFM
     return true;
   }
 
+  template <class EC>
+  bool PacketIO::SendUpdateBatch(CacheProcessor<EC> & cxn)
+  {
+    typedef typename CacheProcessor<EC>::CachePacketInfo CachePacketInfo;
+    typedef BitVector<EC::ATOM_CONFIG::BITS_PER_ATOM> BV;
+
+    SPoint center = cxn.LocalToRemote(cxn.m_eventCenter);
+    const s16 cx = center.GetX();
+    const s16 cy = center.GetY();
+    const u32 count = cxn.m_toSendCount;
+    MFM_API_ASSERT_STATE(count <= U8_MAX);
+
+    u8 header[6];
+    header[0] = PacketType::UPDATE_BATCH;
+    memcpy(&header[1], &cx, sizeof(cx));
+    memcpy(&header[3], &cy, sizeof(cy));
+    header[5] = (u8) count;
+
+    m_buffer.Reset();
+    m_buffer.WriteBytes(header, sizeof(header));
+    for (u32 i = 0; i < count; ++i)
+    {
+      const CachePacketInfo & cpi = cxn.m_toSend[i];
+      u8 site[2];
+      site[0] = cpi.m_type;
+      site[1] = (u8) cpi.m_siteNumber;
+      m_buffer.WriteBytes(site, sizeof(site));
+
+      u32 words[BV::ARRAY_LENGTH];
+      Element<EC>::GetBits(cpi.m_atom).ToArray(words);
+      m_buffer.WriteBytes((const u8 *) words, sizeof(words));
+    }
+    return cxn.ShipBufferAsPacket(m_buffer);
+  }
+
+  template <class EC>
+  bool PacketIO::ReceiveUpdateBatch(CacheProcessor<EC> & cxn, PacketBuffer & buf)
+  {
+    typedef BitVector<EC::ATOM_CONFIG::BITS_PER_ATOM> BV;
+    enum {
+      HEADER_BYTES = 6,
+      ATOM_BYTES = BV::ARRAY_LENGTH * sizeof(u32),
+      RECORD_BYTES = 2 + ATOM_BYTES
+    };
+
+    const u8 * p = (const u8 *) buf.GetBuffer();
+    const u32 len = buf.GetLength();
+    if (len < HEADER_BYTES || p[0] != PacketType::UPDATE_BATCH)
+    {
+      return false;
+    }
+
+    s16 cx, cy;
+    memcpy(&cx, &p[1], sizeof(cx));
+    memcpy(&cy, &p[3], sizeof(cy));
+    const u32 count = p[5];
+    if (len != HEADER_BYTES + count * RECORD_BYTES)
+    {
+      return false;
+    }
+
+    cxn.BeginUpdate(SPoint(cx, cy));
+
+    p += HEADER_BYTES;
+    for (u32 i = 0; i < count; ++i, p += RECORD_BYTES)
+    {
+      const u8 ptype = p[0];
+      const u8 site = p[1];
+      if (ptype != PacketType::UPDATE && ptype != PacketType::CHECK)
+      {
+        return false;
+      }
+
+      u32 words[BV::ARRAY_LENGTH];
+      memcpy(words, &p[2], ATOM_BYTES);
+
+      typename EC::ATOM_CONFIG::ATOM_TYPE atom;
+      Element<EC>::GetBits(atom).FromArray(words);
+
+      cxn.ReceiveAtom(ptype==PacketType::UPDATE, site, atom);
+    }
+
+    cxn.ReceiveUpdateEnd();
+    return true;
+  }
+
   template <class EC>
   bool PacketIO::HandlePacket(CacheProcessor<EC> & cxn, PacketBuffer & buf)
   {
@@ -127,6 +214,9 @@ namespace MFM
     case PacketType::UPDATE_ACK:
       return ReceiveReply(cxn, cbs);
 
+    case PacketType::UPDATE_BATCH:
+      return ReceiveUpdateBatch(cxn, buf);
+
     default:
       FAIL(ILLEGAL_STATE);
     }
@@ -0,0 +1,103 @@
+/*                                              -*- mode:C++ -*-
+  RandPhilox.h Counter-based Philox4x32-10 pseudo-random generator
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file RandPhilox.h Counter-based Philox4x32-10 pseudo-random generator
+  \lgpl
+ */
+#ifndef RANDPHILOX_H
+#define RANDPHILOX_H
+
+#include "itype.h"
+
+namespace MFM
+{
+  /**
+   * The Philox4x32-10 counter-based generator of Salmon et al.,
+   * "Parallel Random Numbers: As Easy as 1, 2, 3" (SC11).  Block n
+   * of the stream selected by a 64-bit key is a keyed bijection of
+   * n, so distinct keys give independent streams from a few words of
+   * state, and any stream can be entered at any block.
+   *
+   * Blocks are generated BULK_BLOCKS at a time, with the blocks laid
+   * out side by side so the rounds vectorize.
+   */
+  class RandPhilox
+  {
+  public:
+    enum
+    {
+      BLOCK_WORDS = 4,
+      BULK_BLOCKS = 4,
+      BUFFER_WORDS = BLOCK_WORDS * BULK_BLOCKS,
+      ROUNDS = 10
+    };
+
+    RandPhilox()
+    {
+      SetKey(0, 0);
+    }
+
+    /**
+     * Select the stream keyed by \c key0 and \c key1, and restart it
+     * from its first block.
+     */
+    void SetKey(u32 key0, u32 key1)
+    {
+      m_key[0] = key0;
+      m_key[1] = key1;
+      SetCounter(0);
+    }
+
+    /**
+     * Continue the current stream from block \c block.
+     */
+    void SetCounter(u64 block)
+    {
+      m_counter = block;
+      m_next = BUFFER_WORDS;
+    }
+
+    inline u32 Next()
+    {
+      if (m_next >= BUFFER_WORDS)
+      {
+        Refill();
+      }
+      return m_buffer[m_next++];
+    }
+
+    /**
+     * Apply the Philox4x32-10 bijection under \c key to the \c count
+     * counters whose words are x0[i]..x3[i], in place.
+     */
+    static void Blocks(const u32 key[2], u32 * x0, u32 * x1, u32 * x2, u32 * x3, u32 count) ;
+
+  private:
+    u32 m_key[2];
+    u32 m_next;
+    u64 m_counter;   //< Next block to generate
+    u32 m_buffer[BUFFER_WORDS];
+
+    void Refill() ;
+  };
+} /* namespace MFM */
+
+#endif /* RANDPHILOX_H */
@@ -32,6 +32,7 @@
 
 #include "itype.h"
 #include "RandMT.h"
+#include "RandPhilox.h"
 #include "BitVector.h"
 #include "FXP.h"
 #include "Fail.h"
@@ -47,10 +48,25 @@ namespace MFM
   {
   public:
 
+    /**
+     * The underlying PRNGs a Random can use.  GENERATOR_MT, the
+     * default, is the Mersenne Twister, whose sequences are
+     * unchanged from earlier releases.  GENERATOR_PHILOX is the
+     * counter-based RandPhilox, whose state is about a tenth of a
+     * kilobyte rather than two and a half, and whose independent
+     * streams are selected by SetStream.
+     */
+    enum Generator
+    {
+      GENERATOR_MT,
+      GENERATOR_PHILOX
+    };
+
     /**
      * Creates a new Random instance that is ready to be used.
      */
     Random()
+      : _type(GENERATOR_MT)
     {
       static u32 counter = 0;
       SetSeed(++counter);
@@ -61,6 +77,7 @@ namespace MFM
      * seed.
      */
     Random(u32 seed)
+      : _type(GENERATOR_MT)
     {
       SetSeed(seed);
     }
@@ -72,6 +89,10 @@ namespace MFM
      */
     inline u32 Create()
     {
+      if (_type == GENERATOR_PHILOX)
+      {
+        return _philox.Next();
+      }
       return _generator.randomMT();
     }
 
@@ -117,6 +138,10 @@ namespace MFM
 	  MFM_API_ASSERT_ARG(maxval==1);    // maxval==0 -> fail ILLEGAL_ARGUMENT
 	  return 0;
 	}
+      if (_type == GENERATOR_PHILOX)
+	{
+	  return _createMultiplyShift(maxval);
+	}
       u32 nbits = _getLogBase2(maxval)+1; // +1: log2(2) == 1 -> need 2 bits
       u32 ret;
       do
@@ -198,15 +223,85 @@ namespace MFM
      */
     void SetSeed(u32 seed)
     {
-      _generator.seedMT_MFM(seed);
+      if (_type == GENERATOR_PHILOX)
+      {
+        _philox.SetKey(seed, 0);
+      }
+      else
+      {
+        _generator.seedMT_MFM(seed);
+      }
+      _bitsRemaining = 0;
+    }
+
+    /**
+     * Resets the PRNG to stream number \c stream of those derived
+     * from \c seed.  Under GENERATOR_PHILOX, each (seed, stream) pair
+     * keys its own independent stream; under GENERATOR_MT the pair is
+     * hashed into an ordinary seed.
+     */
+    void SetStream(u32 seed, u32 stream)
+    {
+      if (_type == GENERATOR_PHILOX)
+      {
+        _philox.SetKey(seed, stream);
+      }
+      else
+      {
+        u32 x0 = stream, x1 = 0, x2 = 0, x3 = 0;
+        const u32 key[2] = { seed, 0 };
+        RandPhilox::Blocks(key, &x0, &x1, &x2, &x3, 1);
+        _generator.seedMT_MFM(x0);
+      }
+      _bitsRemaining = 0;
+    }
+
+    /**
+     * Switches to PRNG \c type.  Call SetSeed or SetStream afterward
+     * to seed it.
+     */
+    void SetGenerator(Generator type)
+    {
+      MFM_API_ASSERT_ARG(type == GENERATOR_MT || type == GENERATOR_PHILOX);
+      _type = type;
       _bitsRemaining = 0;
     }
 
+    Generator GetGenerator() const
+    {
+      return _type;
+    }
+
   private:
+    // Everything GENERATOR_PHILOX touches comes before _generator
+    Generator _type;
     s32 _bitsRemaining;
     u32 _bitBuffer;
+    RandPhilox _philox;
     RandMT _generator;
 
+    /**
+     * Lemire's multiply-shift reduction ("Fast Random Integer
+     * Generation in an Interval", 2019): the high word of
+     * Create()*maxval, rejecting the 2**32 mod maxval low words that
+     * would bias it.  maxval must be at least 2.
+     */
+    inline u32 _createMultiplyShift(u32 maxval)
+    {
+      u64 product = (u64) Create() * maxval;
+      u32 low = (u32) product;
+      if (low < maxval)
+      {
+        const u32 threshold = (0u - maxval) % maxval;  // 2**32 mod maxval
+        while (low < threshold)
+        {
+          product = (u64) Create() * maxval;
+          low = (u32) product;
+        }
+      }
+      return (u32) (product >> 32);
+    }
+
   };
 
   /******************************************************************************
@@ -35,10 +35,31 @@
 namespace MFM
 {
 
+  /**
+     The per-site event bookkeeping that accompanies each Atom in a
+     Site.
+   */
+  struct SiteCounters
+  {
+    u64 m_eventCount;
+    u64 m_lastChangedEventCount;  // in units of Site event count
+    u64 m_lastEventNumber;        // in units of total tile events
+    bool m_isLiveSite;
+
+    SiteCounters()
+      : m_eventCount(0)
+      , m_lastChangedEventCount(0)
+      , m_lastEventNumber(0)
+      , m_isLiveSite(true)
+    { }
+  };
+
   /**
      A Site holds a Base and an Atom, and all information associated
      with that Atom, such as access times, ages, and so forth.  It is
      a template depending only on an AtomConfig (AC).
+
+     \sa SoASite
    */
   template <class AC>
   class Site
@@ -55,45 +76,59 @@ namespace MFM
   private:
     T m_atom;
     Base<AC> m_base;
-    u64 m_eventCount;
-    u64 m_lastChangedEventCount;  // in units of Site event count
-    u64 m_lastEventNumber;        // in units of total tile events
-    bool m_isLiveSite;
+    SiteCounters m_counters;
 
   public:
     Site()
-      : m_eventCount(0)
-      , m_lastChangedEventCount(0)
-      , m_lastEventNumber(0)
-      , m_isLiveSite(true)
     { }
 
     void RecordEventAtSite(u64 eventNumber)
     {
-      ++m_eventCount;
-      m_lastEventNumber = eventNumber;
+      ++m_counters.m_eventCount;
+      m_counters.m_lastEventNumber = eventNumber;
     }
 
     void SaveConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf) const
     {
-      bs.Printf(",%D", m_isLiveSite);
+      SaveSiteConfig(bs, atf, m_atom, m_base, m_counters);
+    }
+
+    bool LoadConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
+    {
+      return LoadSiteConfig(bs, atf, m_atom, m_base, m_counters);
+    }
+
+    /**
+       Save the given parts of a site in the format read by
+       LoadSiteConfig.  Shared by all site storage layouts.
+     */
+    static void SaveSiteConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf,
+                               const T & atom, const Base<AC> & base, const SiteCounters & counters)
+    {
+      bs.Printf(",%D", counters.m_isLiveSite);
       // 64 bit stuff not yet exposed via Printf..
-      bs.Print(m_eventCount, Format::LXX64);
-      bs.Print(m_lastChangedEventCount, Format::LXX64);
-      bs.Print(m_lastEventNumber, Format::LXX64);
+      bs.Print(counters.m_eventCount, Format::LXX64);
+      bs.Print(counters.m_lastChangedEventCount, Format::LXX64);
+      bs.Print(counters.m_lastEventNumber, Format::LXX64);
 
       {
-        T tmp = m_atom;
+        T tmp = atom;
         bs.Printf(",");
         atf.PrintAtomType(tmp, bs);
         AtomSerializer<AC> as(tmp);
         bs.Printf(",%@", &as);
       }
 
-      m_base.SaveConfig(bs, atf);
+      base.SaveConfig(bs, atf);
     }
 
-    bool LoadConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
+    /**
+       Load the given parts of a site from the format written by
+       SaveSiteConfig.  Returns false, possibly with base modified,
+       if the input was malformed.
+     */
+    static bool LoadSiteConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf,
+                               T & atom, Base<AC> & base, SiteCounters & counters)
     {
       u32 tmp_m_isLiveSite;
       if (2 != bs.Scanf(",%D", &tmp_m_isLiveSite)) return false;
@@ -126,22 +161,22 @@ namespace MFM
         }
       }
 
-      if (!m_base.LoadConfig(bs, atf))
+      if (!base.LoadConfig(bs, atf))
         return false;
 
-      m_atom = defaultAtom;
+      atom = defaultAtom;
 
-      m_isLiveSite = tmp_m_isLiveSite;
-      m_eventCount = tmp_m_eventCount;
-      m_lastChangedEventCount = tmp_m_lastChangedEventCount;
-      m_lastEventNumber = tmp_m_lastEventNumber;
+      counters.m_isLiveSite = tmp_m_isLiveSite;
+      counters.m_eventCount = tmp_m_eventCount;
+      counters.m_lastChangedEventCount = tmp_m_lastChangedEventCount;
+      counters.m_lastEventNumber = tmp_m_lastEventNumber;
 
       return true;
     }
 
     void Sense(SiteTouchType stt)
     {
-      m_base.GetSensory().Touch(stt, m_eventCount);
+      m_base.GetSensory().Touch(stt, m_counters.m_eventCount);
     }
 
     bool InRecentProximity() const
@@ -151,7 +186,7 @@ namespace MFM
 
     u32 RecentTouch() const
     {
-      return m_base.GetSensory().RecentTouch(m_eventCount);
+      return m_base.GetSensory().RecentTouch(m_counters.m_eventCount);
     }
 
     bool HasRecentLightTouch()
@@ -166,6 +201,9 @@ namespace MFM
     Base<AC> & GetBase() { return m_base; }
     const Base<AC> & GetBase() const { return m_base; }
 
+    SiteCounters & GetCounters() { return m_counters; }
+    const SiteCounters & GetCounters() const { return m_counters; }
+
     u32 GetPaint() const {
       return GetBase().GetPaint();
     }
@@ -176,32 +214,66 @@ namespace MFM
 
     void Clear() {
       m_atom.SetEmpty();
-      m_eventCount = 0;
-      m_lastChangedEventCount = 0;
+      m_counters.m_eventCount = 0;
+      m_counters.m_lastChangedEventCount = 0;
       m_base.GetSensory().Clear();
     }
 
     u64 GetEventCount() const {
-      return m_eventCount;
+      return m_counters.m_eventCount;
     }
 
     u64 GetLastChangedEventCount() const {
-      return m_lastChangedEventCount;
+      return m_counters.m_lastChangedEventCount;
     }
 
     void MarkChanged() {
-      m_lastChangedEventCount = m_eventCount;
+      m_counters.m_lastChangedEventCount = m_counters.m_eventCount;
     }
 
     u64 GetWriteAge() const {
-      return m_eventCount - m_lastChangedEventCount;
+      return m_counters.m_eventCount - m_counters.m_lastChangedEventCount;
     }
 
     u64 GetEventAge(u64 currentEventNumber) const {
-      return m_lastEventNumber - currentEventNumber;
+      return m_counters.m_lastEventNumber - currentEventNumber;
     }
 
   };
+
+  /**
+     The storage for SITES sites of type SITE, as used by SizedTile.
+     By default, just an array of SITEs; site types that keep their
+     data elsewhere specialize this.
+
+     \sa SoASite
+   */
+  template <class SITE, u32 SITES>
+  class SiteStorage
+  {
+    SITE m_sites[SITES];
+
+  public:
+    SITE * GetSites() { return m_sites; }
+
+    /**
+       The atom of site 0.  The atom of site i is SiteAtomStride<SITE>
+       ::BYTES * i bytes beyond it.
+     */
+    typename SITE::T * GetAtoms() { return &m_sites[0].GetAtom(); }
+  };
+
+  /**
+     The distance in bytes from one site's atom to the next, in the
+     SiteStorage for SITEs.  Sites hold their own atoms by default, so
+     it's the size of a whole site.
+   */
+  template <class SITE>
+  struct SiteAtomStride
+  {
+    enum { BYTES = sizeof(SITE) };
+  };
+
 } /* namespace MFM */
 
 #endif /*SITE_H*/
@@ -0,0 +1,72 @@
+/*                                              -*- mode:C++ -*-
+  SiteTypeMatch.h Vectorized matching of packed site types
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SiteTypeMatch.h Vectorized matching of packed site types
+  \lgpl
+ */
+#ifndef SITETYPEMATCH_H
+#define SITETYPEMATCH_H
+
+#include "itype.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace MFM
+{
+  /**
+   * Return a mask with bit i set if and only if types[i] == type, for
+   * i in 0..31.  Reads exactly 32 entries of \c types, which need not
+   * be aligned.  Uses AVX2 or SSE2 when the compiler targets them
+   * (SSE2 is the x86-64 baseline), and a plain loop otherwise.
+   */
+  inline u32 MatchSiteTypes32(const u16 * types, u16 type)
+  {
+#if defined(__AVX2__)
+    const __m256i t = _mm256_set1_epi16((short) type);
+    __m256i lo = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *) types), t);
+    __m256i hi = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *) (types + 16)), t);
+    // packs interleaves the 128-bit lanes; put the quadwords back in order
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), 0xd8);
+    return (u32) _mm256_movemask_epi8(packed);
+#elif defined(__SSE2__)
+    const __m128i t = _mm_set1_epi16((short) type);
+    u32 bits = 0;
+    for (u32 i = 0; i < 32; i += 16)
+    {
+      __m128i lo = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *) (types + i)), t);
+      __m128i hi = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *) (types + i + 8)), t);
+      bits |= ((u32) _mm_movemask_epi8(_mm_packs_epi16(lo, hi))) << i;
+    }
+    return bits;
+#else
+    u32 bits = 0;
+    for (u32 i = 0; i < 32; ++i)
+    {
+      bits |= ((u32) (types[i] == type)) << i;
+    }
+    return bits;
+#endif
+  }
+} /* namespace MFM */
+
+#endif /* SITETYPEMATCH_H */
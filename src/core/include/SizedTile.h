@@ -30,6 +30,8 @@
 #define SIZEDTILE_H
 
 #include "Tile.h"
+#include "Site.h"
+#include "SoASite.h"
 
 namespace MFM
 {
@@ -38,10 +40,18 @@ namespace MFM
      A SizedTile provides a completed Tile, possessing a size and site
      storage, and offering a default constructor so that arrays of
      SizedTiles can be formed.
+
+     The site storage layout is determined by EC::SITE, via
+     SiteStorage: an array of Site<AC>s by default, or separate atom,
+     base, and counter arrays if EC::SITE is an SoASite<AC>.  The
+     storage is a base class, listed first, so that it is constructed
+     before the Tile initializes the sites.
    */
   template <class EC, u32 WIDTH, u32 HEIGHT, u32 EVENTHISTORYSIZE>
-  class SizedTile : public Tile<EC>
+  class SizedTile : private SiteStorage<typename EC::SITE, WIDTH * HEIGHT>, public Tile<EC>
   {
+    typedef SiteStorage<typename EC::SITE, WIDTH * HEIGHT> OurSiteStorage;
+
   public:
     typedef typename EC::SITE SITE;
 
@@ -55,11 +65,15 @@ namespace MFM
 
     static bool IsGridLayoutPatternStaggered() { return (m_ctorLayoutPattern == GRID_LAYOUT_STAGGERED); }
 
-    SizedTile(): Tile<EC>(TILE_WIDTH, TILE_HEIGHT, m_ctorLayoutPattern, m_sites, EVENTHISTORYSIZE, m_items) { }
+    SizedTile()
+      : OurSiteStorage()
+      , Tile<EC>(TILE_WIDTH, TILE_HEIGHT, m_ctorLayoutPattern, OurSiteStorage::GetSites(), OurSiteStorage::GetAtoms(), m_siteFlags, m_siteStamps, EVENTHISTORYSIZE, m_items)
+    { }
 
 
   private:
-    SITE m_sites[TILE_SITES];
+    u8 m_siteFlags[TILE_SITES];
+    u32 m_siteStamps[TILE_SITES];
     EventHistoryItem m_items[EVENTHISTORYSIZE];
     static GridLayoutPattern m_ctorLayoutPattern;
 
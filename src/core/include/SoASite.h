@@ -0,0 +1,252 @@
+/*                                              -*- mode:C++ -*-
+  SoASite.h A Site whose parts are stored in separate arrays
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SoASite.h A Site whose parts are stored in separate arrays
+  \lgpl
+ */
+#ifndef SOASITE_H
+#define SOASITE_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "Site.h"
+
+namespace MFM
+{
+
+  /**
+     Where the atoms, bases, and counters of a set of SoASites live:
+     one contiguous array of each.
+   */
+  template <class AC>
+  struct SoASitePlanes
+  {
+    typedef typename AC::ATOM_TYPE T;
+
+    T * m_atoms;
+    Base<AC> * m_bases;
+    SiteCounters * m_counters;
+
+    SoASitePlanes()
+      : m_atoms(0)
+      , m_bases(0)
+      , m_counters(0)
+    { }
+  };
+
+  /**
+     A structure-of-arrays alternative to Site.  An SoASite offers the
+     same interface as a Site, but holds only its index into the
+     SoASitePlanes where its atom, base, and counters actually live.
+     Scans that touch only atoms (see Tile::GetAtomByNumber) thus
+     walk a dense array of atoms rather than striding over all the
+     per-site state.
+
+     SoASites exist only inside a SiteStorage, which keeps the
+     SoASitePlanes immediately before its array of SoASites; a site
+     finds them from its own address and index.  So SoASites can't be
+     copied.
+
+     Select it by building an EventConfig on SoASite<AC> instead of
+     Site<AC>; SizedTile then allocates the planes via the
+     SiteStorage specialization below.
+
+     \sa Site
+   */
+  template <class AC>
+  class SoASite
+  {
+  public:
+    /**
+       Present the AtomConfig in use
+     */
+    typedef AC ATOM_CONFIG;
+
+    // Extract short names for parameter types
+    typedef typename ATOM_CONFIG::ATOM_TYPE T;
+
+  private:
+    u32 m_index;
+
+    const SoASitePlanes<AC> & Planes() const
+    {
+      return reinterpret_cast<const SoASitePlanes<AC> *>(this - m_index)[-1];
+    }
+
+    SiteCounters & Counters() { return Planes().m_counters[m_index]; }
+    const SiteCounters & Counters() const { return Planes().m_counters[m_index]; }
+
+    SoASite(const SoASite &);             // declare away
+    SoASite & operator=(const SoASite &); // declare away
+
+  public:
+    SoASite()
+      : m_index(0)
+    { }
+
+    /**
+       Make this SoASite entry \c index of the SoASitePlanes just
+       before the SoASite array it is entry \c index of.
+     */
+    void SetIndex(u32 index)
+    {
+      m_index = index;
+    }
+
+    void RecordEventAtSite(u64 eventNumber)
+    {
+      SiteCounters & c = Counters();
+      ++c.m_eventCount;
+      c.m_lastEventNumber = eventNumber;
+    }
+
+    void SaveConfig(ByteSink& bs, AtomTypeFormatter<AC> & atf) const
+    {
+      Site<AC>::SaveSiteConfig(bs, atf, GetAtom(), GetBase(), Counters());
+    }
+
+    bool LoadConfig(LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
+    {
+      return Site<AC>::LoadSiteConfig(bs, atf, GetAtom(), GetBase(), Counters());
+    }
+
+    void Sense(SiteTouchType stt)
+    {
+      GetBase().GetSensory().Touch(stt, Counters().m_eventCount);
+    }
+
+    bool InRecentProximity() const
+    {
+      return TOUCH_TYPE_PROXIMITY == RecentTouch();
+    }
+
+    u32 RecentTouch() const
+    {
+      return GetBase().GetSensory().RecentTouch(Counters().m_eventCount);
+    }
+
+    bool HasRecentLightTouch()
+    {
+      return TOUCH_TYPE_LIGHT == RecentTouch();
+    }
+
+    void PutAtom(const T & newAtom) { GetAtom() = newAtom; }
+    T & GetAtom() { return Planes().m_atoms[m_index]; }
+    const T & GetAtom() const { return Planes().m_atoms[m_index]; }
+
+    Base<AC> & GetBase() { return Planes().m_bases[m_index]; }
+    const Base<AC> & GetBase() const { return Planes().m_bases[m_index]; }
+
+    SiteCounters & GetCounters() { return Counters(); }
+    const SiteCounters & GetCounters() const { return Counters(); }
+
+    u32 GetPaint() const {
+      return GetBase().GetPaint();
+    }
+
+    void SetPaint(u32 paint) {
+      GetBase().SetPaint(paint);
+    }
+
+    void Clear() {
+      SiteCounters & c = Counters();
+      GetAtom().SetEmpty();
+      c.m_eventCount = 0;
+      c.m_lastChangedEventCount = 0;
+      GetBase().GetSensory().Clear();
+    }
+
+    u64 GetEventCount() const {
+      return Counters().m_eventCount;
+    }
+
+    u64 GetLastChangedEventCount() const {
+      return Counters().m_lastChangedEventCount;
+    }
+
+    void MarkChanged() {
+      SiteCounters & c = Counters();
+      c.m_lastChangedEventCount = c.m_eventCount;
+    }
+
+    u64 GetWriteAge() const {
+      const SiteCounters & c = Counters();
+      return c.m_eventCount - c.m_lastChangedEventCount;
+    }
+
+    u64 GetEventAge(u64 currentEventNumber) const {
+      return Counters().m_lastEventNumber - currentEventNumber;
+    }
+
+  };
+
+  /**
+     Structure-of-arrays storage for SITES SoASites: the atoms, bases,
+     and counters each get their own contiguous array, and the sites
+     themselves are just indices into them.  m_planes must come right
+     before m_sites; see SoASite.
+   */
+  template <class AC, u32 SITES>
+  class SiteStorage<SoASite<AC>, SITES>
+  {
+    typedef typename AC::ATOM_TYPE T;
+
+    SoASitePlanes<AC> m_planes;
+    SoASite<AC> m_sites[SITES];
+    T m_atoms[SITES];
+    Base<AC> m_bases[SITES];
+    SiteCounters m_counters[SITES];
+
+    SiteStorage(const SiteStorage &);             // declare away
+    SiteStorage & operator=(const SiteStorage &); // declare away
+
+  public:
+    SiteStorage()
+    {
+      m_planes.m_atoms = m_atoms;
+      m_planes.m_bases = m_bases;
+      m_planes.m_counters = m_counters;
+      for (u32 i = 0; i < SITES; ++i)
+      {
+        m_sites[i].SetIndex(i);
+      }
+
+      // No padding may separate the planes from the sites
+      MFM_API_ASSERT_STATE((void *) (&m_planes + 1) == (void *) m_sites);
+    }
+
+    SoASite<AC> * GetSites() { return m_sites; }
+
+    T * GetAtoms() { return m_atoms; }
+  };
+
+  /**
+     SoASite atoms are packed densely
+   */
+  template <class AC>
+  struct SiteAtomStride< SoASite<AC> >
+  {
+    enum { BYTES = sizeof(typename AC::ATOM_TYPE) };
+  };
+
+} /* namespace MFM */
+
+#endif /*SOASITE_H*/
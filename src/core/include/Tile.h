@@ -39,6 +39,9 @@
 #include "Element.h"
 #include "Site.h"
 #include "EventWindow.h"
+#include "EventPhaseProfile.h"
+#include "ElementProfile.h"
+#include "CacheProfile.h"
 #include "EventHistoryItem.h"
 #include "ElementTable.h"
 #include "CacheProcessor.h"
@@ -46,6 +49,7 @@
 #include "LonglivedLock.h"
 #include "OverflowableCharBufferByteSink.h"  /* for OString16 */
 #include "LineCountingByteSource.h"
+#include "TileSnapshots.h"
 
 namespace MFM
 {
@@ -137,7 +141,7 @@ namespace MFM
       REGION_COUNT
     };
 
-    Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, const u32 eventbuffersize, EventHistoryItem * items) ;
+    Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, T * atoms, u8 * siteFlags, u32 * siteStamps, const u32 eventbuffersize, EventHistoryItem * items) ;
 
     ~Tile() ;
 
@@ -202,6 +206,41 @@ namespace MFM
       return const_cast<S &>(static_cast<const Tile<EC>*>(this)->GetSite(index));
     }
 
+    /**
+       Get a const reference to the Site with site-in-tile number \c
+       siteInTileNumber, \e including the caches.  This is the flat
+       equivalent of GetSite(GetCoordOfSiteInTileNumber(siteInTileNumber)).
+     */
+    const S & GetSiteByNumber(u32 siteInTileNumber) const
+    {
+      MFM_API_ASSERT_ARG(siteInTileNumber < TILE_WIDTH*TILE_HEIGHT);
+      return m_sites[siteInTileNumber];
+    }
+
+    /**
+       Get a mutable reference to the Site with site-in-tile number \c
+       siteInTileNumber, \e including the caches.
+     */
+    S & GetSiteByNumber(u32 siteInTileNumber)
+    {
+      return const_cast<S &>(static_cast<const Tile<EC>*>(this)->GetSiteByNumber(siteInTileNumber));
+    }
+
+    /**
+       Get the atom of the site with site-in-tile number \c
+       siteInTileNumber, \e including the caches, straight from the
+       site storage rather than through its Site.  Scans that need
+       only atoms should use this: when EC::SITE is an SoASite the
+       atoms are contiguous, and otherwise this just strides over
+       whole Sites.
+     */
+    const T & GetAtomByNumber(u32 siteInTileNumber) const
+    {
+      MFM_API_ASSERT_ARG(siteInTileNumber < TILE_WIDTH*TILE_HEIGHT);
+      return *reinterpret_cast<const T *>(reinterpret_cast<const u8 *>(m_atoms) +
+                                          siteInTileNumber * ATOM_STRIDE);
+    }
+
     /**
        Get a const reference to the Site at position \c index of the
        tile, \e excluding the caches, so index ranges from
@@ -237,6 +276,17 @@ namespace MFM
       return m_cdata.GetAtomCount(atomType);
     }
 
+    /**
+     * Check the incrementally-maintained atom counts of this Tile
+     * against a full rescan of its owned sites, leaving the counts
+     * correct either way.  Returns false if they disagreed.  For
+     * debugging; call only while this Tile is paused.
+     */
+    bool VerifyAtomCounts() const
+    {
+      return m_cdata.VerifyAtomCounts();
+    }
+
     /**
      * The maximum number of tile parameters
      */
@@ -270,6 +320,64 @@ namespace MFM
       m_warpFactor = MIN(10u, warp);
     }
 
+    /**
+       Let each Advance of an ACTIVE Tile initiate up to \c limit
+       events, back to back, before it services communication.  A
+       batch ends early at the first event centered outside the hidden
+       region, since that event may need locks and cache updates that
+       only communication can complete.  The batch size adapts within
+       1..limit to our boundaries' communication backlog.  1 (the
+       default) disables batching.  Call only while the Tile is not
+       running.
+     */
+    void SetEventBatchLimit(u32 limit)
+    {
+      MFM_API_ASSERT_ARG(limit > 0);
+      m_eventBatchLimit = limit;
+      m_eventBatchSize = 1;
+    }
+
+    u32 GetEventBatchLimit() const
+    {
+      return m_eventBatchLimit;
+    }
+
+    u32 GetEventBatchSize() const
+    {
+      return m_eventBatchSize;
+    }
+
+    /**
+       Let each Advance that finds at least \c interval events executed
+       since the last snapshot publish a fresh copy of our owned
+       atoms, which other threads may read without pausing us (see
+       GetSnapshots).  0 (the default) publishes nothing and frees the
+       snapshot buffers.  Call only while the Tile is not running.
+     */
+    void SetSnapshotInterval(u32 interval) ;
+
+    u32 GetSnapshotInterval() const
+    {
+      return m_snapshotInterval;
+    }
+
+    /**
+       Publish a snapshot of our owned atoms now, if snapshots are
+       enabled and readers have left a buffer free.  Call only from
+       the thread advancing this Tile, or while it is not running.
+     */
+    void PublishSnapshot() ;
+
+    /**
+       The latest published snapshot of our owned atoms, for reading
+       via a TileSnapshots::Reader from any thread.  The Reader is
+       invalid until a snapshot has been published.
+     */
+    const TileSnapshots<T> & GetSnapshots() const
+    {
+      return m_snapshots;
+    }
+
     bool IsTileGridLayoutStaggered() const
     {
       return (GRID_LAYOUT == GRID_LAYOUT_STAGGERED);
@@ -294,6 +402,66 @@ namespace MFM
 
     S * const m_sites;
 
+    enum { ATOM_STRIDE = SiteAtomStride<S>::BYTES };
+
+    /**
+     * The atom of site 0, in our site storage; see GetAtomByNumber
+     */
+    T * const m_atoms;
+
+    T & GetWritableAtomByNumber(u32 siteInTileNumber)
+    {
+      return const_cast<T &>(static_cast<const Tile<EC>*>(this)->GetAtomByNumber(siteInTileNumber));
+    }
+
+    /**
+     * Per-site flags, indexed by GetSiteInTileNumber, caching the
+     * connectivity-dependent predicates IsLiveSite (SITE_FLAG_LIVE)
+     * and IsReachableViaCacheProtocol (SITE_FLAG_CACHE_REACHABLE).
+     * Rebuilt by RebuildSiteFlags whenever our connectivity changes.
+     */
+    u8 * const m_siteFlags;
+
+    enum { SITE_FLAG_LIVE = 1, SITE_FLAG_CACHE_REACHABLE = 2 };
+
+    /**
+     * Per-site change stamps, indexed by GetSiteInTileNumber: the
+     * value of m_changeStamp issued when the site was last written
+     * by PlaceAtomInSite.  See IsSiteChangedSince.
+     */
+    u32 * const m_siteStamps;
+
+    /**
+     * The last change stamp issued.  Mutable, like m_cdata, so the
+     * const NoteAllSitesChanged can issue one.
+     */
+    mutable u32 m_changeStamp;
+
+    /**
+     * The stamp issued by the last NoteAllSitesChanged
+     */
+    mutable u32 m_allSitesStamp;
+
+    void StampSite(const SPoint & location)
+    {
+      m_siteStamps[GetSiteInTileNumber(location)] = ++m_changeStamp;
+    }
+
+    void RebuildSiteFlags() ;
+
+    bool ComputeIsLiveSite(const SPoint & location) const ;
+
+    bool ComputeIsReachableViaCacheProtocol(const SPoint & location) const ;
+
+    u8 GetSiteFlags(const SPoint & location) const
+    {
+      if (!IsInTile(location))
+      {
+        return 0;
+      }
+      return m_siteFlags[location.GetY() * TILE_WIDTH + location.GetX()];
+    }
+
     /**
      * A brief name or label for this Tile, for reporting and debugging
      */
@@ -359,7 +527,7 @@ namespace MFM
      *
      * @returns The Region that pt is pointing at.
      */
-    Region RegionIn(const SPoint& pt);
+    Region RegionIn(const SPoint& pt) const;
 
     UlamClassRegistry<EC> & GetUlamClassRegistry() { return m_ucr; }
 
@@ -488,9 +656,23 @@ namespace MFM
 
   private:
 
+    /**
+       Per-type counts of the atoms in the owned sites of a Tile.
+       PlaceAtomInSite keeps the counts current as it writes, so
+       reading them costs nothing; writers that bypass it (config
+       loading, X-rays, history replay, ..)  call NeedAtomRecount
+       instead, and the next read rescans the tile.  Like the sites
+       themselves, the counts are written by the thread advancing the
+       tile, so read them while the tile is paused.
+
+       Define ATOM_COUNT_CHECKS to have every count read verify the
+       incremental counts against a full rescan.
+     */
     struct CountData {
       CountData(const Tile& t)
         : m_tile(t)
+        , m_illegalAtomCount(0)
+        , m_needRecount(true)
       { }
 
       const Tile & m_tile;
@@ -508,6 +690,9 @@ namespace MFM
 
       void RecountIfNeeded()
       {
+#ifdef ATOM_COUNT_CHECKS
+        MFM_API_ASSERT_STATE(VerifyAtomCounts());
+#endif
         if (m_needRecount)
         {
           RecountAtoms();
@@ -515,6 +700,27 @@ namespace MFM
         m_needRecount = false;
       }
 
+      /**
+         Account for an owned site changing from an atom of \c oldType
+         to one of \c newType.
+       */
+      void ChangeAtomType(u32 oldType, u32 newType)
+      {
+        if (m_needRecount || oldType == newType)
+        {
+          return;  // Nothing to do, or a rescan will handle it
+        }
+        s32 oldIdx = m_tile.m_elementTable.GetIndex(oldType);
+        if (oldIdx < 0) --m_illegalAtomCount;
+        else --m_atomCount[oldIdx];
+
+        s32 newIdx = m_tile.m_elementTable.GetIndex(newType);
+        if (newIdx < 0) ++m_illegalAtomCount;
+        else ++m_atomCount[newIdx];
+      }
+
+      bool VerifyAtomCounts() ;
+
       u32 GetIllegalAtomCount()
       {
         RecountIfNeeded();
@@ -601,11 +807,74 @@ namespace MFM
      */
     u32 m_warpFactor;
 
+    /**
+       Most events AdvanceComputation may initiate per Advance.  1, the
+       default, means one event per Advance, without batching.
+     */
+    u32 m_eventBatchLimit;
+
+    /**
+       Events the next batch may initiate, in 1..m_eventBatchLimit.
+       Halved whenever our boundaries have communication pending and
+       doubled whenever they do not.
+     */
+    u32 m_eventBatchSize;
+
+    /**
+       Events between published snapshots, or 0 for none
+     */
+    u32 m_snapshotInterval;
+
+    /**
+       Events executed as of the last published snapshot
+     */
+    u64 m_snapshotEvents;
+
+    /**
+       Copies of our owned atoms for observers on other threads
+     */
+    TileSnapshots<T> m_snapshots;
+
     /**
        Record of recent past events for debugging and such
      */
     EventHistoryBuffer<EC> m_eventHistoryBuffer;
 
+    /**
+       Where to accumulate per-phase event timings, or null (the
+       default) to skip timing entirely.
+     */
+    EventPhaseProfile * m_eventPhaseProfile;
+
+    /**
+       Where to accumulate per-element-type event costs, or null (the
+       default) to skip them.
+     */
+    ElementProfile * m_elementProfile;
+
+    /**
+       Where to accumulate lock contention and cache protocol
+       statistics for each of our boundaries, or null (the default)
+       to skip them.
+     */
+    CacheProfile * m_cacheProfile;
+
+    /**
+       True while this Tile is being advanced inside a batch-wide
+       unwind_protect (see SetUnwindBatched), in which case behaviors
+       and atom placements skip their own unwind_protects and just
+       record in m_unwindPhase (and m_placing*) what they are doing,
+       for RecoverBatchFailure.
+     */
+    bool m_unwindBatched;
+    u32 m_unwindPhase;
+    T * m_placingAtom;
+    u32 m_placingType;
+    SPoint m_placingSite;
+
+    void WriteAtomInSite(bool placeInBase, S & site, T & oldAtom, T & newAtom,
+                         const SPoint & pt, bool doIdenticalCheck) ;
+
     /**
      * Compute the coordinates of \c atomLoc in a neighboring tile.
      * (There may or may not actually be a Tile in the given \c
@@ -628,7 +897,7 @@ namespace MFM
      *
      * @returns The Region which index will reach.
      */
-    Region RegionFromIndex(const u32 index, const u32 tileSide);
+    Region RegionFromIndex(const u32 index, const u32 tileSide) const;
 
     /**
      * Performs a single Event on the generated EventWindow .
@@ -646,12 +915,37 @@ namespace MFM
 
     bool AdvanceComputation() ;
 
+    /**
+       Initiate up to m_eventBatchSize events, stopping after the
+       first outside the hidden region, then adapt m_eventBatchSize.
+     */
+    bool AdvanceComputationBatch() ;
+
+    /**
+       Halve m_eventBatchSize if communication is backing up, else
+       double it, up to m_eventBatchLimit.
+     */
+    void AdaptEventBatchSize() ;
+
+    /**
+       True if any of our connected CacheProcessors is mid-update or
+       has unread packets waiting.
+     */
+    bool HasCommunicationBacklog() ;
+
     /**
        Advance the passive packet processing state machine in the
        Tile.  Return true if any possibly valuable work was done.
      */
     bool AdvanceCommunication() ;
 
+    /**
+       The rest of Advance after any computation, given the state it
+       advanced in: communicate, then publish a snapshot if one is
+       due.  Return true if any possibly valuable work was done.
+     */
+    bool FinishAdvance(State curState) ;
+
    public:
     void SetBackgroundRadiationEnabled(bool value);
 
@@ -672,6 +966,128 @@ namespace MFM
       }
     }
 
+    /**
+       Choose binary batched (if binary) or one-per-atom text (if not)
+       cache update packets for all this Tile's CacheProcessors.
+       Should be called only while the Tile is not running.
+     */
+    void SetBinaryCachePackets(bool binary)
+    {
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        CacheProcessor<EC> & cp = m_cacheProcessors[d];
+        cp.SetBinaryPackets(binary);
+      }
+    }
+
+    /**
+       Start accumulating per-phase event timings into \c profile, or
+       stop timing if \c profile is null.  The profile is updated by
+       whichever thread is advancing this Tile, so this should be
+       called, and \c profile read, only while the Tile is not running.
+     */
+    void SetEventPhaseProfile(EventPhaseProfile * profile)
+    {
+      m_eventPhaseProfile = profile;
+    }
+
+    EventPhaseProfile * GetEventPhaseProfile() const
+    {
+      return m_eventPhaseProfile;
+    }
+
+    /**
+       Start accumulating per-element-type event costs into \c
+       profile, or stop if \c profile is null.  As with
+       SetEventPhaseProfile, call this, and read \c profile, only
+       while the Tile is not running.
+     */
+    void SetElementProfile(ElementProfile * profile)
+    {
+      m_elementProfile = profile;
+    }
+
+    ElementProfile * GetElementProfile() const
+    {
+      return m_elementProfile;
+    }
+
+    /**
+       Start accumulating per-boundary lock and cache protocol
+       statistics into \c profile, or stop if \c profile is null.  As
+       with SetEventPhaseProfile, call this, and read \c profile, only
+       while the Tile is not running.
+     */
+    void SetCacheProfile(CacheProfile * profile)
+    {
+      m_cacheProfile = profile;
+    }
+
+    CacheProfile * GetCacheProfile() const
+    {
+      return m_cacheProfile;
+    }
+
+    /**
+       What a batch-wide unwind_protect may have interrupted
+     */
+    enum UnwindPhase
+    {
+      UNWIND_OTHER,      //< Anything else: not recoverable here
+      UNWIND_BEHAVING,   //< Inside EventWindow::ExecuteBehavior
+      UNWIND_PLACING     //< Inside PlaceAtomInSite
+    };
+
+    /**
+       Declare whether the caller has an unwind_protect around this
+       Tile's advances, so that its events and atom placements need
+       not set up their own.  That caller must hand any failure to
+       RecoverBatchFailure.  Only the thread advancing this Tile may
+       call this.
+     */
+    void SetUnwindBatched(bool batched)
+    {
+      m_unwindBatched = batched;
+    }
+
+    bool IsUnwindBatched() const
+    {
+      return m_unwindBatched;
+    }
+
+    void SetUnwindPhase(UnwindPhase phase)
+    {
+      m_unwindPhase = phase;
+    }
+
+    /**
+       Recover from a failure caught by a batch-wide unwind_protect,
+       the same way the per-event and per-placement unwind_protects
+       would have.  A failed behavior erases the event's center atom,
+       logs a backtrace, and finishes the event and the Advance it
+       was in normally, except that a computation batch (see
+       SetEventBatchLimit) stops at the failed event.  A failed
+       placement erases the atom being placed; since the operation
+       that was placing it cannot be resumed, the failure is then
+       passed on, as is any failure outside a behavior or placement.
+     */
+    void RecoverBatchFailure(int failCode, const char * file, unsigned lineno,
+                             void * const * backtraceArray, unsigned backtraceSize) ;
+
+    /**
+       Total bytes of cache protocol packets (including framing) that
+       this Tile's CacheProcessors have shipped to their neighbors.
+     */
+    u64 GetCacheBytesShipped() const
+    {
+      u64 total = 0;
+      for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+      {
+        total += m_cacheProcessors[d].GetBytesShipped();
+      }
+      return total;
+    }
+
     double GetAverageCacheRedundancy() const
     {
       u32 count = 0;
@@ -694,11 +1110,50 @@ namespace MFM
     }
 
     /**
-     * Flag that the atom counts in this tile may have changed
+     * Flag that the atom counts in this tile may have changed.  This
+     * is what writers that bypass PlaceAtomInSite call, so it also
+     * does NoteAllSitesChanged.
      */
     void NeedAtomRecount() const
     {
       m_cdata.NeedAtomRecount();
+      NoteAllSitesChanged();
+    }
+
+    /**
+     * The last change stamp this Tile issued.  A site written after
+     * this call is guaranteed to satisfy IsSiteChangedSince with the
+     * returned stamp.  Stamps are issued by whoever writes the tile,
+     * so (like atom counts) read them while it is paused.
+     */
+    u32 GetChangeStamp() const
+    {
+      return m_changeStamp;
+    }
+
+    /**
+     * Might the site numbered \c siteInTileNumber (see
+     * GetSiteInTileNumber, so cache sites included) have changed its
+     * event layer or base atom since GetChangeStamp() returned \c
+     * stamp?  Stamps wrap, so an answer is only trustworthy within
+     * 2**31 changes of \c stamp.
+     */
+    bool IsSiteChangedSince(u32 siteInTileNumber, u32 stamp) const
+    {
+      MFM_API_ASSERT_ARG(siteInTileNumber < TILE_WIDTH*TILE_HEIGHT);
+      return
+        (s32) (m_siteStamps[siteInTileNumber] - stamp) > 0 ||
+        (s32) (m_allSitesStamp - stamp) > 0;
+    }
+
+    /**
+     * Make every site of this tile satisfy IsSiteChangedSince for all
+     * stamps issued so far.  For writers that bypass
+     * PlaceAtomInSite.
+     */
+    void NoteAllSitesChanged() const
+    {
+      m_allSitesStamp = ++m_changeStamp;
     }
 
     CacheProcessor<EC> & GetCacheProcessor(Dir toCache) ;
@@ -812,6 +1267,8 @@ namespace MFM
     {
       CopyTileParameters(heroTile);
       SetWarpFactor(heroTile.GetWarpFactor());
+      SetEventBatchLimit(heroTile.GetEventBatchLimit());
+      SetSnapshotInterval(heroTile.GetSnapshotInterval());
       m_ucr = heroTile.m_ucr;
 
       const UlamClass<EC> * uempty = m_ucr.GetUlamElementEmpty();
@@ -821,6 +1278,7 @@ namespace MFM
         if (uelt)
         {
           m_elementTable.ReplaceEmptyElement(*uelt);
+          NeedAtomRecount();
         }
       }
     }
@@ -1052,6 +1510,15 @@ namespace MFM
      */
     bool IsLiveSite(const SPoint & location) const;
 
+    /**
+     * As IsLiveSite(const SPoint &), but by site-in-tile number.
+     */
+    bool IsLiveSite(u32 siteInTileNumber) const
+    {
+      MFM_API_ASSERT_ARG(siteInTileNumber < TILE_WIDTH*TILE_HEIGHT);
+      return (m_siteFlags[siteInTileNumber] & SITE_FLAG_LIVE) != 0;
+    }
+
     /**
      * Checks to see if a specified local point is a site that
      * currently might receive cache protocol updates in this
@@ -1201,8 +1668,17 @@ namespace MFM
      */
     const T GetAtomForEventWindow(const SPoint & pt) const
     {
-      const S & site = GetSite(pt);
-      T atom = site.GetAtom();
+      return GetAtomForEventWindow(GetSiteInTileNumber(pt));
+    }
+
+    /**
+     * Gets an Atom for an event window by site-in-tile number rather
+     * than by point; otherwise identical to
+     * GetAtomForEventWindow(const SPoint &).
+     */
+    const T GetAtomForEventWindow(u32 siteInTileNumber) const
+    {
+      T atom = GetAtomByNumber(siteInTileNumber);
       if (m_foregroundRadiationEnabled)
       {
         FAIL(INCOMPLETE_CODE);
@@ -1226,6 +1702,7 @@ namespace MFM
      */
     T* GetWritableAtom(const SPoint & pt)
     {
+      NeedAtomRecount();  // We can't see what the caller will write
       S & site = GetSite(pt);
       return &site.GetAtom();
     }
@@ -1259,7 +1736,7 @@ namespace MFM
      */
     const T* GetUncachedAtom(s32 x, s32 y) const
     {
-      return GetAtom(x + EVENT_WINDOW_RADIUS, y + EVENT_WINDOW_RADIUS);
+      return GetAtom(SPoint(x + EVENT_WINDOW_RADIUS, y + EVENT_WINDOW_RADIUS));
     }
 
     void SaveSite(const SPoint &siteInTile, ByteSink& bs, AtomTypeFormatter<AC> & atf) const
@@ -1269,6 +1746,7 @@ namespace MFM
 
     bool LoadSite(const SPoint &siteInTile, LineCountingByteSource& bs, AtomTypeFormatter<AC> & atf)
     {
+      NeedAtomRecount();
       return GetSite(siteInTile).LoadConfig(bs,atf);
     }
 
@@ -1507,6 +1985,7 @@ namespace MFM
     void RegisterElement(const Element<EC> & anElement)
     {
       m_elementTable.RegisterElement(anElement);
+      NeedAtomRecount();  // Atoms of this type were 'illegal' until now
     }
 
   public:
@@ -10,7 +10,7 @@
 namespace MFM
 {
   template <class EC>
-  Tile<EC>::Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, const u32 eventbuffersize, EventHistoryItem * items)
+  Tile<EC>::Tile(const u32 tileWidth, const u32 tileHeight, const GridLayoutPattern gridlayout, S * sites, T * atoms, u8 * siteFlags, u32 * siteStamps, const u32 eventbuffersize, EventHistoryItem * items)
     : TILE_WIDTH(tileWidth)
     , TILE_HEIGHT(tileHeight)
     , OWNED_WIDTH(TILE_WIDTH - 2 * EVENT_WINDOW_RADIUS)  // This OWNED_SIDE computation is duplicated in Grid.h!
@@ -18,6 +18,11 @@ namespace MFM
     , GRID_LAYOUT(gridlayout)
     , DUMMY_TILE(false)
     , m_sites(sites)
+    , m_atoms(atoms)
+    , m_siteFlags(siteFlags)
+    , m_siteStamps(siteStamps)
+    , m_changeStamp(0)
+    , m_allSitesStamp(0)
     , m_cdata(*this)
     , m_lockAttempts(0)
     , m_lockAttemptsSucceeded(0)
@@ -29,11 +34,29 @@ namespace MFM
     , m_foregroundRadiationEnabled(false)
     , m_requestedState(OFF)
     , m_warpFactor(3)
+    , m_eventBatchLimit(1)
+    , m_eventBatchSize(1)
+    , m_snapshotInterval(0)
+    , m_snapshotEvents(0)
     , m_eventHistoryBuffer(*this, eventbuffersize, items)
+    , m_eventPhaseProfile(0)
+    , m_elementProfile(0)
+    , m_cacheProfile(0)
+    , m_unwindBatched(false)
+    , m_unwindPhase(UNWIND_OTHER)
+    , m_placingAtom(0)
+    , m_placingType(0)
   {
     // TILE sides can't be too small, and we must apparently have sites, but not necessarily hidden ones.
     // Effort to avoid simultaneous locks in opposite directions (e.g. East and West);
     MFM_API_ASSERT_ARG(TILE_WIDTH >= 6*EVENT_WINDOW_RADIUS && TILE_HEIGHT >= 6*EVENT_WINDOW_RADIUS && m_sites != 0);
+    MFM_API_ASSERT_NONNULL(m_atoms);
+    MFM_API_ASSERT_NONNULL(m_siteFlags);
+    MFM_API_ASSERT_NONNULL(m_siteStamps);
+    for (u32 i = 0; i < TILE_WIDTH * TILE_HEIGHT; ++i)
+    {
+      m_siteStamps[i] = 0;
+    }
 
     // Require even TILE side dimensions.
     MFM_API_ASSERT_ARG(2 * TILE_WIDTH / 2 == TILE_WIDTH);
@@ -57,6 +80,8 @@ namespace MFM
 	MFM_API_ASSERT_STATE(counter == m_dirIterator.GetLimit());
       }
 
+    RebuildSiteFlags();
+
     Init();
   }
 
@@ -150,10 +175,12 @@ namespace MFM
   void Tile<EC>::XRay(u32 siteOdds, u32 bitOdds)
   {
     Random & random = GetRandom();
-    for(iterator_type i = beginAll(); i != endAll(); ++i) { // hitting caches too
+    const u32 sites = TILE_WIDTH * TILE_HEIGHT;
+    for (u32 sn = 0; sn < sites; ++sn) { // hitting caches too
       if (random.OneIn(siteOdds))
-        i->GetAtom().XRay(random, bitOdds);
+        GetWritableAtomByNumber(sn).XRay(random, bitOdds);
     }
+    NeedAtomRecount();
   }
 
   template <class EC>
@@ -164,6 +191,7 @@ namespace MFM
       if (random.OneIn(siteOdds))
         i->Clear();
     }
+    NeedAtomRecount();
   }
 
   template <class EC>
@@ -183,6 +211,31 @@ namespace MFM
     MFM_API_ASSERT_STATE(!cxn.IsConnected());
 
     cxn.ClaimCacheProcessor(*this, channel, lock, toCache);
+
+    // Liveness and reachability depend on connectivity
+    RebuildSiteFlags();
+  }
+
+  template <class EC>
+  void Tile<EC>::RebuildSiteFlags()
+  {
+    for (u32 y = 0; y < TILE_HEIGHT; ++y)
+    {
+      for (u32 x = 0; x < TILE_WIDTH; ++x)
+      {
+        SPoint pt(x, y);
+        u8 flags = 0;
+        if (ComputeIsLiveSite(pt))
+        {
+          flags |= SITE_FLAG_LIVE;
+        }
+        if (ComputeIsReachableViaCacheProtocol(pt))
+        {
+          flags |= SITE_FLAG_CACHE_REACHABLE;
+        }
+        m_siteFlags[y * TILE_WIDTH + x] = flags;
+      }
+    }
   }
 
   template <class EC>
@@ -223,14 +276,51 @@ namespace MFM
 
     m_illegalAtomCount = 0;
 
-    for(const_iterator_type i = m_tile.beginOwned(); i != m_tile.endOwned(); ++i) {
+    const u32 R = EVENT_WINDOW_RADIUS;
+    for (u32 y = R; y < m_tile.TILE_HEIGHT - R; ++y) {
+      const u32 row = y * m_tile.TILE_WIDTH;
+      for (u32 x = R; x < m_tile.TILE_WIDTH - R; ++x) {
+
+        u32 atype = m_tile.GetAtomByNumber(row + x).GetType();
+        s32 idx = m_tile.m_elementTable.GetIndex(atype);
+
+        if (idx < 0) ++m_illegalAtomCount;
+        else ++m_atomCount[idx];
+      }
+    }
+  }
+
+  template <class EC>
+  bool Tile<EC>::CountData::VerifyAtomCounts()
+  {
+    if (m_needRecount)
+    {
+      return true;  // Nothing incremental to check
+    }
+
+    // Take every owned atom back out of the counts, which should
+    // leave them all zero, then rescan to restore (or repair) them.
+    const u32 R = EVENT_WINDOW_RADIUS;
+    for (u32 y = R; y < m_tile.TILE_HEIGHT - R; ++y) {
+      const u32 row = y * m_tile.TILE_WIDTH;
+      for (u32 x = R; x < m_tile.TILE_WIDTH - R; ++x) {
 
-      u32 atype = i->GetAtom().GetType();
-      s32 idx = m_tile.m_elementTable.GetIndex(atype);
+        u32 atype = m_tile.GetAtomByNumber(row + x).GetType();
+        s32 idx = m_tile.m_elementTable.GetIndex(atype);
 
-      if (idx < 0) ++m_illegalAtomCount;
-      else ++m_atomCount[idx];
+        if (idx < 0) --m_illegalAtomCount;
+        else --m_atomCount[idx];
+      }
+    }
+
+    bool ok = (m_illegalAtomCount == 0);
+    for(u32 i = 0; ok && i < ELEMENT_TABLE_SIZE; i++)
+    {
+      ok = (m_atomCount[i] == 0);
     }
+
+    RecountAtoms();
+    return ok;
   }
 
   template <class EC>
@@ -504,50 +594,115 @@ namespace MFM
       return;
     }
 
-    Site<AC> & site = GetSite(pt);
+    S & site = GetSite(pt);
     T & oldAtom = placeInBase ? site.GetBase().GetBaseAtom() : site.GetAtom();
     T newAtom = atom;
+    if (m_unwindBatched)
+    {
+      // Our caller's unwind_protect covers this; see RecoverBatchFailure
+      const u32 priorPhase = m_unwindPhase;
+      m_unwindPhase = UNWIND_PLACING;
+      m_placingAtom = &oldAtom;
+      m_placingType = atom.GetType();
+      m_placingSite = pt;
+      WriteAtomInSite(placeInBase, site, oldAtom, newAtom, pt, doIdenticalCheck);
+      m_unwindPhase = priorPhase;
+      return;
+    }
+
     unwind_protect(
     {
       oldAtom.SetEmpty();
+      StampSite(pt);
       LOG.Warning("Tile %s: failure during place AtomInSite type %04x at (%2d,%2d) erased",
 		  this->GetLabel(),
 		  atom.GetType(),
 		  pt.GetX(), pt.GetY());
     },
     {
-      if(m_backgroundRadiationEnabled &&
-         m_random.OneIn(BACKGROUND_RADIATION_SITE_ODDS))
-      {
-        // Write fault!
-        newAtom.XRay(m_random, BACKGROUND_RADIATION_BIT_ODDS);
-      }
+      WriteAtomInSite(placeInBase, site, oldAtom, newAtom, pt, doIdenticalCheck);
+    });
+  }
 
-      bool owned = IsOwnedSite(pt);
+  template <class EC>
+  void Tile<EC>::WriteAtomInSite(bool placeInBase, S & site, T & oldAtom, T & newAtom,
+                                 const SPoint & pt, bool doIdenticalCheck)
+  {
+    if(m_backgroundRadiationEnabled &&
+       m_random.OneIn(BACKGROUND_RADIATION_SITE_ODDS))
+    {
+      // Write fault!
+      newAtom.XRay(m_random, BACKGROUND_RADIATION_BIT_ODDS);
+    }
+
+    bool owned = IsOwnedSite(pt);
 
-      if (oldAtom != newAtom)
-	{
-	  if(doIdenticalCheck)
+    if (oldAtom != newAtom)
+      {
+	if(doIdenticalCheck)
+	  {
+	    AtomSerializer<AC> oldas(oldAtom);
+	    AtomSerializer<AC> as(newAtom);
+
+	    LOG.Warning("Tile %s: doIdenticalCheck failure during place AtomInSite type [%04x/%@] was [%04x/%@] at (%2d,%2d)",
+			this->GetLabel(),
+			newAtom.GetType(), &as,
+			oldAtom.GetType(), &oldas,
+			pt.GetX(), pt.GetY());
+	  }
+	else
+	  {
+	    if (owned)
 	    {
-	      AtomSerializer<AC> oldas(oldAtom);
-	      AtomSerializer<AC> as(newAtom);
-
-	      LOG.Warning("Tile %s: doIdenticalCheck failure during place AtomInSite type [%04x/%@] was [%04x/%@] at (%2d,%2d)",
-			  this->GetLabel(),
-			  newAtom.GetType(), &as,
-			  oldAtom.GetType(), &oldas,
-			  pt.GetX(), pt.GetY());
+	      site.MarkChanged();
+	      if (!placeInBase)
+		m_cdata.ChangeAtomType(oldAtom.GetType(), newAtom.GetType());
 	    }
-	  else
-	    {
-	      NeedAtomRecount();
-	      if (owned)
-		site.MarkChanged();
 
-	      oldAtom = newAtom;
-	    }
-	}
-    });
+	    oldAtom = newAtom;
+	    StampSite(pt);
+	  }
+      }
+  }
+
+  template <class EC>
+  void Tile<EC>::RecoverBatchFailure(int failCode, const char * file, unsigned lineno,
+                                     void * const * backtraceArray, unsigned backtraceSize)
+  {
+    const u32 phase = m_unwindPhase;
+    m_unwindPhase = UNWIND_OTHER;
+
+    switch (phase)
+    {
+    case UNWIND_BEHAVING:
+      // Events happen only in AdvanceComputation, so finish the
+      // event, then the Advance it was in.  A computation batch ends
+      // early at the failed event.
+      m_window.RecoverFromBehaviorFailure(failCode, file, lineno, backtraceArray, backtraceSize);
+      m_window.FinishEvent();
+      if (m_eventBatchLimit > 1)
+      {
+        AdaptEventBatchSize();
+      }
+      FinishAdvance(ACTIVE);
+      return;
+
+    case UNWIND_PLACING:
+      m_placingAtom->SetEmpty();
+      StampSite(m_placingSite);
+      LOG.Warning("Tile %s: failure during place AtomInSite type %04x at (%2d,%2d) erased",
+		  this->GetLabel(),
+		  m_placingType,
+		  m_placingSite.GetX(), m_placingSite.GetY());
+      break;
+
+    default:
+      break;
+    }
+
+    LOG.Error("Tile %s: failure at %s:%d cannot be recovered here, passing it on",
+              this->GetLabel(), file, lineno);
+    FAIL_BY_NUMBER(failCode);
   }
 
   template <class EC>
@@ -560,6 +715,13 @@ namespace MFM
 
   template <class EC>
   bool Tile<EC>::IsReachableViaCacheProtocol(const SPoint & location) const
+  {
+    MFM_API_ASSERT_ARG(IsInTile(location));
+    return (GetSiteFlags(location) & SITE_FLAG_CACHE_REACHABLE) != 0;
+  }
+
+  template <class EC>
+  bool Tile<EC>::ComputeIsReachableViaCacheProtocol(const SPoint & location) const
   {
     if (!IsInShared(location))
     {
@@ -598,6 +760,12 @@ namespace MFM
 
   template <class EC>
   bool Tile<EC>::IsLiveSite(const SPoint & location) const
+  {
+    return (GetSiteFlags(location) & SITE_FLAG_LIVE) != 0;
+  }
+
+  template <class EC>
+  bool Tile<EC>::ComputeIsLiveSite(const SPoint & location) const
   {
     if (!IsInTile(location))
     {
@@ -620,7 +788,7 @@ namespace MFM
   }
 
   template <class EC>
-  typename Tile<EC>::Region Tile<EC>::RegionFromIndex(const u32 index, const u32 tileSide)
+  typename Tile<EC>::Region Tile<EC>::RegionFromIndex(const u32 index, const u32 tileSide) const
   {
     MFM_API_ASSERT_ARG(index < tileSide);
 
@@ -643,7 +811,7 @@ namespace MFM
   }
 
   template <class EC>
-  typename Tile<EC>::Region Tile<EC>::RegionIn(const SPoint& pt)
+  typename Tile<EC>::Region Tile<EC>::RegionIn(const SPoint& pt) const
   {
     return MIN(RegionFromIndex((u32)pt.GetX(), TILE_WIDTH),
                RegionFromIndex((u32)pt.GetY(), TILE_HEIGHT));
@@ -667,22 +835,79 @@ namespace MFM
     switch (curState)
     {
     case OFF:
-      break;
+      return false;
     case ACTIVE:
       didWork |= AdvanceComputation();
       MFM_LOG_DBG6(("Tile %s: AdvanceComputation->%d",
                     this->GetLabel(),
                     didWork));
-      // FALL THROUGH
+      break;
     case PASSIVE:
-      didWork |= AdvanceCommunication();
       break;
     default:
       FAIL(ILLEGAL_STATE);
     }
+
+    didWork |= FinishAdvance(curState);
     return didWork;
   }
 
+  template <class EC>
+  bool Tile<EC>::FinishAdvance(State curState)
+  {
+    bool didWork = AdvanceCommunication();
+
+    // Between events, so our owned atoms are consistent
+    if (m_snapshotInterval > 0 && curState == ACTIVE &&
+        (GetEventsExecuted() - m_snapshotEvents >= m_snapshotInterval ||
+         !m_snapshots.HasPublished()))
+    {
+      PublishSnapshot();
+    }
+    return didWork;
+  }
+
+  template <class EC>
+  void Tile<EC>::SetSnapshotInterval(u32 interval)
+  {
+    m_snapshotInterval = interval;
+    if (interval == 0)
+    {
+      m_snapshots.Deallocate();
+    }
+    else if (!m_snapshots.IsAllocated())
+    {
+      m_snapshots.Allocate(OWNED_WIDTH, OWNED_HEIGHT);
+    }
+  }
+
+  template <class EC>
+  void Tile<EC>::PublishSnapshot()
+  {
+    if (m_snapshotInterval == 0)
+    {
+      return;
+    }
+
+    T * atoms = m_snapshots.BeginPublish();
+    if (!atoms)
+    {
+      return;  // Readers are slow; try again next Advance
+    }
+
+    for (u32 y = 0; y < OWNED_HEIGHT; ++y)
+    {
+      const u32 row = (y + EVENT_WINDOW_RADIUS) * TILE_WIDTH + EVENT_WINDOW_RADIUS;
+      for (u32 x = 0; x < OWNED_WIDTH; ++x)
+      {
+        *atoms++ = GetAtomByNumber(row + x);
+      }
+    }
+
+    m_snapshotEvents = GetEventsExecuted();
+    m_snapshots.EndPublish(m_snapshotEvents);
+  }
+
   template <class EC>
   bool Tile<EC>::AllCacheProcessorsIdle()
   {
@@ -779,6 +1004,11 @@ namespace MFM
       return false;
     }
 
+    if (m_eventBatchLimit > 1)
+    {
+      return AdvanceComputationBatch();
+    }
+
     //INITIATE_EVENT,
     SPoint pt = GetRandomOwnedCoord(); //adjusted to range (0..Tile_Width, 0...Tile_Height)
     if (RegionIn(pt) == REGION_CACHE)
@@ -787,9 +1017,63 @@ namespace MFM
     return m_window.TryEventAt(pt);
   }
 
+  template <class EC>
+  bool Tile<EC>::AdvanceComputationBatch()
+  {
+    // Centers are drawn exactly as unbatched, so batching changes
+    // only how events interleave with communication, not where
+    // they happen.
+    bool didWork = false;
+    for (u32 i = 0; i < m_eventBatchSize; ++i)
+    {
+      SPoint pt = GetRandomOwnedCoord();
+      Region region = RegionIn(pt);
+      if (region == REGION_CACHE)
+        FAIL(ILLEGAL_STATE);
+
+      didWork |= m_window.TryEventAt(pt);
+
+      if (region != REGION_HIDDEN)
+      {
+        break;
+      }
+    }
+
+    AdaptEventBatchSize();
+    return didWork;
+  }
+
+  template <class EC>
+  void Tile<EC>::AdaptEventBatchSize()
+  {
+    if (HasCommunicationBacklog())
+    {
+      m_eventBatchSize = MAX(1u, m_eventBatchSize / 2);
+    }
+    else
+    {
+      m_eventBatchSize = MIN(m_eventBatchLimit, 2 * m_eventBatchSize);
+    }
+  }
+
+  template <class EC>
+  bool Tile<EC>::HasCommunicationBacklog()
+  {
+    for (u32 d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      CacheProcessor<EC> & cp = m_cacheProcessors[d];
+      if (cp.IsConnected() && cp.HasBacklog())
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
   template <class EC>
   bool Tile<EC>::AdvanceCommunication()
   {
+    u64 nanos = m_eventPhaseProfile ? GetMonotonicNanos() : 0;
     bool didWork = false;
     for (m_dirIterator.ShuffleOrReset(m_random); m_dirIterator.HasNext(); )
     {
@@ -799,6 +1083,10 @@ namespace MFM
       if(cp.IsConnected())
 	didWork |= cp.Advance();
     }
+    if (m_eventPhaseProfile)
+    {
+      m_eventPhaseProfile->Charge(EventPhaseProfile::PHASE_SHIP, nanos);
+    }
     return didWork;
   }
 
@@ -0,0 +1,199 @@
+/*                                              -*- mode:C++ -*-
+  TileSnapshots.h Published copies of a tile's atoms for observers
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file TileSnapshots.h Published copies of a tile's atoms for observers
+  \lgpl
+ */
+#ifndef TILESNAPSHOTS_H
+#define TILESNAPSHOTS_H
+
+#include "itype.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  /**
+   * TileSnapshots holds copies of a tile's owned atoms that its
+   * thread publishes between events, so observers (renderers,
+   * statistics) on other threads can read a consistent view of the
+   * tile without pausing it and without locks.
+   *
+   * There are three buffers.  One is the latest published snapshot;
+   * readers pin it by counting themselves into it, and the writer
+   * fills only a buffer that is neither published nor pinned, then
+   * publishes it.  With at most one buffer pinned by slow readers
+   * there is always a free one; if readers hold two, the writer just
+   * skips that publication.
+   *
+   * Each snapshot records its epoch: the tile's executed event count
+   * when it was taken.  There is a single writer, the tile's own
+   * thread (or anyone, while the tile is not running).
+   */
+  template <class T>
+  class TileSnapshots
+  {
+  public:
+    enum
+    {
+      BUFFERS = 3,
+      NONE = BUFFERS   //< m_published before the first publication
+    };
+
+    /**
+     * A Reader pins the latest published snapshot, if any, for as
+     * long as it exists, and reads atoms from it.  Keep Readers
+     * short-lived, since a pinned buffer can't be reused.
+     */
+    class Reader
+    {
+    public:
+      Reader(const TileSnapshots & snapshots)
+        : m_snapshots(snapshots)
+        , m_buffer(snapshots.Pin())
+      { }
+
+      ~Reader()
+      {
+        m_snapshots.Unpin(m_buffer);
+      }
+
+      /**
+       * False if nothing had been published when this Reader was made
+       */
+      bool IsValid() const
+      {
+        return m_buffer != NONE;
+      }
+
+      /**
+       * The tile's executed event count when this snapshot was taken
+       */
+      u64 GetEpoch() const
+      {
+        MFM_API_ASSERT_STATE(IsValid());
+        return m_snapshots.m_epochs[m_buffer];
+      }
+
+      /**
+       * The atom at owned site (\c x, \c y), in the same coordinates
+       * as Tile::GetUncachedAtom
+       */
+      const T & GetAtom(u32 x, u32 y) const
+      {
+        MFM_API_ASSERT_STATE(IsValid());
+        MFM_API_ASSERT_ARG(x < m_snapshots.m_width && y < m_snapshots.m_height);
+        return m_snapshots.m_atoms[m_buffer][y * m_snapshots.m_width + x];
+      }
+
+    private:
+      const TileSnapshots & m_snapshots;
+      const u32 m_buffer;
+
+      Reader(const Reader &) ;               // Declare away copy ctor
+      Reader & operator=(const Reader &) ;   // and assignment
+    };
+
+    TileSnapshots()
+      : m_width(0)
+      , m_height(0)
+      , m_published(NONE)
+      , m_filling(NONE)
+    {
+      for (u32 i = 0; i < BUFFERS; ++i)
+      {
+        m_atoms[i] = 0;
+        m_epochs[i] = 0;
+        m_readers[i] = 0;
+      }
+    }
+
+    ~TileSnapshots()
+    {
+      Deallocate();
+    }
+
+    /**
+     * Make room for \c width by \c height atoms per snapshot,
+     * discarding anything published.  Call only while no Readers
+     * exist.
+     */
+    void Allocate(u32 width, u32 height) ;
+
+    /**
+     * Free the buffers.  Call only while no Readers exist.
+     */
+    void Deallocate() ;
+
+    bool IsAllocated() const
+    {
+      return m_atoms[0] != 0;
+    }
+
+    bool HasPublished() const
+    {
+      return __atomic_load_n(&m_published, __ATOMIC_ACQUIRE) != NONE;
+    }
+
+    /**
+     * Claim a free buffer for the writer to fill with width*height
+     * atoms, in row-major order, and return it, or return null if
+     * Readers have pinned all the unpublished buffers.
+     */
+    T * BeginPublish() ;
+
+    /**
+     * Publish the buffer from the last successful BeginPublish as the
+     * snapshot as of \c epoch.
+     */
+    void EndPublish(u64 epoch) ;
+
+  private:
+    u32 m_width;
+    u32 m_height;
+    T * m_atoms[BUFFERS];
+    u64 m_epochs[BUFFERS];
+
+    mutable u32 m_readers[BUFFERS];  //< __atomic access
+    u32 m_published;                 //< __atomic access
+    u32 m_filling;                   //< Writer only
+
+    /**
+     * Count a reader into the published buffer and return its index,
+     * or NONE if nothing is published
+     */
+    u32 Pin() const ;
+
+    void Unpin(u32 buffer) const
+    {
+      if (buffer != NONE)
+      {
+        __atomic_fetch_sub(&m_readers[buffer], 1, __ATOMIC_RELEASE);
+      }
+    }
+
+    TileSnapshots(const TileSnapshots &) ;               // Declare away copy ctor
+    TileSnapshots & operator=(const TileSnapshots &) ;   // and assignment
+  };
+} /* namespace MFM */
+
+#include "TileSnapshots.tcc"
+
+#endif /* TILESNAPSHOTS_H */
@@ -0,0 +1,86 @@
+/* -*- C++ -*- */
+
+namespace MFM
+{
+  template <class T>
+  void TileSnapshots<T>::Allocate(u32 width, u32 height)
+  {
+    MFM_API_ASSERT_ARG(width > 0 && height > 0);
+    Deallocate();
+    m_width = width;
+    m_height = height;
+    for (u32 i = 0; i < BUFFERS; ++i)
+    {
+      m_atoms[i] = new T[width * height];
+    }
+  }
+
+  template <class T>
+  void TileSnapshots<T>::Deallocate()
+  {
+    for (u32 i = 0; i < BUFFERS; ++i)
+    {
+      MFM_API_ASSERT_STATE(__atomic_load_n(&m_readers[i], __ATOMIC_ACQUIRE) == 0);
+      delete [] m_atoms[i];
+      m_atoms[i] = 0;
+      m_epochs[i] = 0;
+    }
+    m_width = m_height = 0;
+    m_filling = NONE;
+    __atomic_store_n(&m_published, (u32) NONE, __ATOMIC_RELEASE);
+  }
+
+  template <class T>
+  T * TileSnapshots<T>::BeginPublish()
+  {
+    MFM_API_ASSERT_STATE(IsAllocated());
+
+    // Only we store m_published.  A reader that pins a buffer after
+    // we find it unpinned will see it is no longer published, and
+    // let go before reading it (see Pin).
+    const u32 published = __atomic_load_n(&m_published, __ATOMIC_RELAXED);
+    for (u32 i = 0; i < BUFFERS; ++i)
+    {
+      if (i != published && __atomic_load_n(&m_readers[i], __ATOMIC_SEQ_CST) == 0)
+      {
+        m_filling = i;
+        return m_atoms[i];
+      }
+    }
+    m_filling = NONE;
+    return 0;
+  }
+
+  template <class T>
+  void TileSnapshots<T>::EndPublish(u64 epoch)
+  {
+    MFM_API_ASSERT_STATE(m_filling != NONE);
+    m_epochs[m_filling] = epoch;
+    __atomic_store_n(&m_published, m_filling, __ATOMIC_SEQ_CST);
+    m_filling = NONE;
+  }
+
+  template <class T>
+  u32 TileSnapshots<T>::Pin() const
+  {
+    while (true)
+    {
+      u32 buffer = __atomic_load_n(&m_published, __ATOMIC_SEQ_CST);
+      if (buffer == NONE)
+      {
+        return NONE;
+      }
+
+      __atomic_fetch_add(&m_readers[buffer], 1, __ATOMIC_SEQ_CST);
+
+      // Still published after we counted in: whatever the writer
+      // put there is complete, and it won't choose this buffer
+      // again until we let go
+      if (__atomic_load_n(&m_published, __ATOMIC_SEQ_CST) == buffer)
+      {
+        return buffer;
+      }
+      __atomic_fetch_sub(&m_readers[buffer], 1, __ATOMIC_RELEASE);
+    }
+  }
+} /* namespace MFM */
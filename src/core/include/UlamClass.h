@@ -242,6 +242,16 @@ namespace MFM
      */
     static bool IsMethod(const UlamContext<EC>& uc, u32 type, const UlamClass<EC> * classPtr);
 
+    /**
+       Discover if \c classPtr is \c elt or one of its ancestors.
+       Answered by a bit test in the is-a matrix of \c uc's
+       UlamClassRegistry when it has one covering both classes, and by
+       elt.internalCMethodImplementingIs otherwise.
+
+       \sa UlamClassRegistry::IsA
+     */
+    static bool IsA(const UlamContext<EC>& uc, const UlamClass<EC> & elt, const UlamClass<EC> * classPtr);
+
 
     typedef void (*VfuncPtr)(); // Generic function pointer we'll cast at point of use
 
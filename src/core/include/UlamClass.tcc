@@ -26,9 +26,20 @@ namespace MFM {
   {
     const UlamElement<EC> * ueltptr = (UlamElement<EC> *) uc.LookupElementTypeFromContext(type);
     if (!ueltptr) return false;
-    return ueltptr->internalCMethodImplementingIs(classPtr);
+    return IsA(uc, *ueltptr, classPtr);
   } //IsMethod (static)
 
+  template <class EC>
+  bool UlamClass<EC>::IsA(const UlamContext<EC>& uc, const UlamClass<EC> & elt, const UlamClass<EC> * classPtr)
+  {
+    if (classPtr && uc.HasUlamClassRegistry())
+    {
+      s32 isa = uc.GetUlamClassRegistry().IsA(elt, *classPtr);
+      if (isa >= 0) return isa > 0;
+    }
+    return elt.internalCMethodImplementingIs(classPtr);
+  } //IsA (static)
+
   typedef void (*VfuncPtr)(); // Generic function pointer we'll cast at point of use
   template <class EC>
   VfuncPtr UlamClass<EC>::GetVTableEntry(const UlamContext<EC>& uc, u32 atype, u32 idx)
@@ -39,14 +39,22 @@ namespace MFM {
   template <class EC>
   struct UlamClassRegistry {
     enum {
-      TABLE_SIZE = 1000
+      TABLE_SIZE = 1000,
+      MAX_ISA_ELEMENTS = 256,                // Elements beyond this fall back to internalCMethodImplementingIs
+      ISA_WORDS = (TABLE_SIZE + 31) / 32,
+      MANGLED_NAME_HASH_SIZE = 2003          // Prime, about 2 * TABLE_SIZE
     };
 
     UlamClassRegistry()
       : m_registeredUlamClassCount(0)
       , m_ulamElementEmpty(0)
+      , m_isARowCount(0)
     {
       for(u32 i = 0; i < TABLE_SIZE; i++) m_registeredUlamClasses[i] = 0;
+      for(u32 i = 0; i < TABLE_SIZE; i++) m_isARow[i] = 0;
+      for(u32 i = 0; i < MANGLED_NAME_HASH_SIZE; i++) m_mangledNameHash[i] = 0;
+      for(u32 i = 0; i < MAX_ISA_ELEMENTS; i++)
+        for(u32 w = 0; w < ISA_WORDS; w++) m_isA[i][w] = 0;
     }
 
     bool RegisterUlamClass(UlamClass<EC>& uc) ;
@@ -68,10 +76,40 @@ namespace MFM {
 
     const UlamClass<EC> * GetUlamElementEmpty() const { return m_ulamElementEmpty; }
 
+    /**
+       Look up whether \c cls is \c elt or one of its ancestors, in
+       the is-a matrix built as classes register.
+
+       @returns 1 if it is, 0 if it is not, or -1 if the matrix cannot
+       say -- because either class is not registered here, or \c elt
+       registered after MAX_ISA_ELEMENTS other elements -- in which
+       case the caller should ask elt.internalCMethodImplementingIs
+     */
+    s32 IsA(const UlamClass<EC> & elt, const UlamClass<EC> & cls) const ;
+
     UlamClass<EC> * m_registeredUlamClasses[TABLE_SIZE];
     u32 m_registeredUlamClassCount;
 
     UlamClass<EC> * m_ulamElementEmpty;
+
+  private:
+    static u32 HashMangledName(const char * mangledName) ;
+
+    s32 FindMangledName(const char * mangledName) const ;
+
+    void InsertMangledName(u32 regnum) ;
+
+    void UpdateIsAMatrix(UlamClass<EC> & uc, u32 regnum) ;
+
+    /** 1 + the registration number of a class, or 0 if empty */
+    u16 m_mangledNameHash[MANGLED_NAME_HASH_SIZE];
+
+    /** 1 + the m_isA row of the UlamElement with that registration number, or 0 */
+    u16 m_isARow[TABLE_SIZE];
+    u32 m_isARowCount;
+
+    /** Bit r of row m_isARow[e]-1 is set iff class r is element e or an ancestor of it */
+    u32 m_isA[MAX_ISA_ELEMENTS][ISA_WORDS];
   };
 
 } //MFM
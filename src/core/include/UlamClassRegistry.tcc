@@ -9,6 +9,10 @@ namespace MFM {
   {
     if (!mangledName) FAIL(NULL_POINTER);
 
+    s32 found = FindMangledName(mangledName);
+    if (found >= 0)
+      return found;
+
     // HACK: If mangledName is an array type, we need to get the
     // mangled name representing the underlying scalar type, for
     // lookup purposes.
@@ -22,20 +26,92 @@ namespace MFM {
       uti.MakeScalar();                // Stomp out the array length
       uti.PrintMangled(scalarName);    // Convert back to mangled name
       mangledName = scalarName.GetZString(); // Update pointer
+      return FindMangledName(mangledName);
     }
 
-    for (u32 i = 0; i < m_registeredUlamClassCount; ++i)
+    return -1;
+  }
+
+  template <class EC>
+  u32 UlamClassRegistry<EC>::HashMangledName(const char * mangledName)
+  {
+    u32 hash = 2166136261u;   // FNV-1a
+    for (const char * p = mangledName; *p; ++p)
     {
-      UlamClass<EC> * uc = m_registeredUlamClasses[i];
-      if (!uc) continue; //continguous after all classes register
+      hash ^= (u8) *p;
+      hash *= 16777619u;
+    }
+    return hash;
+  }
 
-      const char * mang = uc->GetMangledClassName();
-      if (!strcmp(mang, mangledName))
-        return (s32) i;
+  template <class EC>
+  s32 UlamClassRegistry<EC>::FindMangledName(const char * mangledName) const
+  {
+    u32 slot = HashMangledName(mangledName) % MANGLED_NAME_HASH_SIZE;
+    while (m_mangledNameHash[slot] != 0)
+    {
+      u32 regnum = m_mangledNameHash[slot] - 1u;
+      if (!strcmp(m_registeredUlamClasses[regnum]->GetMangledClassName(), mangledName))
+        return (s32) regnum;
+      slot = (slot + 1) % MANGLED_NAME_HASH_SIZE;
     }
     return -1;
   }
 
+  template <class EC>
+  void UlamClassRegistry<EC>::InsertMangledName(u32 regnum)
+  {
+    const char * mangledName = m_registeredUlamClasses[regnum]->GetMangledClassName();
+    if (FindMangledName(mangledName) >= 0)
+      return;  // Keep the existing entry for a duplicated name
+
+    u32 slot = HashMangledName(mangledName) % MANGLED_NAME_HASH_SIZE;
+    while (m_mangledNameHash[slot] != 0)
+      slot = (slot + 1) % MANGLED_NAME_HASH_SIZE;
+    m_mangledNameHash[slot] = (u16) (regnum + 1);
+  }
+
+  template <class EC>
+  void UlamClassRegistry<EC>::UpdateIsAMatrix(UlamClass<EC> & uc, u32 regnum)
+  {
+    // The new class as a possible ancestor of each element so far
+    for (u32 i = 0; i < m_registeredUlamClassCount; ++i)
+    {
+      if (!m_isARow[i] || i == regnum) continue;
+      if (m_registeredUlamClasses[i]->internalCMethodImplementingIs(&uc))
+        m_isA[m_isARow[i] - 1][regnum / 32] |= 1u << (regnum % 32);
+    }
+
+    // And if it is an element, its own row against everything so far
+    if (!uc.AsUlamElement() || m_isARowCount >= MAX_ISA_ELEMENTS)
+      return;
+
+    u32 row = m_isARowCount++;
+    m_isARow[regnum] = (u16) (row + 1);
+
+    for (u32 i = 0; i < m_registeredUlamClassCount; ++i)
+    {
+      UlamClass<EC> * other = m_registeredUlamClasses[i];
+      if (other && uc.internalCMethodImplementingIs(other))
+        m_isA[row][i / 32] |= 1u << (i % 32);
+    }
+  }
+
+  template <class EC>
+  s32 UlamClassRegistry<EC>::IsA(const UlamClass<EC> & elt, const UlamClass<EC> & cls) const
+  {
+    const u32 eltnum = elt.GetRegistrationNumber();
+    const u32 clsnum = cls.GetRegistrationNumber();
+    if (eltnum >= m_registeredUlamClassCount || clsnum >= m_registeredUlamClassCount)
+      return -1;
+    if (m_registeredUlamClasses[eltnum] != &elt || m_registeredUlamClasses[clsnum] != &cls)
+      return -1;
+    const u32 row = m_isARow[eltnum];
+    if (!row)
+      return -1;
+    return (m_isA[row - 1][clsnum / 32] >> (clsnum % 32)) & 1;
+  }
+
   template <class EC>
   bool UlamClassRegistry<EC>::RegisterUlamClass(UlamClass<EC>& uc)
   {
@@ -59,6 +135,9 @@ namespace MFM {
     if(myregnum >= m_registeredUlamClassCount)
       m_registeredUlamClassCount = myregnum + 1; //max + 1
 
+    InsertMangledName(myregnum);
+    UpdateIsAMatrix(uc, myregnum);
+
     return true;
   }
 
@@ -144,7 +144,12 @@ namespace MFM {
       GETCOLOR_VTABLE_INDEX = 1
     };
 
-    UlamElement(const UUID & uuid) : Element<EC>(uuid) { }
+    UlamElement(const UUID & uuid) : Element<EC>(uuid)
+    {
+      // getColor is costly and, in practice, a function of the atom
+      // and the model parameters
+      this->SetCachingAtomColors(true);
+    }
 
     virtual ~UlamElement() { }
 
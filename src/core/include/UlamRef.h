@@ -82,6 +82,10 @@ namespace MFM
 
     void WriteLong(u64 val) { m_stg.WriteLong(m_pos, m_len, val); }
 
+    BV96 ReadBig() const { return m_stg.ReadBig(m_pos, m_len); }
+
+    void WriteBig(const BV96& val) { m_stg.WriteBig(m_pos, m_len, val); }
+
     T ReadAtom() const
     {
       if (m_usage == ATOMIC) return m_stg.ReadAtom(m_pos);
@@ -162,6 +166,76 @@ namespace MFM
 
   }; //UlamRef
 
+  /**
+     An UlamRef whose storage class \c STG -- AtomBitStorage<EC>,
+     AtomRefBitStorage<EC>, or some BitVectorBitStorage<EC,BV> -- is
+     known at compile time.  Its Read and Write accessors operate
+     directly, and inline, on the BitVector inside \c STG, rather
+     than through the virtual BitStorage<EC> interface.
+
+     Generated code that knows where its bits live can declare its
+     refs as UlamRefTyped to opt in.  An UlamRefTyped is still an
+     UlamRef, and can be passed anywhere one is expected, but
+     accesses made through a plain UlamRef<EC>& take the virtual
+     path as before.
+   */
+  template <class EC, class STG>
+  class UlamRefTyped : public UlamRef<EC>
+  {
+  public:
+    typedef UlamRef<EC> Super;
+    typedef typename Super::UsageType UsageType;
+    typedef typename STG::STORAGE_BV BV;
+
+    UlamRefTyped(u32 pos, u32 len, STG& stg, const UlamClass<EC> * effself,
+                 const UsageType usage, const UlamContext<EC> & uc)
+      : Super(pos, len, stg, effself, usage, uc)
+      , m_bits(stg.GetBitVector())
+    { }
+
+    UlamRefTyped(const UlamRefTyped<EC,STG> & existing, s32 pos, u32 len,
+                 const UlamClass<EC> * effself, const UsageType usage)
+      : Super(existing, pos, len, effself, usage)
+      , m_bits(existing.m_bits)
+    { }
+
+    UlamRefTyped(const UlamRefTyped<EC,STG> & existing, u32 len)
+      : Super(existing, len)
+      , m_bits(existing.m_bits)
+    { }
+
+    u32 Read() const { return m_bits.Read(this->GetPos(), this->GetLen()); }
+
+    void Write(u32 val) { m_bits.Write(this->GetPos(), this->GetLen(), val); }
+
+    u64 ReadLong() const { return m_bits.ReadLong(this->GetPos(), this->GetLen()); }
+
+    void WriteLong(u64 val) { m_bits.WriteLong(this->GetPos(), this->GetLen(), val); }
+
+    BV96 ReadBig() const { return m_bits.ReadBig(this->GetPos(), this->GetLen()); }
+
+    void WriteBig(const BV96& val) { m_bits.WriteBig(this->GetPos(), this->GetLen(), val); }
+
+    template<u32 LEN>
+    void ReadBV(u32 pos, BitVector<LEN>& rtnbv) const
+    {
+      m_bits.CopyBV(pos + this->GetPos(), 0, LEN, rtnbv);
+    }
+
+    template<u32 LEN>
+    void WriteBV(u32 pos, const BitVector<LEN>& val)
+    {
+      val.CopyBV(0, pos + this->GetPos(), LEN, m_bits);
+    }
+
+  private:
+    // Declare away copy ctor
+    UlamRefTyped(const UlamRefTyped<EC,STG> & existing) ;
+
+    BV & m_bits;
+
+  }; //UlamRefTyped
+
   template <class EC, u32 POS, u32 LEN>
   struct UlamRefFixed : public UlamRef<EC>
   {
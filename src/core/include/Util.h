@@ -431,6 +431,32 @@ namespace MFM {
    */
   extern void Sleep(u32 seconds, u64 nanos) ;
 
+  /**
+   * Gets the current value of a monotonic clock, in nanoseconds
+   * since some unspecified starting point.  Only differences between
+   * two values are meaningful.
+   *
+   * @returns The current monotonic time in nanoseconds.
+   */
+  extern u64 GetMonotonicNanos() ;
+
+  /**
+   * Gets a cheap, fine-grained tick count for timing short intervals:
+   * the processor time stamp counter where there is one, otherwise
+   * GetMonotonicNanos().  Only differences between two values read on
+   * the same thread are meaningful.
+   *
+   * @returns The current tick count.
+   */
+  inline u64 GetCycleCount()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return GetMonotonicNanos();
+#endif
+  }
+
   /**
    * Pauses the calling thread for more or less a specified number of
    * milliseconds.
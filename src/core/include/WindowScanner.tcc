@@ -54,42 +54,13 @@ namespace MFM
   template <class EC>
   bool WindowScanner<EC>::CanSeeAtomOfType(const u32 type, const u32 radius) const
   {
-    const MDist<R>& md = MDist<R>::get();
-
-    MFM_API_ASSERT_ARG(radius != 0 && radius <= R);
-
-    for(u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
-    {
-      if(m_win.IsLiveSiteDirect(md.GetPoint(i)))
-      {
-        if(m_win.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == type)
-        {
-          return true;
-        }
-      }
-    }
-    return false;
+    return m_win.HasSiteOfType(type, radius);
   }
 
   template <class EC>
   u32 WindowScanner<EC>::CountAtomsOfType(const u32 type, const u32 radius) const
   {
-    const MDist<R>& md = MDist<R>::get();
-    u32 atomCount = 0;
-
-    MFM_API_ASSERT_ARG(radius != 0 && radius <= R);
-
-    for(u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
-    {
-      if(m_win.IsLiveSiteDirect(md.GetPoint(i)))
-      {
-        if(m_win.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == type)
-        {
-          atomCount++;
-        }
-      }
-    }
-    return atomCount;
+    return m_win.CountSitesOfType(type, radius);
   }
 
   template <class EC>
@@ -186,26 +157,13 @@ namespace MFM
                                                   const u32 radius,
                                                   SPoint& outPoint) const
   {
-    const MDist<R>& md = MDist<R>::get();
-    u32 foundPts = 0;
-
-    MFM_API_ASSERT_ARG(radius != 0 && radius <= R);
-
-    for(u32 i = md.GetFirstIndex(1); i <= md.GetLastIndex(radius); i++)
+    u32 siteNumber = 0;
+    u32 foundPts = m_win.PickSiteOfType(type, radius, siteNumber);
+    if(foundPts > 0)
     {
-      if(m_win.IsLiveSiteDirect(md.GetPoint(i)))
-      {
-        if(m_win.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == type)
-        {
-          foundPts++;
-          if(m_rand.OneIn(foundPts))
-          {
-            outPoint.Set(md.GetPoint(i));
-          }
-        }
-      }
+      outPoint.Set(MDist<R>::get().GetPoint(siteNumber));
     }
-  return foundPts;
+    return foundPts;
   }
 
   template <class EC>
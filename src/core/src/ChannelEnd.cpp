@@ -1,5 +1,6 @@
 #include "ChannelEnd.h"
 #include "PacketIO.h"
+#include "Util.h"  // For MIN
 
 namespace MFM
 {
@@ -15,30 +16,53 @@ namespace MFM
   PacketBuffer * ChannelEnd::ReceivePacket()
   {
     // Step 1: If a packet has not been started, try to start it
-    if (m_packetLength < 0)
+    if (m_packetLength == NO_PACKET)
     {
       s32 byte = ReadByte();
       if (byte < 0)
       {
         return 0;              // Nothing there..
       }
-      m_packetLength = byte;   // OK, packet started!
+      if (byte == PacketFraming::EXTENDED_LENGTH)
+      {
+        m_packetLength = EXTENDED_LENGTH_PENDING;
+      }
+      else
+      {
+        m_packetLength = byte;   // OK, packet started!
+        m_packetBuffer.Reset();
+      }
+    }
+
+    // Step 1.5: If a long packet has been started, get its real length
+    if (m_packetLength == EXTENDED_LENGTH_PENDING)
+    {
+      u8 len[2];
+      if (CanRead() < sizeof(len))
+      {
+        return 0;              // Split length.  Later.
+      }
+      Read(len, sizeof(len));
+      m_packetLength = len[0] | (len[1] << 8);
+      MFM_API_ASSERT((u32) m_packetLength <= m_packetBuffer.GetCapacity(), OUT_OF_ROOM);
       m_packetBuffer.Reset();
     }
 
     // Step 2: If a packet is not yet finished, try to read enough to finish it
     while (m_packetBuffer.GetLength() < (u32) m_packetLength)
     {
-      s32 byte = ReadByte();
-      if (byte < 0)
+      u8 chunk[256];
+      u32 want = MIN((u32) sizeof(chunk), (u32) m_packetLength - m_packetBuffer.GetLength());
+      u32 got = Read(chunk, want);
+      if (got == 0)
       {
         return 0;              // Split packet.  Well damn.  Later.
       }
-      m_packetBuffer.Print((u32) byte, Format::BYTE);
+      m_packetBuffer.WriteBytes(chunk, got);
     }
 
     // Step 3: Privately mark packet done; let caller see what we got
-    m_packetLength = -1;
+    m_packetLength = NO_PACKET;
     return & m_packetBuffer;
   }
 }
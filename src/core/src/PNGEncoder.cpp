@@ -0,0 +1,240 @@
+#include "PNGEncoder.h"
+#include "Fail.h"
+
+namespace MFM
+{
+  namespace
+  {
+    /**
+     * Deflate's LSB-first bit stream
+     */
+    class BitWriter
+    {
+      u8 * m_out;
+      u32 m_bytes;
+      u32 m_bits;
+      u32 m_bitCount;
+
+    public:
+      BitWriter(u8 * out)
+        : m_out(out)
+        , m_bytes(0)
+        , m_bits(0)
+        , m_bitCount(0)
+      { }
+
+      void WriteBits(u32 value, u32 count)
+      {
+        m_bits |= value << m_bitCount;
+        m_bitCount += count;
+        while (m_bitCount >= 8)
+        {
+          m_out[m_bytes++] = (u8) m_bits;
+          m_bits >>= 8;
+          m_bitCount -= 8;
+        }
+      }
+
+      /** Huffman codes are sent most significant bit first */
+      void WriteCode(u32 code, u32 count)
+      {
+        u32 reversed = 0;
+        for (u32 i = 0; i < count; ++i)
+        {
+          reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        WriteBits(reversed, count);
+      }
+
+      u32 Flush()
+      {
+        if (m_bitCount > 0)
+        {
+          m_out[m_bytes++] = (u8) m_bits;
+          m_bits = 0;
+          m_bitCount = 0;
+        }
+        return m_bytes;
+      }
+    };
+
+    /** Send literal/length symbol \c sym with the fixed Huffman codes */
+    void WriteFixedSymbol(BitWriter & bw, u32 sym)
+    {
+      if (sym < 144)      bw.WriteCode(0x30 + sym, 8);
+      else if (sym < 256) bw.WriteCode(0x190 + sym - 144, 9);
+      else if (sym < 280) bw.WriteCode(sym - 256, 7);
+      else                bw.WriteCode(0xc0 + sym - 280, 8);
+    }
+
+    const u32 LENGTH_BASE[29] = {
+      3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+
+    const u32 LENGTH_EXTRA[29] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+
+    /** Send a match of \c length (3..258) bytes at distance 1 */
+    void WriteRun(BitWriter & bw, u32 length)
+    {
+      u32 code = 28;
+      while (LENGTH_BASE[code] > length)
+      {
+        --code;
+      }
+      WriteFixedSymbol(bw, 257 + code);
+      bw.WriteBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+      bw.WriteCode(0, 5);  // Distance code 0: distance 1
+    }
+
+    void WriteU32BE(u8 * out, u32 value)
+    {
+      out[0] = (u8) (value >> 24);
+      out[1] = (u8) (value >> 16);
+      out[2] = (u8) (value >> 8);
+      out[3] = (u8) value;
+    }
+  }
+
+  u32 PNGEncoder::CRC32(const u8 * data, u32 length, u32 crc)
+  {
+    crc = ~crc;
+    for (u32 i = 0; i < length; ++i)
+    {
+      crc ^= data[i];
+      for (u32 b = 0; b < 8; ++b)
+      {
+        crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+      }
+    }
+    return ~crc;
+  }
+
+  u32 PNGEncoder::Adler32(const u8 * data, u32 length, u32 adler)
+  {
+    const u32 MOD_ADLER = 65521;
+    u32 a = adler & 0xffff;
+    u32 b = adler >> 16;
+    while (length > 0)
+    {
+      u32 chunk = length < 5552 ? length : 5552;  // Largest that can't overflow b
+      length -= chunk;
+      while (chunk-- > 0)
+      {
+        a += *data++;
+        b += a;
+      }
+      a %= MOD_ADLER;
+      b %= MOD_ADLER;
+    }
+    return (b << 16) | a;
+  }
+
+  u32 PNGEncoder::Deflate(const u8 * data, u32 length, u8 * out)
+  {
+    out[0] = 0x78;  // Deflate, 32K window
+    out[1] = 0x01;  // No dictionary, fastest; (0x7801 % 31) == 0
+
+    BitWriter bw(out + 2);
+    bw.WriteBits(1, 1);  // BFINAL: this is the only block
+    bw.WriteBits(1, 2);  // BTYPE 01: fixed Huffman codes
+
+    u32 i = 0;
+    while (i < length)
+    {
+      u32 run = 0;
+      if (i > 0)
+      {
+        const u8 prev = data[i - 1];
+        while (run < 258 && i + run < length && data[i + run] == prev)
+        {
+          ++run;
+        }
+      }
+
+      if (run >= 3)
+      {
+        WriteRun(bw, run);
+        i += run;
+      }
+      else
+      {
+        WriteFixedSymbol(bw, data[i]);
+        ++i;
+      }
+    }
+    WriteFixedSymbol(bw, 256);  // End of block
+
+    u32 used = 2 + bw.Flush();
+    WriteU32BE(out + used, Adler32(data, length));
+    return used + 4;
+  }
+
+  void PNGEncoder::WriteChunk(ByteSink & sink, const char * type, const u8 * data, u32 length)
+  {
+    u8 word[4];
+    WriteU32BE(word, length);
+    sink.WriteBytes(word, 4);
+    sink.WriteBytes((const u8 *) type, 4);
+    if (length > 0)
+    {
+      sink.WriteBytes(data, length);
+    }
+
+    u32 crc = CRC32((const u8 *) type, 4);
+    crc = CRC32(data, length, crc);
+    WriteU32BE(word, crc);
+    sink.WriteBytes(word, 4);
+  }
+
+  void PNGEncoder::WriteRGB(ByteSink & sink, const u32 * argb, u32 width, u32 height)
+  {
+    MFM_API_ASSERT_ARG(width > 0 && height > 0);
+    MFM_API_ASSERT_NONNULL(argb);
+
+    // Filter type byte plus RGB for each row, Sub-filtered: each byte
+    // less the same channel of the pixel to its left
+    const u32 rowBytes = 1 + 3 * width;
+    const u32 rawLength = rowBytes * height;
+    u8 * raw = new u8[rawLength];
+    for (u32 y = 0; y < height; ++y)
+    {
+      u8 * row = raw + y * rowBytes;
+      const u32 * pixels = argb + y * width;
+      row[0] = 1;  // Sub
+      u32 left = 0;
+      for (u32 x = 0; x < width; ++x)
+      {
+        u32 p = pixels[x];
+        row[1 + 3 * x + 0] = (u8) ((p >> 16) - (left >> 16));
+        row[1 + 3 * x + 1] = (u8) ((p >> 8) - (left >> 8));
+        row[1 + 3 * x + 2] = (u8) (p - left);
+        left = p;
+      }
+    }
+
+    u8 * deflated = new u8[GetMaxDeflatedLength(rawLength)];
+    u32 deflatedLength = Deflate(raw, rawLength, deflated);
+    delete [] raw;
+
+    static const u8 SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    sink.WriteBytes(SIGNATURE, 8);
+
+    u8 ihdr[13];
+    WriteU32BE(ihdr + 0, width);
+    WriteU32BE(ihdr + 4, height);
+    ihdr[8] = 8;   // Bits per channel
+    ihdr[9] = 2;   // Color type: RGB
+    ihdr[10] = 0;  // Compression: deflate
+    ihdr[11] = 0;  // Filtering: adaptive
+    ihdr[12] = 0;  // No interlace
+    WriteChunk(sink, "IHDR", ihdr, 13);
+    WriteChunk(sink, "IDAT", deflated, deflatedLength);
+    WriteChunk(sink, "IEND", 0, 0);
+
+    delete [] deflated;
+  }
+} /* namespace MFM */
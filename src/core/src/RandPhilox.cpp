@@ -0,0 +1,56 @@
+#include "RandPhilox.h"
+
+namespace MFM
+{
+  static const u32 PHILOX_M0 = 0xD2511F53;
+  static const u32 PHILOX_M1 = 0xCD9E8D57;
+  static const u32 PHILOX_W0 = 0x9E3779B9;  // Golden ratio
+  static const u32 PHILOX_W1 = 0xBB67AE85;  // sqrt(3)-1
+
+  void RandPhilox::Blocks(const u32 key[2], u32 * x0, u32 * x1, u32 * x2, u32 * x3, u32 count)
+  {
+    u32 k0 = key[0];
+    u32 k1 = key[1];
+    for (u32 r = 0; r < ROUNDS; ++r)
+    {
+      for (u32 i = 0; i < count; ++i)
+      {
+        u64 p0 = (u64) PHILOX_M0 * x0[i];
+        u64 p1 = (u64) PHILOX_M1 * x2[i];
+        u32 y0 = ((u32) (p1 >> 32)) ^ x1[i] ^ k0;
+        u32 y2 = ((u32) (p0 >> 32)) ^ x3[i] ^ k1;
+        x0[i] = y0;
+        x1[i] = (u32) p1;
+        x2[i] = y2;
+        x3[i] = (u32) p0;
+      }
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+  }
+
+  void RandPhilox::Refill()
+  {
+    u32 x0[BULK_BLOCKS], x1[BULK_BLOCKS], x2[BULK_BLOCKS], x3[BULK_BLOCKS];
+    for (u32 i = 0; i < BULK_BLOCKS; ++i)
+    {
+      u64 block = m_counter + i;
+      x0[i] = (u32) block;
+      x1[i] = (u32) (block >> 32);
+      x2[i] = 0;
+      x3[i] = 0;
+    }
+
+    Blocks(m_key, x0, x1, x2, x3, BULK_BLOCKS);
+
+    for (u32 i = 0; i < BULK_BLOCKS; ++i)
+    {
+      m_buffer[i * BLOCK_WORDS + 0] = x0[i];
+      m_buffer[i * BLOCK_WORDS + 1] = x1[i];
+      m_buffer[i * BLOCK_WORDS + 2] = x2[i];
+      m_buffer[i * BLOCK_WORDS + 3] = x3[i];
+    }
+    m_counter += BULK_BLOCKS;
+    m_next = 0;
+  }
+} /* namespace MFM */
@@ -56,6 +56,13 @@ namespace MFM
     nanosleep(&tspec, NULL);
   }
 
+  u64 GetMonotonicNanos()
+  {
+    struct timespec tspec;
+    clock_gettime(CLOCK_MONOTONIC, &tspec);
+    return ((u64) tspec.tv_sec) * 1000000000 + (u64) tspec.tv_nsec;
+  }
+
   u32 InterpolateColors(const u32 color1, const u32 color2, const u32 percentOfColor1)
   {
     if (percentOfColor1 >= 100) return color1;
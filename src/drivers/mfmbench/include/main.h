@@ -0,0 +1,17 @@
+/* -*- C++ -*- */
+#ifndef MAIN_H
+#define MAIN_H
+
+#include "itype.h"
+#include "AbstractDriver.h"
+#include "P3Atom.h"
+#include "GridConfig.h"
+#include "EventPhaseProfile.h"
+#include "Element_Dreg.h"
+#include "Element_Res.h"
+#include "Element_Wall.h"
+#include "Element_Fish.h"
+#include "Element_Shark.h"
+#include "Element_ForkBomb1.h"
+
+#endif /* MAIN_H */
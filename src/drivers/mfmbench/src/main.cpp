@@ -0,0 +1,446 @@
+#include "main.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+namespace MFM
+{
+  typedef P3Atom OurAtom;
+  typedef Site<P3AtomConfig> OurSite;
+  typedef EventConfig<OurSite,4> OurEventConfig;
+  typedef GridConfig<OurEventConfig, 40, 40, 1000> OurGridConfig;
+  typedef Grid<OurGridConfig> OurGrid;
+  typedef AbstractDriver<OurGridConfig> OurDriver;  // For GetNumberFromString
+
+  /**
+     Headless event throughput benchmark.  For each element, fills a
+     single tile and then a multi-tile grid with a seeded mix of that
+     element and empty sites, runs a fixed number of events, and
+     reports events per second, nanoseconds per event phase, and cache
+     bytes shipped per event, as CSV or JSON.
+   */
+  class MFMBench
+  {
+    typedef OurEventConfig EC;
+
+    enum { MAX_ELEMENTS = 256 };
+
+    struct Result
+    {
+      const Element<EC> * m_element;
+      const char * m_mode;
+      u32 m_tilesWide;
+      u32 m_tilesHigh;
+      u32 m_workers;
+      u64 m_nanos;
+      u64 m_cacheBytes;
+      EventPhaseProfile m_profile;
+    };
+
+    VArguments m_varguments;
+    ElementRegistry<EC> m_elementRegistry;
+    UlamClassRegistry<EC> m_ucr;
+
+    Element<EC> * m_elements[MAX_ELEMENTS];
+    u32 m_elementCount;
+
+    const char * m_onlySymbol;
+    u64 m_eventsPerRun;
+    u32 m_seed;
+    u32 m_fillPercent;
+    u32 m_tilesWide;
+    u32 m_tilesHigh;
+    u32 m_workers;
+    bool m_batchedUnwind;
+    bool m_json;
+    FILE * m_out;
+    u32 m_resultsWritten;
+
+    void AddElement(Element<EC> * elt)
+    {
+      for (u32 i = 0; i < m_elementCount; ++i)
+      {
+        if (m_elements[i] == elt)
+        {
+          return;
+        }
+      }
+      if (m_elementCount >= MAX_ELEMENTS)
+      {
+        FAIL(OUT_OF_ROOM);
+      }
+      m_elements[m_elementCount++] = elt;
+    }
+
+    static u32 GetNumberArg(VArguments & args, const char * what, const char * str, s32 min, s32 max)
+    {
+      s32 out;
+      const char * errmsg = OurDriver::GetNumberFromString(str, out, min, max);
+      if (errmsg)
+      {
+        args.Die("%s '%s' not in %d..%d: %s", what, str, min, max, errmsg);
+      }
+      return (u32) out;
+    }
+
+    static void PrintArgUsage(const char* not_needed, void* vargs)
+    {
+      VArguments& args = *((VArguments*)vargs);
+      args.Usage();
+    }
+
+    static void SetEventsFromArgs(const char* str, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      u32 millions = GetNumberArg(bench.m_varguments, "Event millions", str, 1, 100000);
+      bench.m_eventsPerRun = ((u64) millions) * 1000000;
+    }
+
+    static void SetSeedFromArgs(const char* str, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      bench.m_seed = GetNumberArg(bench.m_varguments, "Seed", str, 1, S32_MAX);
+    }
+
+    static void SetFillFromArgs(const char* str, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      bench.m_fillPercent = GetNumberArg(bench.m_varguments, "Fill percent", str, 1, 100);
+    }
+
+    static void SetGridFromArgs(const char* str, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      u32 w, h;
+      char ch;
+      if (sscanf(str, "%ux%u%c", &w, &h, &ch) != 2 || w == 0 || h == 0 ||
+          w * h > (u32) OurGrid::MAX_TILES_SUPPORTED)
+      {
+        bench.m_varguments.Die("Bad grid size '%s', need WxH with at most %d tiles",
+                               str, OurGrid::MAX_TILES_SUPPORTED);
+      }
+      bench.m_tilesWide = w;
+      bench.m_tilesHigh = h;
+    }
+
+    static void SetWorkersFromArgs(const char* str, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      bench.m_workers = GetNumberArg(bench.m_varguments, "Worker thread count", str,
+                                     0, OurGrid::MAX_TILE_WORKERS);
+    }
+
+    static void SetBatchedUnwindFromArgs(const char* not_needed, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      bench.m_batchedUnwind = true;
+    }
+
+    static void SetJSONFromArgs(const char* not_needed, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      bench.m_json = true;
+    }
+
+    static void SetOutputFromArgs(const char* path, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      bench.m_out = fopen(path, "w");
+      if (!bench.m_out)
+      {
+        bench.m_varguments.Die("Can't write '%s': %s", path, strerror(errno));
+      }
+    }
+
+    static void SetElementFromArgs(const char* symbol, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      bench.m_onlySymbol = symbol;
+    }
+
+    static void RegisterElementLibraryPath(const char* path, void* benchptr)
+    {
+      MFMBench & bench = *((MFMBench*)benchptr);
+      const char * result = bench.m_elementRegistry.AddLibraryPath(path);
+      if (result)
+      {
+        bench.m_varguments.Die("Bad element library path '%s': %s", path, result);
+      }
+    }
+
+    void AddArguments()
+    {
+      m_varguments.RegisterArgumentSection("Benchmark switches");
+
+      m_varguments.RegisterArgument("Display this help message, then exit.",
+                                    "-h|--help", &PrintArgUsage, (void*)(&m_varguments), false);
+      m_varguments.RegisterArgument("Run ARG million events per element per mode (default 1)",
+                                    "-n|--events", &SetEventsFromArgs, this, true);
+      m_varguments.RegisterArgument("Set the PRNG seed for grids and fills to ARG (default 1)",
+                                    "-s|--seed", &SetSeedFromArgs, this, true);
+      m_varguments.RegisterArgument("Fill ARG percent of sites with the element (default 25)",
+                                    "-f|--fill", &SetFillFromArgs, this, true);
+      m_varguments.RegisterArgument("Use a WxH grid of tiles for the multi-tile runs (default 2x2)",
+                                    "-g|--grid", &SetGridFromArgs, this, true);
+      m_varguments.RegisterArgument("Drive the multi-tile runs with ARG threads (0: one per CPU core)",
+                                    "-wt|--workers", &SetWorkersFromArgs, this, true);
+      m_varguments.RegisterArgument("Benchmark only the element with atomic symbol ARG",
+                                    "-e|--element", &SetElementFromArgs, this, true);
+      m_varguments.RegisterArgument("Add a path to the list of element libraries (string)",
+                                    "-ep|--elementpath", &RegisterElementLibraryPath, this, true);
+      m_varguments.RegisterArgument("Recover from element failures per batch of events, not per event",
+                                    "--batched-unwind", &SetBatchedUnwindFromArgs, this, false);
+      m_varguments.RegisterArgument("Report results as JSON instead of CSV",
+                                    "--json", &SetJSONFromArgs, this, false);
+      m_varguments.RegisterArgument("Write results to file ARG instead of stdout",
+                                    "-o|--output", &SetOutputFromArgs, this, true);
+    }
+
+    /**
+       Place the element on a seeded m_fillPercent of all sites, so
+       that every run of a given element and seed starts identically.
+     */
+    void Fill(OurGrid & grid, const Element<EC> & elt)
+    {
+      Random random(m_seed);
+      const OurAtom atom = elt.GetDefaultAtom();
+      const u32 width = grid.GetWidthSites();
+      const u32 height = grid.GetHeightSites();
+      for (u32 y = 0; y < height; ++y)
+      {
+        for (u32 x = 0; x < width; ++x)
+        {
+          if (random.OddsOf(m_fillPercent, 100))
+          {
+            grid.PlaceAtom(atom, SPoint(x, y));
+          }
+        }
+      }
+    }
+
+    void Run(Result & result)
+    {
+      const u32 tiles = result.m_tilesWide * result.m_tilesHigh;
+      OurGrid * grid = new OurGrid(m_elementRegistry, result.m_tilesWide, result.m_tilesHigh,
+                                   GRID_LAYOUT_CHECKERBOARD);
+      grid->GetUlamClassRegistry() = m_ucr;
+      grid->SetSeed(m_seed);
+      grid->Init();
+
+      grid->Needed(Element_Empty<EC>::THE_INSTANCE);
+      for (u32 i = 0; i < m_elementCount; ++i)
+      {
+        grid->Needed(*m_elements[i]);  // Behaviors may create other types
+      }
+
+      Fill(*grid, *result.m_element);
+
+      EventPhaseProfile * profiles = new EventPhaseProfile[tiles];
+      for (u32 x = 0; x < result.m_tilesWide; ++x)
+      {
+        for (u32 y = 0; y < result.m_tilesHigh; ++y)
+        {
+          grid->GetTile(x, y).SetEventPhaseProfile(&profiles[x * result.m_tilesHigh + y]);
+        }
+      }
+
+      grid->SetTileWorkerCount(result.m_workers);
+      grid->SetBatchedUnwind(m_batchedUnwind);
+      grid->InitThreads();
+
+      u64 start = GetMonotonicNanos();
+      grid->Unpause();
+      while (grid->GetTotalEventsExecuted() < m_eventsPerRun)
+      {
+        SleepMsec(10);
+      }
+      grid->Pause();
+      result.m_nanos = GetMonotonicNanos() - start;
+
+      result.m_profile.Reset();
+      result.m_cacheBytes = 0;
+      for (u32 x = 0; x < result.m_tilesWide; ++x)
+      {
+        for (u32 y = 0; y < result.m_tilesHigh; ++y)
+        {
+          Tile<EC> & tile = grid->GetTile(x, y);
+          result.m_profile.Add(profiles[x * result.m_tilesHigh + y]);
+          result.m_cacheBytes += tile.GetCacheBytesShipped();
+          tile.SetEventPhaseProfile(0);
+        }
+      }
+
+      // Returns only once every tile thread or worker has been
+      // joined, so none can touch the grid after it's deleted
+      grid->ShutdownTileThreads();
+      MFM_API_ASSERT_STATE(!grid->HasTileThreads());
+      delete grid;
+      delete [] profiles;
+    }
+
+    bool IsEmptyElement(Element<EC> & elt) const
+    {
+      if (&elt == &Element_Empty<EC>::THE_INSTANCE)
+      {
+        return true;
+      }
+      const UlamElement<EC> * uelt = elt.AsUlamElement();
+      return uelt != 0 && uelt == m_ucr.GetUlamElementEmpty();
+    }
+
+    void WriteHeader()
+    {
+      if (m_json)
+      {
+        fprintf(m_out, "[\n");
+        return;
+      }
+
+      fprintf(m_out, "element,symbol,mode,tiles_wide,tiles_high,workers,events,seconds,events_per_sec");
+      for (u32 i = 0; i < EventPhaseProfile::PHASE_COUNT; ++i)
+      {
+        fprintf(m_out, ",ns_%s", EventPhaseProfile::GetPhaseName(i));
+      }
+      fprintf(m_out, ",cache_bytes_per_event\n");
+    }
+
+    void WriteResult(const Result & result)
+    {
+      const EventPhaseProfile & prof = result.m_profile;
+      const double events = prof.m_events ? (double) prof.m_events : 1.0;
+      const double seconds = result.m_nanos / 1e9;
+
+      if (m_json)
+      {
+        fprintf(m_out, "%s  {\"element\": \"%s\", \"symbol\": \"%s\", \"mode\": \"%s\", "
+                "\"tiles_wide\": %u, \"tiles_high\": %u, \"workers\": %u, "
+                "\"events\": %.0f, \"seconds\": %.6f, \"events_per_sec\": %.1f",
+                m_resultsWritten ? ",\n" : "",
+                result.m_element->GetName(), result.m_element->GetAtomicSymbol(),
+                result.m_mode, result.m_tilesWide, result.m_tilesHigh, result.m_workers,
+                (double) prof.m_events, seconds, prof.m_events / seconds);
+        for (u32 i = 0; i < EventPhaseProfile::PHASE_COUNT; ++i)
+        {
+          fprintf(m_out, ", \"ns_%s\": %.1f",
+                  EventPhaseProfile::GetPhaseName(i), prof.m_nanos[i] / events);
+        }
+        fprintf(m_out, ", \"cache_bytes_per_event\": %.3f}", result.m_cacheBytes / events);
+      }
+      else
+      {
+        fprintf(m_out, "\"%s\",\"%s\",%s,%u,%u,%u,%.0f,%.6f,%.1f",
+                result.m_element->GetName(), result.m_element->GetAtomicSymbol(),
+                result.m_mode, result.m_tilesWide, result.m_tilesHigh, result.m_workers,
+                (double) prof.m_events, seconds, prof.m_events / seconds);
+        for (u32 i = 0; i < EventPhaseProfile::PHASE_COUNT; ++i)
+        {
+          fprintf(m_out, ",%.1f", prof.m_nanos[i] / events);
+        }
+        fprintf(m_out, ",%.3f\n", result.m_cacheBytes / events);
+      }
+      fflush(m_out);
+      ++m_resultsWritten;
+    }
+
+    void WriteFooter()
+    {
+      if (m_json)
+      {
+        fprintf(m_out, "\n]\n");
+      }
+    }
+
+  public:
+
+    MFMBench()
+      : m_elementCount(0)
+      , m_onlySymbol(0)
+      , m_eventsPerRun(1000000)
+      , m_seed(1)
+      , m_fillPercent(25)
+      , m_tilesWide(2)
+      , m_tilesHigh(2)
+      , m_workers(0)
+      , m_batchedUnwind(false)
+      , m_json(false)
+      , m_out(stdout)
+      , m_resultsWritten(0)
+    { }
+
+    void ProcessArguments(u32 argc, const char** argv)
+    {
+      AddArguments();
+      m_varguments.ProcessArguments(argc, argv);
+
+      if (m_workers == 0)
+      {
+        m_workers = MIN((u32) OurGrid::MAX_TILE_WORKERS, Utils::GetOnlineProcessorCount());
+      }
+
+      AddElement(&Element_Res<EC>::THE_INSTANCE);
+      AddElement(&Element_Dreg<EC>::THE_INSTANCE);
+      AddElement(&Element_Wall<EC>::THE_INSTANCE);
+      AddElement(&Element_Fish<EC>::THE_INSTANCE);
+      AddElement(&Element_Shark<EC>::THE_INSTANCE);
+      AddElement(&Element_ForkBomb1<EC>::THE_INSTANCE);
+
+      m_elementRegistry.Init(m_ucr);
+      for (u32 i = 0; i < m_elementRegistry.GetRegisteredElementCount(); ++i)
+      {
+        AddElement(m_elementRegistry.GetRegisteredElement(i));
+      }
+    }
+
+    void Run()
+    {
+      WriteHeader();
+      for (u32 i = 0; i < m_elementCount; ++i)
+      {
+        Element<EC> * elt = m_elements[i];
+        if (IsEmptyElement(*elt))
+        {
+          continue;
+        }
+        if (m_onlySymbol && strcmp(m_onlySymbol, elt->GetAtomicSymbol()))
+        {
+          continue;
+        }
+
+        Result single = { elt, "single", 1, 1, 1, 0, 0, EventPhaseProfile() };
+        Run(single);
+        WriteResult(single);
+
+        Result multi = { elt, "multi", m_tilesWide, m_tilesHigh, m_workers, 0, 0, EventPhaseProfile() };
+        Run(multi);
+        WriteResult(multi);
+      }
+      WriteFooter();
+
+      if (m_out != stdout)
+      {
+        fclose(m_out);
+      }
+    }
+  };
+}
+
+int main(int argc, const char** argv)
+{
+  MFM::LOG.SetByteSink(MFM::STDERR);
+  MFM::LOG.SetLevel(MFM::LOG.WARNING);
+
+  MFM::MFMBench bench;
+  unwind_protect
+  ({
+    MFMPrintErrorEnvironment(stderr, &unwindProtect_errorEnvironment);
+    fprintf(stderr, "Failure reached top-level! Aborting\n");
+    abort();
+  },
+  {
+    bench.ProcessArguments(argc, argv);
+    bench.Run();
+  });
+
+  return 0;
+}
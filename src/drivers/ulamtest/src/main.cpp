@@ -18,8 +18,11 @@ int main(int argc, char** argv)
   }
 
   TEST(UlamElement_Test);
+  TEST(UlamClassRegistry_Test);
 
   TEST(GridTransceiver_Test);
+  TEST(PacketIO_Test);
+  TEST(Mutex_Test);
   TEST(ElementRegistry_Test);
   TEST(ByteSource_Test);
   TEST(LineTailByteSink_Test);
@@ -41,6 +44,7 @@ int main(int argc, char** argv)
   Point_Test::Test_pointMultiply();
 
   MDist_Test::Test_MDistConversion();
+  MDist_Test::Test_MDistSymPermutation();
 
 #if 0  /* DEPRECATED */
   P1Atom_Test::Test_p1atomState();
@@ -52,8 +56,14 @@ int main(int argc, char** argv)
 
   TEST(EventWindow_Test);
   TEST(Tile_Test);
+  TEST(EventHistoryLog_Test);
 
   Grid_Test::Test_gridPlaceAtom();
+  Grid_Test::Test_gridRasterize();
+  Grid_Test::Test_gridRefreshCaches();
+  Grid_Test::Test_gridShutdownTileThreads();
+  Grid_Test::Test_gridPauseUnpauseCycles();
+  Grid_Test::Test_gridSnapshotAtomCounts();
 
   TEST(ExternalConfig_Test);
 
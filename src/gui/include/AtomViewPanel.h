@@ -194,10 +194,16 @@ namespace MFM
       }
 
       Grid<GC>& grid = this->GetGrid();
-      const T* catom = grid.GetAtomInSite(m_inBase, m_gridCoord);
-      if (!catom)
-        FAIL(INCOMPLETE_CODE); // what to do?
-      T atom(*catom); // Get a non-const atom so serializer can use it sigh.
+      T atom; // Get a non-const atom so serializer can use it sigh.
+
+      // A snapshot can be read while the tiles run, but holds no bases
+      if (m_inBase || !grid.HasTileSnapshots() || !grid.GetSnapshotAtom(m_gridCoord, atom))
+      {
+        const T* catom = grid.GetAtomInSite(m_inBase, m_gridCoord);
+        if (!catom)
+          FAIL(INCOMPLETE_CODE); // what to do?
+        atom = *catom;
+      }
 
       OString512 buff;
       AtomSerializer<AC> serializer(atom);
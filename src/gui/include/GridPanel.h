@@ -69,7 +69,7 @@ namespace MFM
 
     typedef Grid<GC> OurGrid;
     typedef Tile<EC> OurTile;
-    typedef Site<AC> OurSite;
+    typedef typename EC::SITE OurSite;
     typedef TileRenderer<EC> OurTileRenderer;
     typedef GridTool<GC> OurGridTool;
     typedef AtomViewPanel<GC> OurAtomViewPanel;
@@ -272,6 +272,12 @@ namespace MFM
     void SetAtomDit(u32 newdit) { GetTileRenderer().SetAtomSizeDit(newdit); }
 
     OurGrid* m_mainGrid;
+
+    /**
+       The pixels of each tile of m_mainGrid as last painted, indexed
+       like Grid::_getTile; allocated at the first PaintTiles.
+     */
+    typename OurTileRenderer::TileSurface * m_tileSurfaces;
     OurGridTool* m_currentGridTool;
     GridToolAtomView<GC>* m_atomViewTool; // special b/c we do some atomviewpanel management
 
@@ -412,6 +418,7 @@ namespace MFM
       : Super()
       , m_tileRenderer(0)
       , m_mainGrid(0)
+      , m_tileSurfaces(0)
       , m_currentGridTool(0)
       , m_atomViewTool(0)
       , m_gridOriginDit(0,0)
@@ -442,13 +449,18 @@ namespace MFM
       }
     }
 
-    virtual ~GridPanel() { } //avoid inline error
+    virtual ~GridPanel()  //avoid inline error
+    {
+      delete [] m_tileSurfaces;
+    }
 
     void Init() { }
 
     void SetGrid(OurGrid* mainGrid)
     {
       m_mainGrid = mainGrid;
+      delete [] m_tileSurfaces;
+      m_tileSurfaces = 0;
     }
 
     OurGrid & GetGrid()
@@ -609,6 +621,14 @@ namespace MFM
     void PaintTiles(Drawing & drawing)
     {
       GetTileRenderer().SetDrawBases(m_currentGridTool && m_currentGridTool->IsSiteEdit());
+
+      const u32 gridHeight = m_mainGrid->GetHeight();
+      if (!m_tileSurfaces)
+      {
+        m_tileSurfaces =
+          new typename OurTileRenderer::TileSurface[m_mainGrid->GetWidth() * gridHeight];
+      }
+
       for (typename Grid<GC>::iterator_type i = m_mainGrid->begin(); i != m_mainGrid->end(); ++i)
       {
         SPoint tileCoord = i.At();
@@ -621,7 +641,8 @@ namespace MFM
 	if(tileCoord.GetX() == 1 && tileCoord.GetY() == 1)
 	  MFM_LOG_DBG7(("PaintTiles: %d,%d at rectangle x%d,y%d,w%d,h%d", tileCoord.GetX(), tileCoord.GetY(), screenDitForTile.GetX(), screenDitForTile.GetY(), screenDitForTile.GetWidth(), screenDitForTile.GetHeight()));
 #endif
-        GetTileRenderer().PaintTileAtDit(drawing, screenDitForTile.GetPosition(), *i);
+        GetTileRenderer().PaintTileAtDit(drawing, screenDitForTile.GetPosition(), *i,
+                                         &m_tileSurfaces[tileCoord.GetX() * gridHeight + tileCoord.GetY()]);
       }
     }
 
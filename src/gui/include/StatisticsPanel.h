@@ -189,7 +189,12 @@ namespace MFM
           return;
         }
 
-        u32 count = m_grid->GetAtomCount(type);
+        // Tile snapshots can be read while the tiles run
+        u32 count;
+        if (!m_grid->HasTileSnapshots() || !m_grid->CountSnapshotAtoms(&type, 1, &count))
+        {
+          count = m_grid->GetAtomCount(type);
+        }
         double pct = 100.0 * count / allSites;
 
         if (pct == 0 || pct >= 1)
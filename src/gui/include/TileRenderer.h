@@ -45,7 +45,7 @@ namespace MFM
     typedef typename AC::ATOM_TYPE T;
     typedef typename EC::SITE S;
     typedef Tile<EC> OurTile;
-    typedef Site<AC> OurSite;
+    typedef typename EC::SITE OurSite;
 
     enum { EWR = EC::EVENT_WINDOW_RADIUS };
 
@@ -130,10 +130,79 @@ namespace MFM
       return SPoint(ditsIn, ditsIn);
     }
 
+    enum {
+      /**
+         Bigger TileSurfaces aren't worth their memory; tiles that
+         would need one are painted site by site every frame.
+       */
+      MAXIMUM_TILE_SURFACE_PIXELS = 1 << 21
+    };
+
+    /**
+       The pixels of one tile as last painted, kept between frames so
+       that PaintTileAtDit need repaint only the sites that have
+       changed since (see Tile::IsSiteChangedSince).  Whoever paints a
+       tile keeps one for it; see GridPanel.
+     */
+    class TileSurface
+    {
+    public:
+      TileSurface()
+        : m_surface(0)
+        , m_stamp(0)
+        , m_atomSizeDit(0)
+        , m_drawTypes(0)
+        , m_drawCacheSites(false)
+        , m_background(0)
+        , m_colorStateHash(0)
+      { }
+
+      ~TileSurface()
+      {
+        Discard();
+      }
+
+      /**
+         Free our pixels, so the next PaintTileAtDit repaints every site
+       */
+      void Discard()
+      {
+        if (m_surface)
+        {
+          SDL_FreeSurface(m_surface);
+          m_surface = 0;
+        }
+      }
+
+    private:
+      friend class TileRenderer;
+
+      SDL_Surface * m_surface;   //< 0 until first painted
+      u32 m_stamp;               //< Tile::GetChangeStamp the pixels are current to
+
+      // What the pixels were painted with
+      u32 m_atomSizeDit;
+      u32 m_drawTypes;
+      bool m_drawCacheSites;
+      u32 m_background;
+      u32 m_colorStateHash;      //< ElementTable::GetColorStateHash
+
+      TileSurface(const TileSurface &);               // Not copyable
+      TileSurface & operator=(const TileSurface &);   // Not assignable
+    };
+
     TileRenderer();
 
+    /**
+       Paint \c tile with its top-left at \c ditOrigin.  If \c
+       surface is supplied and what is being drawn depends only on
+       the tile's atoms, the sites changed since \c surface was last
+       painted are repainted into it, and it is blitted to \c
+       drawing.  Otherwise every site is painted directly.
+     */
     void PaintTileAtDit(Drawing & drawing,
-                        const SPoint ditOrigin, const OurTile & tile) ;
+                        const SPoint ditOrigin, const OurTile & tile,
+                        TileSurface * surface = 0) ;
 
     void PaintSites(Drawing & drawing,
                     const DrawSiteType drawType, const DrawSiteShape shape,
@@ -212,6 +281,33 @@ namespace MFM
     }
 
   private:
+    bool PaintTileThroughSurface(Drawing & drawing, const SPoint ditOrigin, const OurTile & tile,
+                                 const DrawSiteType backgroundType, TileSurface & surface) ;
+
+    void PaintSiteCell(Drawing & drawing, const DrawSiteType backgroundType, const SPoint cell,
+                       const OurTile & tile, const SPoint siteInTile, u32 background) ;
+
+    /**
+       Can a layer of this type go in a TileSurface?  Only if it is
+       drawn from nothing but event layer atoms, whose changes
+       Tile::IsSiteChangedSince reports.
+     */
+    static bool IsSurfaceDrawable(DrawSiteType t)
+    {
+      switch (t)
+      {
+      case DRAW_SITE_ELEMENT:
+      case DRAW_SITE_ATOM_1:
+      case DRAW_SITE_ATOM_2:
+      case DRAW_SITE_LIGHT_TILE:
+      case DRAW_SITE_DARK_TILE:
+      case DRAW_SITE_NONE:
+        return true;
+      default:
+        return false;
+      }
+    }
+
     static bool IsDrawBase(DrawSiteType t)
     {
       return t >= DRAW_SITE_BASE && t <= DRAW_SITE_BASE_2;
@@ -113,7 +113,8 @@ namespace MFM
   }
 
   template <class EC>
-  void TileRenderer<EC>::PaintTileAtDit(Drawing & drawing, const SPoint ditOrigin, const Tile<EC> & tile)
+  void TileRenderer<EC>::PaintTileAtDit(Drawing & drawing, const SPoint ditOrigin, const Tile<EC> & tile,
+                                        TileSurface * surface)
   {
     if (!tile.IsEnabled())
     {
@@ -123,9 +124,16 @@ namespace MFM
 
         return;
     }
-    PaintSites(drawing,
-               (m_drawBases && !IsBaseVisible()) ? DRAW_SITE_BASE : m_drawBackgroundType,
-               DRAW_SHAPE_FILL, ditOrigin, tile);
+
+    const DrawSiteType backgroundType =
+      (m_drawBases && !IsBaseVisible()) ? DRAW_SITE_BASE : m_drawBackgroundType;
+
+    if (surface && PaintTileThroughSurface(drawing, ditOrigin, tile, backgroundType, *surface))
+    {
+      return;
+    }
+
+    PaintSites(drawing, backgroundType, DRAW_SHAPE_FILL, ditOrigin, tile);
     PaintUnderlays(drawing, ditOrigin, tile);  // E.g. an event window
 
     PaintSites(drawing, m_drawMidgroundType, DRAW_SHAPE_CIRCLE, ditOrigin, tile);
@@ -135,6 +143,117 @@ namespace MFM
     PaintOverlays(drawing, ditOrigin, tile);   // E.g., a tool footprint
   }
 
+  template <class EC>
+  bool TileRenderer<EC>::PaintTileThroughSurface(Drawing & drawing, const SPoint ditOrigin, const Tile<EC> & tile,
+                                                 const DrawSiteType backgroundType, TileSurface & surface)
+  {
+    if (m_drawEventWindow ||
+        !IsSurfaceDrawable(backgroundType) ||
+        !IsSurfaceDrawable(m_drawMidgroundType) ||
+        !IsSurfaceDrawable(m_drawForegroundType))
+    {
+      return false;
+    }
+
+    const u32 outer = m_drawCacheSites ? OurTile::REGION_CACHE : OurTile::REGION_SHARED;
+    const UPoint sizePix = Drawing::MapDitToPix(MakeUnsigned(ComputeDrawSizeDit(tile, outer)));
+    if (sizePix.GetX() * sizePix.GetY() > MAXIMUM_TILE_SURFACE_PIXELS)
+    {
+      surface.Discard();
+      return false;
+    }
+
+    const u32 stamp = tile.GetChangeStamp();  // Before we look at any site
+    const u32 drawTypes =
+      backgroundType | (m_drawMidgroundType << 8) | (m_drawForegroundType << 16);
+    const u32 background = drawing.GetBackground();
+    const u32 colorStateHash = tile.GetElementTable().GetColorStateHash();
+
+    if (surface.m_surface &&
+        ((u32) surface.m_surface->w != sizePix.GetX() || (u32) surface.m_surface->h != sizePix.GetY()))
+    {
+      surface.Discard();
+    }
+
+    bool repaintAll =
+      surface.m_atomSizeDit != m_atomSizeDit ||
+      surface.m_drawTypes != drawTypes ||
+      surface.m_drawCacheSites != m_drawCacheSites ||
+      surface.m_background != background ||
+      surface.m_colorStateHash != colorStateHash ||
+      stamp - surface.m_stamp >= 1u << 30;  // Don't push our luck with wrapping stamps
+
+    if (!surface.m_surface)
+    {
+      // Colors are raw 0xAARRGGBB, as in Drawing; no alpha, so blits copy
+      surface.m_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, sizePix.GetX(), sizePix.GetY(), 32,
+                                               0x00ff0000, 0x0000ff00, 0x000000ff, 0);
+      if (!surface.m_surface)
+      {
+        return false;
+      }
+      repaintAll = true;
+    }
+
+    Drawing onSurface(surface.m_surface, FONT_ASSET_ELEMENT);
+    const u32 first = m_drawCacheSites ? 0 : EWR;
+    for (u32 y = first; y < tile.TILE_HEIGHT - first; ++y)
+    {
+      for (u32 x = first; x < tile.TILE_WIDTH - first; ++x)
+      {
+        const SPoint siteInTile(x, y);
+        if (repaintAll || tile.IsSiteChangedSince(tile.GetSiteInTileNumber(siteInTile), surface.m_stamp))
+        {
+          PaintSiteCell(onSurface, backgroundType, SPoint(x - first, y - first), tile, siteInTile, background);
+        }
+      }
+    }
+
+    surface.m_stamp = stamp;
+    surface.m_atomSizeDit = m_atomSizeDit;
+    surface.m_drawTypes = drawTypes;
+    surface.m_drawCacheSites = m_drawCacheSites;
+    surface.m_background = background;
+    surface.m_colorStateHash = colorStateHash;
+
+    // Overlay on whole pixels, so grid lines meet the cell edges in the surface
+    const SPoint originPix = Drawing::MapDitToPix(ditOrigin);
+    drawing.BlitImage(surface.m_surface, originPix, sizePix);
+    PaintOverlays(drawing, Drawing::MapPixToDit(originPix), tile);
+    return true;
+  }
+
+  template <class EC>
+  void TileRenderer<EC>::PaintSiteCell(Drawing & drawing, const DrawSiteType backgroundType, const SPoint cell,
+                                       const Tile<EC> & tile, const SPoint siteInTile, u32 background)
+  {
+    // Paint only within the cell's own pixels, as later cells would
+    // have painted over any spill when painting the whole tile
+    const SPoint cellDit = cell * m_atomSizeDit;
+    const SPoint cellPix = Drawing::MapDitToPix(cellDit);
+    const SPoint endPix = Drawing::MapDitToPix(cellDit + SPoint(m_atomSizeDit, m_atomSizeDit));
+    const UPoint cellSizePix = MakeUnsigned(endPix - cellPix);
+    drawing.SetWindow(Rect(cellPix, cellSizePix));
+
+    const u32 region = tile.RegionIn(siteInTile);
+    u32 cellColor = background;
+    if (backgroundType == DRAW_SITE_LIGHT_TILE)
+    {
+      cellColor = m_regionColors[region];
+    }
+    else if (backgroundType == DRAW_SITE_DARK_TILE && region >= OurTile::REGION_VISIBLE)
+    {
+      cellColor = Drawing::GREY20;
+    }
+    drawing.FillRect(0, 0, cellSizePix.GetX(), cellSizePix.GetY(), cellColor);
+
+    const SPoint ditOrigin = cellDit - Drawing::MapPixToDit(cellPix);
+    const OurSite & site = tile.GetSite(siteInTile);
+    PaintSiteAtDit(drawing, backgroundType, DRAW_SHAPE_FILL, ditOrigin, site, tile);
+    PaintSiteAtDit(drawing, m_drawMidgroundType, DRAW_SHAPE_CIRCLE, ditOrigin, site, tile);
+    PaintSiteAtDit(drawing, m_drawForegroundType, DRAW_SHAPE_CDOT, ditOrigin, site, tile);
+  }
+
   template <class EC>
   void TileRenderer<EC>::OutlineEventWindowInTile(Drawing & drawing, const SPoint ditOrigin, const Tile<EC> & tile, SPoint site, u32 color)
   {
@@ -174,7 +293,7 @@ namespace MFM
                                         const DrawSiteType drawType,
                                         const DrawSiteShape shape,
                                         const SPoint ditOrigin,
-                                        const Site<AC> & site,
+                                        const OurSite & site,
                                         const Tile<EC> & inTile)
   {
     u32 selector = 0;
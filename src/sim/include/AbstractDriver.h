@@ -39,6 +39,9 @@
 #include "ExternalConfig.h"
 #include "ExternalConfigSectionDriver.h"
 #include "ExternalConfigSectionGrid.h"
+#include "GridSnapshot.h"
+#include "EventHistoryLog.h"
+#include "GridRasterizer.h"
 #include "OverflowableCharBufferByteSink.h"
 #include "FileByteSource.h"
 #include "FileByteSink.h"
@@ -160,7 +163,14 @@ namespace MFM
     virtual void WriteTimeBasedCustomData(FileByteSink& fp)
     { }
 
-    void WriteTimeBasedData(FileByteSink& fp, bool exists)
+    /**
+     * Append a line of time-based data to \c fp, after a header line
+     * unless \c exists.  With \c gridRunning, the atom counts come
+     * from tile snapshots (see Grid::CountSnapshotAtoms), which every
+     * tile must have published; otherwise, call only while the grid
+     * is paused.
+     */
+    void WriteTimeBasedData(FileByteSink& fp, bool exists, bool gridRunning)
     {
 
       if(!exists)
@@ -193,35 +203,426 @@ namespace MFM
       fp.WriteByte(' ');
       fp.Print((u64)(100.0 * GetOverheadPercent()));
 
+      u32 counts[MAX_NEEDED_ELEMENTS];
+      if (gridRunning)
+      {
+        ElementType types[MAX_NEEDED_ELEMENTS];
+        for(u32 i = 0; i < m_neededElementCount; i++)
+        {
+          types[i] = m_neededElements[i]->GetType();
+        }
+        if (!GetGrid().CountSnapshotAtoms(types, m_neededElementCount, counts))
+        {
+          FAIL(ILLEGAL_STATE);
+        }
+      }
+      else
+      {
+        for(u32 i = 0; i < m_neededElementCount; i++)
+        {
+          counts[i] = GetGrid().GetAtomCount(m_neededElements[i]->GetType());
+        }
+      }
+
       for(u32 i = 0; i < m_neededElementCount; i++)
       {
         fp.WriteByte(' ');
-        fp.Print((u32)GetGrid().GetAtomCount(m_neededElements[i]->GetType()));
+        fp.Print(counts[i]);
       }
 
       WriteTimeBasedCustomData(fp);
       fp.Println();
     }
 
-    void WriteTimeBasedData()
+    /**
+     * Open \c path to append to it, setting \c exists to whether it
+     * was there already, so the caller knows whether to start it with
+     * a header line.  Logs and returns null if \c path can't be
+     * opened.
+     */
+    static FILE* OpenForAppend(const char* path, bool& exists)
+    {
+      FILE* fp = fopen(path, "r");
+      exists = fp != 0;
+      if (fp)
+      {
+        fclose(fp);
+      }
+      fp = fopen(path, "a");
+      if (!fp)
+      {
+        LOG.Error("Can't append to '%s'", path);
+      }
+      return fp;
+    }
+
+    void WriteTimeBasedData(bool gridRunning)
     {
       const char* path = GetSimDirPathTemporary("tbd/data.dat");
-      bool exists = true;
+      bool exists;
+      FILE* fp = OpenForAppend(path, exists);
+      if (!fp)
+      {
+        return;
+      }
+      FileByteSink fbs(fp);
+
+      WriteTimeBasedData(fbs, exists, gridRunning);
+      fclose(fp);
+    }
+
+    /**
+     * Write the time-based data, and the --frames frame if one is
+     * due, for the epoch that ended at \c epochAEPS.  With \c
+     * gridRunning, both are read from tile snapshots, so the grid
+     * need not be paused; see DoEpochEvents.
+     */
+    void WriteEpochObservations(u32 epochAEPS, bool gridRunning)
+    {
+      WriteTimeBasedData(gridRunning);
+
+      if (m_frameAEPS > 0 && epochAEPS >= m_nextFrameAEPS)
+      {
+        WriteFrame(epochAEPS);
+        m_nextFrameAEPS = epochAEPS - epochAEPS % m_frameAEPS + m_frameAEPS;
+      }
+    }
+
+    /**
+     * Write the epoch observations DoEpochEvents left for the running
+     * grid, if any, now.
+     */
+    void FlushEpochObservations(bool gridRunning)
+    {
+      if (m_epochObservationPending)
+      {
+        m_epochObservationPending = false;
+        WriteEpochObservations(m_epochObservationAEPS, gridRunning);
+      }
+    }
+
+    /**
+     * Give each Tile of the grid its own ElementProfile, for
+     * --element-profile.  Call only while the grid is not running.
+     */
+    void AttachElementProfiles()
+    {
+      if (!m_elementProfiles)
+      {
+        // One per tile, plus one more for their sum
+        m_elementProfiles = new ElementProfile[m_grid.GetWidth() * m_grid.GetHeight() + 1];
+      }
+      u32 n = 0;
+      for (typename OurGrid::iterator_type i = m_grid.begin(); i != m_grid.end(); ++i)
+      {
+        i->SetElementProfile(&m_elementProfiles[n++]);
+      }
+    }
+
+    /**
+     * Append the per-element-type event costs accumulated by all
+     * tiles since the last call to tbd/elements.csv, one line per
+     * element type, and restart the accumulation.  Call only while
+     * the grid is paused.
+     */
+    void WriteElementProfileData()
+    {
+      if (!m_elementProfiles)
+      {
+        return;
+      }
+
+      const u32 tiles = m_grid.GetWidth() * m_grid.GetHeight();
+      ElementProfile & total = m_elementProfiles[tiles];
+      total.Reset();
+      for (u32 i = 0; i < tiles; ++i)
+      {
+        total.Add(m_elementProfiles[i]);
+        m_elementProfiles[i].Reset();
+      }
+
+      const char* path = GetSimDirPathTemporary("tbd/elements.csv");
+      bool exists;
+      FILE* fp = OpenForAppend(path, exists);
+      if (!fp)
+      {
+        return;
+      }
+      FileByteSink fbs(fp);
+
+      if (!exists)
       {
-        FILE* fp = fopen(path, "r");
-        if (!fp)
+        fbs.Printf("aeps,type,element,events,behavior_failures,lock_failures,ticks,ticks_per_event,sites_changed");
+        for (u32 b = 0; b < ElementProfile::HISTOGRAM_BUCKETS; ++b)
         {
-          exists = false;
+          fbs.Printf(",ticks_2e%d", b);
         }
-        else
+        fbs.Println();
+      }
+
+      for (u32 i = 0; i < ElementProfile::SIZE; ++i)
+      {
+        const ElementProfile::Entry & e = total.m_entries[i];
+        if (!e.m_inUse)
+        {
+          continue;
+        }
+        fbs.Print((u64) GetAEPS());
+        fbs.Printf(",0x%04x,", e.m_type);
+        const Element<EC> * elt = m_grid.LookupElement(e.m_type);
+        for (const char* p = elt ? elt->GetName() : "?"; *p; p++)
         {
-          fclose(fp);
+          fbs.WriteByte((isspace(*p) || *p == ',') ? '_' : *p);
         }
+        fbs.WriteByte(',');
+        fbs.Print(e.m_events);
+        fbs.WriteByte(',');
+        fbs.Print(e.m_behaviorFailures);
+        fbs.WriteByte(',');
+        fbs.Print(e.m_lockFailures);
+        fbs.WriteByte(',');
+        fbs.Print(e.m_ticks);
+        fbs.WriteByte(',');
+        fbs.Print(e.m_events ? e.m_ticks / e.m_events : 0);
+        fbs.WriteByte(',');
+        fbs.Print(e.m_sitesChanged);
+        for (u32 b = 0; b < ElementProfile::HISTOGRAM_BUCKETS; ++b)
+        {
+          fbs.WriteByte(',');
+          fbs.Print(e.m_histogram.GetCount(b));
+        }
+        fbs.Println();
+      }
+      fclose(fp);
+    }
+
+    /**
+     * Give each Tile of the grid its own CacheProfile, for
+     * --cache-profile.  Call only while the grid is not running.
+     */
+    void AttachCacheProfiles()
+    {
+      if (!m_cacheProfiles)
+      {
+        m_cacheProfiles = new CacheProfile[m_grid.GetWidth() * m_grid.GetHeight()];
+      }
+      for (u32 y = 0; y < m_grid.GetHeight(); ++y)
+      {
+        for (u32 x = 0; x < m_grid.GetWidth(); ++x)
+        {
+          m_grid.GetTile(x, y).SetCacheProfile(&m_cacheProfiles[y * m_grid.GetWidth() + x]);
+        }
+      }
+    }
+
+    /**
+     * Append the boundary statistics accumulated by all tiles since
+     * the last call to tbd/cache.csv, one line per connected tile
+     * boundary, write their stall heatmap to cache/, and restart the
+     * accumulation.  Call only while the grid is paused.
+     */
+    void WriteCacheProfileData()
+    {
+      if (!m_cacheProfiles)
+      {
+        return;
+      }
+
+      const char* path = GetSimDirPathTemporary("cache/%010d.pgm", (u32) GetAEPS());
+      FILE* fp = fopen(path, "w");
+      if (fp)
+      {
+        FileByteSink fbs(fp);
+        m_grid.WriteCacheStallImage(fbs);
+        fclose(fp);
+      }
+
+      path = GetSimDirPathTemporary("tbd/cache.csv");
+      bool exists;
+      fp = OpenForAppend(path, exists);
+      if (!fp)
+      {
+        return;
       }
-      FILE* fp = fopen(path, "a");
       FileByteSink fbs(fp);
 
-      WriteTimeBasedData(fbs, exists);
+      if (!exists)
+      {
+        fbs.Printf("aeps,tile_x,tile_y,dir,updates,updates_received,packets,bytes,"
+                   "packets_per_update,bytes_per_update,atoms_updated,atoms_checked,"
+                   "check_failures,check_odds");
+        for (u32 i = 0; i < CacheProfile::STALL_COUNT; ++i)
+        {
+          fbs.Printf(",stalls_%s", CacheProfile::GetStallName(i));
+        }
+        for (u32 i = 0; i < CacheProfile::STATE_COUNT; ++i)
+        {
+          fbs.Printf(",ns_%s", CacheProfile::GetStateName(i));
+        }
+        for (u32 b = 0; b < CacheProfile::HISTOGRAM_BUCKETS; ++b)
+        {
+          fbs.Printf(",latency_2e%d", b);
+        }
+        fbs.Println();
+      }
+
+      for (u32 y = 0; y < m_grid.GetHeight(); ++y)
+      {
+        for (u32 x = 0; x < m_grid.GetWidth(); ++x)
+        {
+          Tile<EC> & tile = m_grid.GetTile(x, y);
+          CacheProfile & profile = m_cacheProfiles[y * m_grid.GetWidth() + x];
+          for (Dir d = 0; d < Dirs::DIR_COUNT; ++d)
+          {
+            const CacheProcessor<EC> & cp = tile.GetCacheProcessor(d);
+            if (!cp.IsConnected())
+            {
+              continue;
+            }
+            const CacheProfile::Boundary & b = profile.GetBoundary(d);
+            fbs.Print((u64) GetAEPS());
+            fbs.Printf(",%d,%d,%s,", x, y, Dirs::GetName(d));
+            fbs.Print(b.m_updates);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_updatesReceived);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_packets);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_bytes);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_updates ? b.m_packets / b.m_updates : 0);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_updates ? b.m_bytes / b.m_updates : 0);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_atomsUpdated);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_atomsChecked);
+            fbs.WriteByte(',');
+            fbs.Print(b.m_checkFailures);
+            fbs.WriteByte(',');
+            fbs.Print(cp.GetCurrentCacheRedundancy());
+            for (u32 i = 0; i < CacheProfile::STALL_COUNT; ++i)
+            {
+              fbs.WriteByte(',');
+              fbs.Print(b.m_stalls[i]);
+            }
+            for (u32 i = 0; i < CacheProfile::STATE_COUNT; ++i)
+            {
+              fbs.WriteByte(',');
+              fbs.Print(b.m_nanos[i]);
+            }
+            for (u32 i = 0; i < CacheProfile::HISTOGRAM_BUCKETS; ++i)
+            {
+              fbs.WriteByte(',');
+              fbs.Print(b.m_latency.GetCount(i));
+            }
+            fbs.Println();
+          }
+          profile.Reset();
+        }
+      }
+      fclose(fp);
+    }
+
+    /**
+     * Start streaming each Tile's event history to its own log under
+     * history/, for --event-log.  EventHistoryLog::SeekGrid, given
+     * the history/tile prefix, rebuilds the grid from them.  Call only
+     * while the grid is not running.
+     */
+    void OpenEventLogs()
+    {
+      char gridPrefix[MAX_PATH_LENGTH];
+      char tilePrefix[MAX_PATH_LENGTH];
+      snprintf(gridPrefix, sizeof(gridPrefix), "%s", GetSimDirPathTemporary("history/tile"));
+      const u32 tiles = m_grid.GetWidth() * m_grid.GetHeight();
+      if (!m_eventLogs)
+      {
+        m_eventLogs = new EventHistoryLog<EC> * [tiles];
+        for (u32 i = 0; i < tiles; ++i)
+        {
+          m_eventLogs[i] = 0;
+        }
+      }
+      for (u32 y = 0; y < m_grid.GetHeight(); ++y)
+      {
+        for (u32 x = 0; x < m_grid.GetWidth(); ++x)
+        {
+          EventHistoryLog<EC> * & log = m_eventLogs[y * m_grid.GetWidth() + x];
+          if (log)
+          {
+            continue;
+          }
+          Tile<EC> & tile = m_grid.GetTile(x, y);
+          log = new EventHistoryLog<EC>(tile);
+          EventHistoryLog<EC>::MakeTilePathPrefix(tilePrefix, gridPrefix, x, y);
+          if (!log->Open(tilePrefix, m_eventLogKeyframes))
+          {
+            m_varguments.Die("Can't log event history for tile (%d,%d)", x, y);
+          }
+          tile.SetHistoryActive(true);
+        }
+      }
+    }
+
+    void CloseEventLogs()
+    {
+      if (!m_eventLogs)
+      {
+        return;
+      }
+      const u32 tiles = m_grid.GetWidth() * m_grid.GetHeight();
+      for (u32 i = 0; i < tiles; ++i)
+      {
+        delete m_eventLogs[i];  // Closing it
+      }
+      delete [] m_eventLogs;
+      m_eventLogs = 0;
+    }
+
+    /**
+     * Rasterize the grid and write it as a frame for --frames: a PNG
+     * under frames/, or with --frame-stream, another PPM appended to
+     * frames/frames.ppm.  Call only while the grid is not running,
+     * unless every tile has published a snapshot for the rasterizer
+     * to read instead (see Grid::HasTileSnapshots).
+     */
+    void WriteFrame(u32 aeps)
+    {
+      if (!m_rasterizer)
+      {
+        m_rasterizer = new GridRasterizer<GC>(m_grid);
+      }
+      m_rasterizer->Render(1, 0);
+
+      if (m_frameStreaming)
+      {
+        if (!m_frameStream)
+        {
+          const char * path = GetSimDirPathTemporary("frames/frames.ppm");
+          m_frameStream = fopen(path, "a");
+          if (!m_frameStream)
+          {
+            LOG.Error("Can't append frames to %s: %s", path, strerror(errno));
+            m_frameAEPS = 0;
+            return;
+          }
+        }
+        FileByteSink fbs(m_frameStream);
+        m_rasterizer->WritePPM(fbs);
+        fflush(m_frameStream);
+        return;
+      }
+
+      const char * path = GetSimDirPathTemporary("frames/%010d.png", aeps);
+      FILE* fp = fopen(path, "w");
+      if (!fp)
+      {
+        LOG.Error("Can't write frame %s: %s", path, strerror(errno));
+        return;
+      }
+      FileByteSink fbs(fp);
+      m_rasterizer->WritePNG(fbs);
       fclose(fp);
     }
 
@@ -245,7 +646,16 @@ namespace MFM
       else
         m_msSpentOverhead = 0;
 
-      SleepUsec(m_microsSleepPerFrame);
+      // Observe the last epoch from tile snapshots while the tiles
+      // run, and sleep only for the rest of the frame
+      s64 sleepUsec = m_microsSleepPerFrame;
+      if (m_epochObservationPending)
+      {
+        FlushEpochObservations(true);
+        sleepUsec -= 1000 * (s64) (GetTicks() - startMS);
+      }
+      if (sleepUsec > 0)
+        SleepUsec((u32) sleepUsec);
 
       m_ticksLastStopped = GetTicks(); // and before pausing
 
@@ -455,7 +865,7 @@ namespace MFM
       
       const char* (subs[]) =
       {
-        "", "vid", "eps", "tbd", "teps", "save", "screenshot", "autosave", "log"
+        "", "vid", "eps", "tbd", "teps", "save", "screenshot", "autosave", "log", "cache", "history", "frames"
       };
 
       for(u32 i = 0; i < sizeof(subs) / sizeof(subs[0]); i++)
@@ -509,7 +919,8 @@ namespace MFM
             GetSimDirPathTemporary("save/final-%D-%D.mfs", m_epochCount, (u32) m_AEPS);
           SaveGrid(filename);
         }
-        WriteTimeBasedData();
+        FlushEpochObservations(false);
+        WriteTimeBasedData(false);
         m_grid.ShutdownTileThreads();
         return false;
       }
@@ -708,6 +1119,12 @@ namespace MFM
       driver.SetSeed(seed);
     }
 
+    static void SetCounterRandomFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_grid.SetTileRandomGenerator(Random::GENERATOR_PHILOX);
+    }
+
     static void SetAEPSPerEpochFromArgs(const char* aepsStr, void* driverptr)
     {
       AbstractDriver& driver = *((AbstractDriver*)driverptr);
@@ -942,6 +1359,128 @@ namespace MFM
       driver.m_grid.SetWarpFactor(out);
     }
 
+    static void SetEventBatchFromArgs(const char* ebs, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(ebs, out, 1, 256);
+      if (errmsg)
+      {
+        args.Die("Event batch '%s' not in 1..256: %s", ebs, errmsg);
+      }
+
+      driver.m_grid.SetEventBatchLimit(out);
+    }
+
+    static void SetTileSnapshotsFromArgs(const char* tss, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(tss, out, 0, 1000000);
+      if (errmsg)
+      {
+        args.Die("Tile snapshot interval '%s' not in 0..1000000: %s", tss, errmsg);
+      }
+
+      driver.m_grid.SetTileSnapshotInterval(out);
+    }
+
+    static void SetTileWorkersFromArgs(const char* ws, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      const s32 maxWorkers = OurGrid::MAX_TILE_WORKERS;
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(ws, out, 0, maxWorkers);
+      if (errmsg)
+      {
+        args.Die("Worker thread count '%s' not in 0..%d: %s", ws, maxWorkers, errmsg);
+      }
+
+      if (out == 0)
+      {
+        out = Utils::GetOnlineProcessorCount();
+        if (out > maxWorkers) out = maxWorkers;
+      }
+      driver.m_grid.SetTileWorkerCount((u32) out);
+    }
+
+    static void SetNoBandwidthFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_grid.SetSimulateBandwidth(false);
+    }
+
+    static void SetBatchedUnwindFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_grid.SetBatchedUnwind(true);
+    }
+
+    static void SetElementProfileFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_elementProfiling = true;
+    }
+
+    static void SetCacheProfileFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_cacheProfiling = true;
+    }
+
+    static void SetEventLogFromArgs(const char* keyframes, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(keyframes, out, 0, S32_MAX);
+      if (errmsg)
+      {
+        args.Die("Event log keyframe interval '%s' is not a count of events: %s", keyframes, errmsg);
+      }
+      driver.m_eventLogging = true;
+      driver.m_eventLogKeyframes = out > 0 ? (u32) out : (u32) EventHistoryLog<EC>::DEFAULT_KEYFRAME_EVENTS;
+    }
+
+    static void SetFramesFromArgs(const char* aepsStr, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      VArguments& args = driver.m_varguments;
+
+      s32 out;
+      const char * errmsg = AbstractDriver<GC>::GetNumberFromString(aepsStr, out, 1, S32_MAX);
+      if (errmsg)
+      {
+        args.Die("Frame interval '%s' is not a positive AEPS count: %s", aepsStr, errmsg);
+      }
+      driver.m_frameAEPS = (u32) out;
+    }
+
+    static void SetFrameStreamFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_frameStreaming = true;
+    }
+
+    static void SetTextPacketsFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_grid.SetBinaryCachePackets(false);
+    }
+
+    static void SetBinarySavesFromArgs(const char* not_needed, void* driverptr)
+    {
+      AbstractDriver& driver = *((AbstractDriver*)driverptr);
+      driver.m_binarySaves = true;
+    }
+
     static void LoadFromConfigFile(const char* path, void* driverptr)
     {
       AbstractDriver& driver = *((AbstractDriver*)driverptr);
@@ -1135,6 +1674,12 @@ namespace MFM
     {
 
       LOG.Message("Saving to: %s", filename);
+      if (m_binarySaves)
+      {
+        m_gridSnapshot.Write(filename);
+        return;
+      }
+
       FILE* fp = fopen(filename, "w");
       FileByteSink fs(fp);
 
@@ -1179,6 +1724,17 @@ namespace MFM
 
       LOG.Message("Loading configuration '%s'", buf.GetZString());
 
+      if (GridSnapshot<GC>::IsSnapshotFile(buf.GetZString()))
+      {
+        if (!m_gridSnapshot.Read(buf.GetZString()))
+        {
+          LOG.Error("Can't load grid snapshot '%s'", buf.GetZString());
+          return false;
+        }
+        LOG.Message("Loaded grid snapshot '%s'", buf.GetZString());
+        return true;
+      }
+
       FileByteSource fs(buf.GetZString());
       if (fs.IsOpen())
       {
@@ -1204,7 +1760,23 @@ namespace MFM
     {
       LOG.Debug("Epoch %d: %d AEPS", epochs, epochAEPS);
 
-      WriteTimeBasedData();
+      // With snapshots from every tile, leave the atom counts and
+      // frame to be read from them once the grid runs again, rather
+      // than keep it paused for them
+      FlushEpochObservations(false);
+      if (grid.HasTileSnapshots())
+      {
+        m_epochObservationPending = true;
+        m_epochObservationAEPS = epochAEPS;
+      }
+      else
+      {
+        WriteEpochObservations(epochAEPS, false);
+      }
+
+      WriteElementProfileData();
+
+      WriteCacheProfileData();
 
       if (m_gridImages)
       {
@@ -1284,11 +1856,37 @@ namespace MFM
       , m_externalConfig(*this)
       , m_externalConfigSectionDriver(m_externalConfig, *this)
       , m_externalConfigSectionGrid(m_externalConfig, m_grid)
+      , m_gridSnapshot(m_externalConfig, m_externalConfigSectionGrid, m_grid)
+      , m_binarySaves(false)
+      , m_elementProfiling(false)
+      , m_elementProfiles(0)
+      , m_cacheProfiling(false)
+      , m_cacheProfiles(0)
+      , m_eventLogging(false)
+      , m_eventLogKeyframes(EventHistoryLog<EC>::DEFAULT_KEYFRAME_EVENTS)
+      , m_eventLogs(0)
+      , m_frameAEPS(0)
+      , m_nextFrameAEPS(0)
+      , m_frameStreaming(false)
+      , m_frameStream(0)
+      , m_rasterizer(0)
+      , m_epochObservationPending(false)
+      , m_epochObservationAEPS(0)
     {
       InitTicks(0); // Overwritten later on -cp load
     }
 
-    virtual ~AbstractDriver() {} //avoid inline error
+    virtual ~AbstractDriver()
+    {
+      delete [] m_elementProfiles;
+      delete [] m_cacheProfiles;
+      CloseEventLogs();
+      if (m_frameStream)
+      {
+        fclose(m_frameStream);
+      }
+      delete m_rasterizer;
+    }
 
     virtual void RegisterExternalConfigSections()
     {
@@ -1393,6 +1991,9 @@ namespace MFM
       RegisterArgument("Set master PRNG seed to ARG (u32)",
                        "-s|--seed", &SetSeedFromArgs, this, true);
 
+      RegisterArgument("Give each tile its own counter-based PRNG stream, keyed by seed and tile position",
+                       "--counter-rng", &SetCounterRandomFromArgs, this, false);
+
       RegisterArgument("Set epoch length to ARG AEPS",
                        "-e|--epoch", &SetAEPSPerEpochFromArgs, this, true);
 
@@ -1450,6 +2051,42 @@ namespace MFM
       RegisterArgument("Set warp factor 0..10 (0: flattest space; 10: highest AER)",
                        "-wf|--warpfactor", &SetWarpFactorFromArgs, this, true);
 
+      RegisterArgument("Let each tile run up to ARG hidden-region events between communication passes (1..256)",
+                       "--event-batch", &SetEventBatchFromArgs, this, true);
+
+      RegisterArgument("Have each tile publish a snapshot of its atoms every ARG events, so stats and --frames are taken while the grid runs (0: never)",
+                       "--tile-snapshots", &SetTileSnapshotsFromArgs, this, true);
+
+      RegisterArgument("Drive tiles with a pool of ARG work-stealing threads (0: one per CPU core)",
+                       "-wt|--workers", &SetTileWorkersFromArgs, this, true);
+
+      RegisterArgument("Connect tiles with lock-free channels instead of simulating bandwidth",
+                       "--no-bandwidth", &SetNoBandwidthFromArgs, this, false);
+
+      RegisterArgument("Recover from element failures per batch of events, not per event",
+                       "--batched-unwind", &SetBatchedUnwindFromArgs, this, false);
+
+      RegisterArgument("Write per-element event costs to tbd/elements.csv each epoch",
+                       "--element-profile", &SetElementProfileFromArgs, this, false);
+
+      RegisterArgument("Write tile boundary lock and cache statistics to tbd/cache.csv and cache/ each epoch",
+                       "--cache-profile", &SetCacheProfileFromArgs, this, false);
+
+      RegisterArgument("Stream tile event histories to history/, with keyframes every ARG events (0: default)",
+                       "--event-log", &SetEventLogFromArgs, this, true);
+
+      RegisterArgument("Write an atom-color PNG of the grid to frames/ every ARG AEPS, without SDL",
+                       "--frames", &SetFramesFromArgs, this, true);
+
+      RegisterArgument("Append --frames as PPMs to the video stream frames/frames.ppm instead",
+                       "--frame-stream", &SetFrameStreamFromArgs, this, false);
+
+      RegisterArgument("Send intertile cache updates as text packets, for debugging",
+                       "--text-packets", &SetTextPacketsFromArgs, this, false);
+
+      RegisterArgument("Write saves and autosaves as binary grid snapshots",
+                       "--binary-save", &SetBinarySavesFromArgs, this, false);
+
       RegisterArgument("Add a key=value pair to simulation parameters (string)",
                        "-kv|--keyvalue", &RegisterKeyValue, this, true);
 
@@ -1550,6 +2187,21 @@ namespace MFM
 
       m_grid.Init();
 
+      if (m_elementProfiling)
+      {
+        AttachElementProfiles();
+      }
+
+      if (m_cacheProfiling)
+      {
+        AttachCacheProfiles();
+      }
+
+      if (m_eventLogging)
+      {
+        OpenEventLogs();
+      }
+
       m_grid.InitThreads();
 
       // No longer needed?  Only needed in cpp-elt situations??  We shall see
@@ -1655,6 +2307,28 @@ namespace MFM
     ExternalConfigSectionDriver<GC> m_externalConfigSectionDriver;
     ExternalConfigSectionGrid<GC> m_externalConfigSectionGrid;
 
+    GridSnapshot<GC> m_gridSnapshot;
+    bool m_binarySaves;
+
+    bool m_elementProfiling;
+    ElementProfile * m_elementProfiles;  // One per tile, then their sum
+
+    bool m_cacheProfiling;
+    CacheProfile * m_cacheProfiles;  // One per tile
+
+    bool m_eventLogging;
+    u32 m_eventLogKeyframes;
+    EventHistoryLog<EC> ** m_eventLogs;  // One per tile
+
+    u32 m_frameAEPS;               // 0 for no --frames
+    u32 m_nextFrameAEPS;
+    bool m_frameStreaming;
+    FILE * m_frameStream;          // frames/frames.ppm, once opened
+    GridRasterizer<GC> * m_rasterizer;
+
+    bool m_epochObservationPending;  // Left by DoEpochEvents for UpdateGrid
+    u32 m_epochObservationAEPS;
+
   public:
     bool IsLoadDriverSection() const { return m_externalConfigSectionDriver.IsEnabled(); }
     void SetLoadDriverSection(bool val) { m_externalConfigSectionDriver.SetEnabled(val); }
@@ -0,0 +1,297 @@
+/*                                              -*- mode:C++ -*-
+  EventHistoryLog.h Spill-to-disk tile event history with replay
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file EventHistoryLog.h Spill-to-disk tile event history with replay
+  \lgpl
+ */
+#ifndef EVENTHISTORYLOG_H
+#define EVENTHISTORYLOG_H
+
+#include "itype.h"
+#include "Fail.h"
+#include "EventHistorySink.h"
+#include "EventHistoryBuffer.h"
+#include "Tile.h"
+
+namespace MFM
+{
+  /**
+     An EventHistoryLog streams every event one Tile records in its
+     EventHistoryBuffer to a series of memory-mapped segment files,
+     named PREFIX-NNNNNN.ehl, so a Tile's history can be replayed long
+     after the buffer's ring has overwritten it.  Seek reconstructs
+     the Tile as it was after any logged event, and SeekRun as it was
+     when it began any run (see Resuming).  Since every tile of a
+     Grid begins its Nth run at the same moment, SeekGrid can rebuild
+     a whole Grid from its tiles' logs.
+
+     Each segment file is:
+
+      - A SegmentHeader, recording the tile geometry, how many events
+        and runs were logged before the segment began, and how many bytes of
+        the segment hold complete records.  The header is updated
+        after each event, so a segment left by a crash is readable up
+        to its last complete event.
+
+      - A keyframe: a copy of every site's atom, base atom, paint and
+        touch sensor, taken as the first event of the segment began.
+
+      - The EventHistoryItems of each logged event, START to END,
+        interleaved with further keyframes every keyframeEvents
+        events, and with a run record each time the Tile resumes.
+
+     Changes made to the Tile outside events, by tools, say, or by
+     loading a configuration, happen while the Grid is paused.  The
+     log digests the Tile as it stops (see Paused), and if the digest
+     differs as it resumes, writes a keyframe then, so a replay sees
+     those changes where they happened.
+
+     If a segment can't be started, the log reports it and stops, and
+     Seek reports where the log ends.
+
+     Atoms are logged as raw bits, so replay assumes the same element
+     type numbering as the logging run.
+
+     The log is written only by the thread advancing its Tile, or by
+     the Grid's thread while the Tile is not running.
+   */
+  template <class EC>
+  class EventHistoryLog : public EventHistorySink
+  {
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+    typedef typename EC::SITE S;
+    typedef BitVector<AC::BITS_PER_ATOM> BV;
+
+  public:
+    // LOG_VERSION = 1 Original version
+    enum { LOG_VERSION = 1 };
+
+    enum { BYTE_ORDER_MARK = 0x01020304 };
+
+    enum
+    {
+      DEFAULT_KEYFRAME_EVENTS = 100000,
+      DEFAULT_SEGMENT_BYTES = 64 << 20,
+      MAX_PATH_LENGTH = 256
+    };
+
+    static const char LOG_MAGIC[8];
+
+    EventHistoryLog(Tile<EC> & tile) ;
+
+    ~EventHistoryLog()
+    {
+      Close();
+    }
+
+    /**
+       Start logging to segment files named \c pathPrefix-NNNNNN.ehl,
+       with a keyframe at least every \c keyframeEvents events, and
+       attach this log to the Tile's EventHistoryBuffer.  Any later
+       segments left under \c pathPrefix by an earlier log are removed.
+       Returns false, after logging an error, if the first segment
+       cannot be created or \c segmentBytes cannot hold a keyframe.
+       Call only while the Tile is not running.
+     */
+    bool Open(const char * pathPrefix,
+              u32 keyframeEvents = DEFAULT_KEYFRAME_EVENTS,
+              u32 segmentBytes = DEFAULT_SEGMENT_BYTES) ;
+
+    /**
+       Detach from the Tile and finish the current segment.  Call only
+       while the Tile is not running.
+     */
+    void Close() ;
+
+    bool IsOpen() const
+    {
+      return m_segment != 0;
+    }
+
+    /**
+       Events logged since Open
+     */
+    u64 GetEventsLogged() const
+    {
+      return m_eventsLogged;
+    }
+
+    /**
+       Times the Tile has resumed running since Open
+     */
+    u32 GetRunsLogged() const
+    {
+      return m_runsLogged;
+    }
+
+    /**
+       Put the path prefix for the log of the tile at (\c x, \c y)
+       of a grid logged under \c gridPrefix into \c buffer, which
+       must hold MAX_PATH_LENGTH chars.
+     */
+    static void MakeTilePathPrefix(char * buffer, const char * gridPrefix, u32 x, u32 y) ;
+
+    virtual void BeginEvent() ;
+
+    virtual void AppendItems(const EventHistoryItem * items, u32 count) ;
+
+    /**
+       Digest the stopped Tile, for Resuming to compare against.
+     */
+    virtual void Paused() ;
+
+    /**
+       Write a keyframe if the Tile has changed since Open or the last
+       Paused, then a record that the next run begins here.
+     */
+    virtual void Resuming() ;
+
+    /**
+       Restore \c tile to its state after the first \c eventNumber
+       events logged under \c pathPrefix, by loading the last keyframe
+       at or before that event and replaying the events since.
+       Returns false if those segments are missing or malformed, were
+       logged from a tile of different geometry, or end before \c
+       eventNumber; in that last case \c tile may have been partly
+       restored.
+     */
+    static bool Seek(const char * pathPrefix, Tile<EC> & tile, u64 eventNumber) ;
+
+    /**
+       Restore \c tile to its state as it began run number \c run
+       (counting from 1) of those logged under \c pathPrefix.  Returns
+       false, like Seek, if the log has no such run.
+     */
+    static bool SeekRun(const char * pathPrefix, Tile<EC> & tile, u32 run) ;
+
+    /**
+       Restore every tile of \c grid, from logs under \c gridPrefix
+       (see MakeTilePathPrefix), to its state as it began run \c run,
+       then refresh the grid's caches.  Returns false, after logging
+       which tiles failed, if any tile could not be restored; the grid
+       is then inconsistent.  Call only while the grid is not running.
+     */
+    template <class GRID>
+    static bool SeekGrid(const char * gridPrefix, GRID & grid, u32 run) ;
+
+  private:
+    enum
+    {
+      ATOM_WORDS = BV::ARRAY_LENGTH,
+      SITE_WORDS = 2 * ATOM_WORDS + 4,  // Atom, base atom, paint, touch type, last touch
+      ITEM_BYTES = sizeof(EventHistoryItem),
+      MAX_EVENT_BYTES = (U8_MAX + 1) * ITEM_BYTES,  // START plus at most U8_MAX counted items
+      RECORD_KEYFRAME = 0xff, // First byte of a keyframe record; events start with START
+      RECORD_RUN = 0xfe,      // First byte of a run record
+      RUN_BYTES = 2 * ITEM_BYTES
+    };
+
+    struct SegmentHeader
+    {
+      char m_magic[8];
+      u32 m_byteOrderMark;
+      u32 m_version;
+      u32 m_tileWidth;
+      u32 m_tileHeight;
+      u32 m_atomWords;
+      u32 m_segmentNumber;
+      u32 m_firstRun;     //< Runs logged before this segment
+      u64 m_firstEvent;   //< Events logged before this segment
+      u64 m_usedBytes;    //< Header and complete records
+    };
+
+    Tile<EC> & m_tile;
+    char m_pathPrefix[MAX_PATH_LENGTH];
+    char m_path[MAX_PATH_LENGTH];  //< Current segment
+    u32 m_keyframeEvents;
+    u32 m_segmentBytes;
+    u32 m_segmentNumber;
+
+    u8 * m_segment;      //< Mapping of the current segment, or 0 if closed
+    u32 m_used;          //< Bytes written to m_segment
+    u64 m_eventsLogged;
+    u64 m_keyframeEvent; //< m_eventsLogged as of the latest keyframe
+    u32 m_runsLogged;
+    u64 m_stoppedDigest; //< Digest of the Tile as of Open or Paused
+    bool m_running;      //< Resuming since then
+
+    u32 GetKeyframeBytes() const
+    {
+      return ITEM_BYTES + m_tile.TILE_WIDTH * m_tile.TILE_HEIGHT * SITE_WORDS * sizeof(u32);
+    }
+
+    SegmentHeader & GetHeader()
+    {
+      return *(SegmentHeader *) m_segment;
+    }
+
+    static void MakeSegmentPath(char * buffer, const char * pathPrefix, u32 segmentNumber) ;
+
+    /**
+       Finish any current segment and start segment \c segmentNumber
+       with a keyframe.
+     */
+    bool StartSegment(u32 segmentNumber) ;
+
+    void FinishSegment() ;
+
+    /**
+       Ensure room for \c bytes more, after a keyframe if \c
+       keyframe, by starting a new segment (which begins with a
+       keyframe) if needed.  Returns false, after logging an error, if
+       a new segment was needed but couldn't be started, which leaves
+       the log closed.
+     */
+    bool MakeRoom(u32 bytes, bool keyframe) ;
+
+    void WriteRun() ;
+
+    void WriteKeyframe() ;
+
+    /**
+       Store the SITE_WORDS words a keyframe holds for \c site
+     */
+    static void GetSiteWords(const S & site, u32 * words) ;
+
+    /**
+       A 64-bit FNV-1a hash of everything a keyframe would hold
+     */
+    u64 Digest() const ;
+
+    static void ReadKeyframe(const u8 * record, Tile<EC> & tile) ;
+
+    static bool ReadSegmentHeader(const char * path, SegmentHeader & header) ;
+
+    static bool IsCompatible(const SegmentHeader & header, const Tile<EC> & tile) ;
+
+    /**
+       Seek or, if \c run is nonzero, SeekRun
+     */
+    static bool Restore(const char * pathPrefix, Tile<EC> & tile, u64 eventNumber, u32 run) ;
+
+    friend class EventHistoryLog_Test;
+  };
+} /* namespace MFM */
+
+#include "EventHistoryLog.tcc"
+
+#endif /* EVENTHISTORYLOG_H */
@@ -0,0 +1,535 @@
+/* -*- C++ -*- */
+#include "Logger.h"
+#include <stdio.h>     /* For snprintf, fopen */
+#include <string.h>    /* For memcpy, memcmp, strlen */
+#include <fcntl.h>     /* For open */
+#include <unistd.h>    /* For ftruncate, truncate, close, unlink */
+#include <sys/mman.h>  /* For mmap, munmap */
+
+namespace MFM
+{
+  template <class EC>
+  const char EventHistoryLog<EC>::LOG_MAGIC[8] = { 'M', 'F', 'E', 'H', 'L', 'O', 'G', '\n' };
+
+  template <class EC>
+  EventHistoryLog<EC>::EventHistoryLog(Tile<EC> & tile)
+    : m_tile(tile)
+    , m_keyframeEvents(DEFAULT_KEYFRAME_EVENTS)
+    , m_segmentBytes(DEFAULT_SEGMENT_BYTES)
+    , m_segmentNumber(0)
+    , m_segment(0)
+    , m_used(0)
+    , m_eventsLogged(0)
+    , m_keyframeEvent(0)
+    , m_runsLogged(0)
+    , m_stoppedDigest(0)
+    , m_running(false)
+  {
+    m_pathPrefix[0] = '\0';
+    m_path[0] = '\0';
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::MakeSegmentPath(char * buffer, const char * pathPrefix, u32 segmentNumber)
+  {
+    snprintf(buffer, MAX_PATH_LENGTH, "%s-%06d.ehl", pathPrefix, segmentNumber);
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::MakeTilePathPrefix(char * buffer, const char * gridPrefix, u32 x, u32 y)
+  {
+    snprintf(buffer, MAX_PATH_LENGTH, "%s-%02d-%02d", gridPrefix, x, y);
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::Open(const char * pathPrefix, u32 keyframeEvents, u32 segmentBytes)
+  {
+    MFM_API_ASSERT_NONNULL(pathPrefix);
+    MFM_API_ASSERT_STATE(!IsOpen());
+    MFM_API_ASSERT_ARG(strlen(pathPrefix) + 12 < MAX_PATH_LENGTH);
+
+    m_keyframeEvents = keyframeEvents > 0 ? keyframeEvents : 1;
+    m_segmentBytes = segmentBytes;
+    if (m_segmentBytes < sizeof(SegmentHeader) + GetKeyframeBytes() + MAX_EVENT_BYTES)
+    {
+      LOG.Error("Event log segments of %d bytes can't hold a %d byte keyframe",
+                m_segmentBytes, GetKeyframeBytes());
+      return false;
+    }
+
+    strcpy(m_pathPrefix, pathPrefix);
+
+    // Seek must not mistake an earlier log's segments for ours
+    for (u32 n = 1; ; ++n)
+    {
+      MakeSegmentPath(m_path, m_pathPrefix, n);
+      if (unlink(m_path) != 0)
+      {
+        break;
+      }
+    }
+
+    m_eventsLogged = 0;
+    m_runsLogged = 0;
+    if (!StartSegment(0))
+    {
+      return false;
+    }
+    m_stoppedDigest = Digest();
+    m_running = false;
+    m_tile.GetEventHistoryBuffer().SetSink(this);
+    return true;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::Close()
+  {
+    // Even if a failed segment already closed us
+    if (m_tile.GetEventHistoryBuffer().GetSink() == this)
+    {
+      m_tile.GetEventHistoryBuffer().SetSink(0);
+    }
+    FinishSegment();
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::StartSegment(u32 segmentNumber)
+  {
+    FinishSegment();
+
+    MakeSegmentPath(m_path, m_pathPrefix, segmentNumber);
+    int fd = open(m_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+      LOG.Error("Can't create event log segment '%s'", m_path);
+      return false;
+    }
+    void * map = MAP_FAILED;
+    if (ftruncate(fd, m_segmentBytes) == 0)
+    {
+      map = mmap(0, m_segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);  // The mapping stays valid
+    if (map == MAP_FAILED)
+    {
+      LOG.Error("Can't map %d bytes of event log segment '%s'", m_segmentBytes, m_path);
+      return false;
+    }
+
+    m_segment = (u8 *) map;
+    m_segmentNumber = segmentNumber;
+    m_used = sizeof(SegmentHeader);
+
+    SegmentHeader & h = GetHeader();
+    memcpy(h.m_magic, LOG_MAGIC, sizeof(h.m_magic));
+    h.m_byteOrderMark = BYTE_ORDER_MARK;
+    h.m_version = LOG_VERSION;
+    h.m_tileWidth = m_tile.TILE_WIDTH;
+    h.m_tileHeight = m_tile.TILE_HEIGHT;
+    h.m_atomWords = ATOM_WORDS;
+    h.m_segmentNumber = segmentNumber;
+    h.m_firstRun = m_runsLogged;
+    h.m_firstEvent = m_eventsLogged;
+    h.m_usedBytes = m_used;
+
+    WriteKeyframe();
+    return true;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::FinishSegment()
+  {
+    if (!m_segment)
+    {
+      return;
+    }
+    GetHeader().m_usedBytes = m_used;
+    munmap(m_segment, m_segmentBytes);
+    m_segment = 0;
+
+    // Give back the unused tail of the segment
+    if (truncate(m_path, m_used) != 0)
+    {
+      LOG.Warning("Can't trim event log segment '%s'", m_path);
+    }
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::WriteKeyframe()
+  {
+    MFM_API_ASSERT_STATE(m_used + GetKeyframeBytes() <= m_segmentBytes);
+
+    u8 * record = &m_segment[m_used];
+    u32 header[ITEM_BYTES / sizeof(u32)];
+    memset(header, 0, sizeof(header));
+    memcpy(&header[1], &m_eventsLogged, sizeof(u64));
+    memcpy(record, header, ITEM_BYTES);
+    record[0] = RECORD_KEYFRAME;
+
+    u32 * words = (u32 *) &record[ITEM_BYTES];
+    const u32 sites = m_tile.TILE_WIDTH * m_tile.TILE_HEIGHT;
+    for (u32 i = 0; i < sites; ++i)
+    {
+      GetSiteWords(m_tile.GetSiteByNumber(i), words);
+      words += SITE_WORDS;
+    }
+
+    m_used += GetKeyframeBytes();
+    m_keyframeEvent = m_eventsLogged;
+    GetHeader().m_usedBytes = m_used;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::GetSiteWords(const S & site, u32 * words)
+  {
+    const Base<AC> & base = site.GetBase();
+    const SiteTouchSensor & sts = base.GetSensory().m_touchSensor;
+    site.GetAtom().GetBits().ToArray(words);
+    base.GetBaseAtom().GetBits().ToArray(words + ATOM_WORDS);
+    words += 2 * ATOM_WORDS;
+    *words++ = base.GetPaint();
+    *words++ = sts.m_touchType;
+    *words++ = (u32) sts.m_lastTouchEventCount;
+    *words++ = (u32) (sts.m_lastTouchEventCount >> 32);
+  }
+
+  template <class EC>
+  u64 EventHistoryLog<EC>::Digest() const
+  {
+    const u64 FNV_PRIME = (((u64) 0x100) << 32) | 0x1b3;
+    u64 hash = (((u64) 0xcbf29ce4) << 32) | 0x84222325;
+    u32 words[SITE_WORDS];
+    const u32 sites = m_tile.TILE_WIDTH * m_tile.TILE_HEIGHT;
+    for (u32 i = 0; i < sites; ++i)
+    {
+      GetSiteWords(m_tile.GetSiteByNumber(i), words);
+      for (u32 w = 0; w < SITE_WORDS; ++w)
+      {
+        hash = (hash ^ words[w]) * FNV_PRIME;  // A word at a time
+      }
+    }
+    return hash;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::ReadKeyframe(const u8 * record, Tile<EC> & tile)
+  {
+    const u32 * words = (const u32 *) &record[ITEM_BYTES];
+    const u32 sites = tile.TILE_WIDTH * tile.TILE_HEIGHT;
+    for (u32 i = 0; i < sites; ++i)
+    {
+      S & site = tile.GetSiteByNumber(i);
+      Base<AC> & base = site.GetBase();
+      SiteTouchSensor & sts = base.GetSensory().m_touchSensor;
+      site.GetAtom().GetBits().FromArray(words);
+      base.GetBaseAtom().GetBits().FromArray(words + ATOM_WORDS);
+      words += 2 * ATOM_WORDS;
+      base.SetPaint(*words++);
+      sts.m_touchType = (SiteTouchType) *words++;
+      sts.m_lastTouchEventCount = *words++;
+      sts.m_lastTouchEventCount |= ((u64) *words++) << 32;
+    }
+    tile.NeedAtomRecount();
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::BeginEvent()
+  {
+    if (!IsOpen())
+    {
+      return;
+    }
+
+    MakeRoom(MAX_EVENT_BYTES, m_eventsLogged - m_keyframeEvent >= m_keyframeEvents);
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::MakeRoom(u32 bytes, bool keyframe)
+  {
+    const u32 needed = bytes + (keyframe ? GetKeyframeBytes() : 0);
+    if (m_used + needed <= m_segmentBytes)
+    {
+      if (keyframe)
+      {
+        WriteKeyframe();
+      }
+      return true;
+    }
+
+    const u32 next = m_segmentNumber + 1;
+    if (!StartSegment(next))  // Begins with a keyframe
+    {
+      LOG.Error("Event log '%s' stops after event %d: can't start segment %d",
+                m_pathPrefix, (u32) m_eventsLogged, next);
+      return false;
+    }
+    return true;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::WriteRun()
+  {
+    MFM_API_ASSERT_STATE(m_used + RUN_BYTES <= m_segmentBytes);
+
+    ++m_runsLogged;
+    u32 record[RUN_BYTES / sizeof(u32)];
+    memset(record, 0, sizeof(record));
+    memcpy(&record[1], &m_eventsLogged, sizeof(u64));
+    record[3] = m_runsLogged;
+    memcpy(&m_segment[m_used], record, RUN_BYTES);
+    m_segment[m_used] = RECORD_RUN;
+
+    m_used += RUN_BYTES;
+    GetHeader().m_usedBytes = m_used;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::Paused()
+  {
+    // Only the first Paused after running sees the Tile as its
+    // events left it
+    if (!IsOpen() || !m_running)
+    {
+      return;
+    }
+    m_stoppedDigest = Digest();
+    m_running = false;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::Resuming()
+  {
+    if (!IsOpen())
+    {
+      return;
+    }
+    const bool changed = !m_running && Digest() != m_stoppedDigest;
+    if (MakeRoom(RUN_BYTES + MAX_EVENT_BYTES, changed))
+    {
+      WriteRun();
+    }
+    m_running = true;
+  }
+
+  template <class EC>
+  void EventHistoryLog<EC>::AppendItems(const EventHistoryItem * items, u32 count)
+  {
+    if (!IsOpen())
+    {
+      return;
+    }
+
+    const u32 bytes = count * ITEM_BYTES;
+    MFM_API_ASSERT_STATE(m_used + bytes <= m_segmentBytes);
+    memcpy(&m_segment[m_used], items, bytes);
+    m_used += bytes;
+
+    if (items[count - 1].IsEnd())
+    {
+      ++m_eventsLogged;
+      GetHeader().m_usedBytes = m_used;
+    }
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::ReadSegmentHeader(const char * path, SegmentHeader & header)
+  {
+    FILE * fp = fopen(path, "rb");
+    if (!fp)
+    {
+      return false;
+    }
+    bool ret = fread(&header, 1, sizeof(header), fp) == sizeof(header);
+    fclose(fp);
+    return ret
+      && !memcmp(header.m_magic, LOG_MAGIC, sizeof(LOG_MAGIC))
+      && header.m_byteOrderMark == BYTE_ORDER_MARK
+      && header.m_version == LOG_VERSION;
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::IsCompatible(const SegmentHeader & header, const Tile<EC> & tile)
+  {
+    return header.m_tileWidth == tile.TILE_WIDTH
+      && header.m_tileHeight == tile.TILE_HEIGHT
+      && header.m_atomWords == ATOM_WORDS;
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::Seek(const char * pathPrefix, Tile<EC> & tile, u64 eventNumber)
+  {
+    return Restore(pathPrefix, tile, eventNumber, 0);
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::SeekRun(const char * pathPrefix, Tile<EC> & tile, u32 run)
+  {
+    MFM_API_ASSERT_ARG(run > 0);
+    return Restore(pathPrefix, tile, 0, run);
+  }
+
+  template <class EC>
+  template <class GRID>
+  bool EventHistoryLog<EC>::SeekGrid(const char * gridPrefix, GRID & grid, u32 run)
+  {
+    MFM_API_ASSERT_NONNULL(gridPrefix);
+
+    char prefix[MAX_PATH_LENGTH];
+    bool ret = true;
+    for (u32 y = 0; y < grid.GetHeight(); ++y)
+    {
+      for (u32 x = 0; x < grid.GetWidth(); ++x)
+      {
+        MakeTilePathPrefix(prefix, gridPrefix, x, y);
+        if (!SeekRun(prefix, grid.GetTile(x, y), run))
+        {
+          LOG.Error("Can't restore tile (%d,%d) to run %d", x, y, run);
+          ret = false;
+        }
+      }
+    }
+
+    // Keyframes hold caches as they were; rebuild them from the owners
+    grid.RefreshAllCaches();
+    return ret;
+  }
+
+  template <class EC>
+  bool EventHistoryLog<EC>::Restore(const char * pathPrefix, Tile<EC> & tile, u64 eventNumber, u32 run)
+  {
+    MFM_API_ASSERT_NONNULL(pathPrefix);
+
+    // Find the last segment starting at or before our target
+    char path[MAX_PATH_LENGTH];
+    char found[MAX_PATH_LENGTH];
+    SegmentHeader header;
+    bool any = false;
+    for (u32 n = 0; ; ++n)
+    {
+      MakeSegmentPath(path, pathPrefix, n);
+      SegmentHeader h;
+      if (!ReadSegmentHeader(path, h) ||
+          (run ? h.m_firstRun >= run : h.m_firstEvent > eventNumber))
+      {
+        break;
+      }
+      header = h;
+      strcpy(found, path);
+      any = true;
+    }
+    if (!any)
+    {
+      if (run)
+        LOG.Error("No event log segment under '%s' holds run %d", pathPrefix, run);
+      else
+        LOG.Error("No event log segment under '%s' holds event %d", pathPrefix, (u32) eventNumber);
+      return false;
+    }
+    if (!IsCompatible(header, tile))
+    {
+      LOG.Error("Event log '%s' is for a %dx%d tile", found, header.m_tileWidth, header.m_tileHeight);
+      return false;
+    }
+
+    int fd = open(found, O_RDONLY);
+    if (fd < 0)
+    {
+      return false;
+    }
+    const u32 length = (u32) header.m_usedBytes;
+    void * map = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+      LOG.Error("Can't map event log segment '%s'", found);
+      return false;
+    }
+    const u8 * segment = (const u8 *) map;
+    const u32 keyframeBytes = ITEM_BYTES + tile.TILE_WIDTH * tile.TILE_HEIGHT * SITE_WORDS * sizeof(u32);
+
+    // Find the last keyframe at or before eventNumber, or before the
+    // record of our run
+    u32 keyframeAt = 0;
+    u64 keyframeEvent = 0;
+    bool foundRun = false;
+    for (u32 at = sizeof(SegmentHeader); at < length; )
+    {
+      if (segment[at] == RECORD_KEYFRAME)
+      {
+        u64 event;
+        memcpy(&event, &segment[at + sizeof(u32)], sizeof(u64));
+        if (!run && event > eventNumber)
+        {
+          break;
+        }
+        keyframeAt = at;
+        keyframeEvent = event;
+        at += keyframeBytes;
+      }
+      else if (segment[at] == RECORD_RUN)
+      {
+        u32 record[RUN_BYTES / sizeof(u32)];
+        memcpy(record, &segment[at], RUN_BYTES);
+        if (run && record[3] == run)
+        {
+          memcpy(&eventNumber, &record[1], sizeof(u64));
+          foundRun = true;
+          break;
+        }
+        at += RUN_BYTES;
+      }
+      else
+      {
+        const EventHistoryItem & start = *(const EventHistoryItem *) &segment[at];
+        MFM_API_ASSERT_STATE(start.IsStart());
+        at += (start.GetHeaderItems() + 1) * ITEM_BYTES;
+      }
+    }
+
+    bool ret = keyframeAt != 0 && (!run || foundRun);
+    if (run && !foundRun)
+    {
+      LOG.Error("Event log under '%s' ends before run %d", pathPrefix, run);
+    }
+    if (ret)
+    {
+      ReadKeyframe(&segment[keyframeAt], tile);
+
+      // Then replay the events since
+      u64 event = keyframeEvent;
+      u32 at = keyframeAt + keyframeBytes;
+      while (event < eventNumber && at < length)
+      {
+        if (segment[at] == RECORD_KEYFRAME)
+        {
+          at += keyframeBytes;
+          continue;
+        }
+        if (segment[at] == RECORD_RUN)
+        {
+          at += RUN_BYTES;
+          continue;
+        }
+        const EventHistoryItem * items = (const EventHistoryItem *) &segment[at];
+        const u32 count = items[0].GetHeaderItems();
+        const SPoint ctr = items[0].GetHeaderSiteInTile();
+        for (u32 i = 1; i < count; ++i)  // Skipping START and END
+        {
+          MFM_API_ASSERT_STATE(items[i].IsDelta());
+          EventHistoryBuffer<EC>::ApplyDelta(true, items[i].mDeltaItem, tile, ctr);
+        }
+        at += (count + 1) * ITEM_BYTES;
+        ++event;
+      }
+      ret = event == eventNumber;
+      if (!ret)
+      {
+        // A crash, or a segment that couldn't be started, cut it short
+        LOG.Error("Event log under '%s' ends at event %d, before event %d",
+                  pathPrefix, (u32) event, (u32) eventNumber);
+      }
+    }
+    munmap(map, length);
+    return ret;
+  }
+} /* namespace MFM */
@@ -171,6 +171,22 @@ namespace MFM
       return m_grid;
     }
 
+    /**
+     * Control whether WriteSection emits a Site(..) line for every
+     * site in the grid (the default).  GridSnapshot turns this off
+     * while writing its configuration text, and stores the sites
+     * itself in binary.
+     */
+    void SetWriteSites(bool writeSites)
+    {
+      m_writeSites = writeSites;
+    }
+
+    bool IsWriteSites() const
+    {
+      return m_writeSites;
+    }
+
   private:
 
     /**
@@ -189,6 +205,8 @@ namespace MFM
 
     u32 m_registeredElementCount;
 
+    bool m_writeSites;
+
     /**
      * The ElementRegistry to lookup UUIDs in.
      */
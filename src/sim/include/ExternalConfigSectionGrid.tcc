@@ -273,6 +273,7 @@ namespace MFM
     , m_grid(grid)
     , m_errorsTo(0)
     , m_registeredElementCount(0)
+    , m_writeSites(true)
     , m_elementRegistry(grid.GetElementRegistry())
     , m_fcDefineGridSize(*this)
     , m_fcRegisterElement(*this)
@@ -357,6 +358,13 @@ namespace MFM
 	byteSink.Printf(")\n");
       }
 
+    /* Then, unless someone else is handling them, */
+    if (!m_writeSites)
+    {
+      byteSink.WriteNewline();
+      return;
+    }
+
     /* Then, write ALL the damn sites, */
     /* and GA all live atoms. */
 
@@ -480,7 +488,7 @@ namespace MFM
     T atom = elt.GetDefaultAtom();
 
     atom.ReadStateBits(hexData);
-    m_grid.PlaceAtom(atom, pt);
+    m_grid.PlaceAtomInOwner(atom, pt);  // ReadFinalize refreshes the caches
 
     return true;
   }
@@ -492,7 +500,7 @@ namespace MFM
     T atom = elt.GetDefaultAtom();
 
     atom.ReadStateBits(bv);
-    m_grid.PlaceAtom(atom, pt);
+    m_grid.PlaceAtomInOwner(atom, pt);  // ReadFinalize refreshes the caches
 
     return true;
   }
@@ -37,6 +37,7 @@
 #include "Sense.h"
 #include "GridConfig.h"
 #include "GridTransceiver.h"
+#include "SPSCChannel.h"
 #include "ElementRegistry.h"
 #include "Logger.h"
 #include "LineCountingByteSource.h"
@@ -57,6 +58,7 @@ namespace MFM {
     typedef typename AC::ATOM_TYPE T;
 
     enum { MAX_TILES_SUPPORTED = 500 };  // Yeah right.  Used for sizing m_rgi
+    enum { MAX_TILE_WORKERS = 256 };     // Upper limit for SetTileWorkerCount
 
     enum { R = EC::EVENT_WINDOW_RADIUS};
     enum { TILE_WIDTH = GC::TILE_WIDTH};
@@ -73,6 +75,21 @@ namespace MFM {
 
     u32 m_seed;
 
+    Random::Generator m_tileGenerator;
+
+    u32 m_nextRefreshTile;  // Next tile for RefreshAllCaches to claim; __atomic access
+
+    static void * RefreshCachesRunner(void * arg) ;
+
+    void RefreshCachesOfClaimedTiles() ;
+
+    /**
+       Copy the shared sites of the tile at \c tileInGrid into the
+       caches of its connected neighbors, as PlaceAtom would, but
+       writing those cache sites directly.
+     */
+    void RefreshCachesFrom(const SPoint & tileInGrid) ;
+
     void InitSeed();
 
     void InitDummyTiles();
@@ -106,18 +123,50 @@ namespace MFM {
      */
     LonglivedLock & GetIntertileLock(u32 xtile, u32 ytile, Dir dir, bool isStaggered) ;
 
+    struct TileDriverControl;
+
     struct TileDriver {
       enum State { PAUSED, ADVANCING, EXIT_REQUEST };
+
+      /**
+         Idle advances a thread-per-tile runner makes, yielding in
+         between, before it parks.  Parks start at MIN_PARK_USEC and
+         double while the tile stays idle, up to MAX_PARK_USEC, which
+         bounds how late a missed wakeup can be noticed.
+       */
+      enum { SPINS_BEFORE_PARK = 64, MIN_PARK_USEC = 50, MAX_PARK_USEC = 2000 };
+
+      /**
+         Most advances a thread-per-tile runner makes per AdvanceBatch
+       */
+      enum { ADVANCES_PER_BATCH = 8 };
+
       Mutex m_stateLock;
+      Mutex::Condition m_stateChanged; // Broadcast by SetState and Wake
       State m_state;
+      bool m_wakePending;              // Guarded by m_stateLock
+      u32 m_parked;                    // Nonzero while in Park; __atomic access
       SPoint m_loc;
       Grid* m_gridPtr;
       pthread_t m_threadId;
       GridTransceiver m_channels[4]; // 4: NE, E, SE, S == dir-Dirs::NORTHEAST
+      SPSCChannel m_spscChannels[4]; // Used instead of m_channels if !m_simulateBandwidth
+      TileDriver * m_neighbors[Dirs::DIR_COUNT]; // Drivers sharing a channel with us
+      u32 m_neighborCount;
+      TileDriverControl * m_pendingControl; // Not yet acknowledged; __atomic access
+      u32 m_batchAdvances;           // AdvanceBatch progress
+      u32 m_batchWorked;
       TileDriver()
-        : m_state(PAUSED)
+        : m_stateChanged(m_stateLock)
+        , m_state(PAUSED)
+        , m_wakePending(false)
+        , m_parked(0)
         , m_loc(-1,-1)
         , m_gridPtr(0)
+        , m_neighborCount(0)
+        , m_pendingControl(0)
+        , m_batchAdvances(0)
+        , m_batchWorked(0)
       { }
 
       ~TileDriver() {} //avoid inline error
@@ -129,9 +178,91 @@ namespace MFM {
       }
 
       void SetState(State newState)
+      {
+        {
+          Mutex::ScopeLock lock(m_stateLock);
+          m_state = newState;
+          m_stateChanged.Broadcast();
+        }
+        if (m_gridPtr)
+          m_gridPtr->WakeTileWorkers(true);
+      }
+
+      /**
+         Block the calling thread while this TileDriver is PAUSED.
+         Returns the state that ended the wait.
+       */
+      State WaitWhilePaused()
       {
         Mutex::ScopeLock lock(m_stateLock);
-        m_state = newState;
+        while (m_state == PAUSED)
+        {
+          m_stateChanged.Wait();
+        }
+        return m_state;
+      }
+
+      /**
+         Called by the runner of an ADVANCING tile that has been idle
+         for a while.  Announces that it is parking, advances once more
+         to catch anything that arrived before the announcement could
+         be seen, and then, if that too did nothing, waits up to \c
+         usec microseconds or until Wake or SetState.  Returns true if
+         the final advance did work, so no wait happened.
+       */
+      bool Park(u32 usec)
+      {
+        __atomic_store_n(&m_parked, 1, __ATOMIC_SEQ_CST);
+        bool worked = AdvanceOnce();
+        if (!worked)
+        {
+          Mutex::ScopeLock lock(m_stateLock);
+          if (!m_wakePending && m_state == ADVANCING)
+          {
+            m_stateChanged.WaitUsec(usec);
+          }
+          m_wakePending = false;
+        }
+        __atomic_store_n(&m_parked, 0, __ATOMIC_SEQ_CST);
+        return worked;
+      }
+
+      /**
+         Get this tile advancing again soon if its runner is parked,
+         because something (such as a channel write) may have given it
+         work.  Cheap when nobody is parked.
+       */
+      void Wake()
+      {
+        if (__atomic_load_n(&m_parked, __ATOMIC_SEQ_CST))
+        {
+          Mutex::ScopeLock lock(m_stateLock);
+          m_wakePending = true;
+          m_stateChanged.Broadcast();
+        }
+      }
+
+      void AddNeighbor(TileDriver & other)
+      {
+        for (u32 i = 0; i < m_neighborCount; ++i)
+        {
+          if (m_neighbors[i] == &other) return;
+        }
+        MFM_API_ASSERT_STATE(m_neighborCount < Dirs::DIR_COUNT);
+        m_neighbors[m_neighborCount++] = &other;
+      }
+
+      /**
+         Wake the drivers on the far side of our channels, which is
+         where anything this tile just wrote will be read.
+       */
+      void WakeNeighbors()
+      {
+        for (u32 i = 0; i < m_neighborCount; ++i)
+        {
+          m_neighbors[i]->Wake();
+        }
+        m_gridPtr->WakeTileWorkers(false);
       }
 
       Tile<EC> & GetTile()
@@ -139,6 +270,84 @@ namespace MFM {
         return m_gridPtr->GetTile(m_loc);
       }
 
+      /**
+         Drive this tile's transceivers up to now, then drive the tile
+         itself once.  Must be called only by the thread currently
+         responsible for this TileDriver, with MFMPtrToErrEnvStackPtr
+         set to the tile's error stack.  Returns false if the tile
+         accomplished nothing.
+       */
+      bool AdvanceOnce()
+      {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (u32 c = 0; c < 4; ++c)
+        {
+          if(m_channels[c].IsEnabled()) //esa
+            m_channels[c].AdvanceToTime(now);
+        }
+        return GetTile().Advance();
+      }
+
+      /**
+         AdvanceOnce up to \c maxAdvances times, stopping after the
+         first that accomplishes nothing.  Returns how many of them
+         accomplished something.  Same calling restrictions as
+         AdvanceOnce.
+
+         With Grid::SetBatchedUnwind, the whole batch runs inside one
+         unwind_protect.  After a failure, the Tile recovers as it
+         would have inside its own unwind_protect, and the rest of the
+         batch continues in a fresh one.
+       */
+      u32 AdvanceBatch(u32 maxAdvances)
+      {
+        // These are members, not locals, so they survive a FAIL
+        m_batchAdvances = 0;
+        m_batchWorked = 0;
+
+        if (!m_gridPtr->m_batchedUnwind)
+        {
+          RunBatch(maxAdvances);
+          return m_batchWorked;
+        }
+
+        Tile<EC> & tile = GetTile();
+        while (m_batchAdvances < maxAdvances)
+        {
+          tile.SetUnwindBatched(true);
+          unwind_protect(
+          {
+            tile.SetUnwindBatched(false);
+            tile.RecoverBatchFailure(MFMThrownFailCode,
+                                     MFMThrownFromFile,
+                                     MFMThrownFromLineNo,
+                                     MFMThrownBacktraceArray,
+                                     MFMThrownBacktraceSize);
+            ++m_batchWorked;  // The failed event happened, anyway
+          },
+          {
+            RunBatch(maxAdvances);
+          });
+        }
+        tile.SetUnwindBatched(false);
+        return m_batchWorked;
+      }
+
+      void RunBatch(u32 maxAdvances)
+      {
+        while (m_batchAdvances < maxAdvances)
+        {
+          ++m_batchAdvances;
+          if (!AdvanceOnce())
+          {
+            m_batchAdvances = maxAdvances;
+            break;
+          }
+          ++m_batchWorked;
+        }
+      }
+
     };
 
     TileDriver * const m_tileDrivers;
@@ -149,6 +358,152 @@ namespace MFM {
     bool m_threadsInitted;
     static void * TileDriverRunner(void *) ;
 
+    /**
+       One thread of the fixed-size tile worker pool.  A TileWorker
+       repeatedly takes a TileDriver off the front of its own deque,
+       advances it for a short quantum, and puts it back on the end.
+       When its deque is empty it steals from the end of another
+       worker's deque.  A TileDriver is in at most one deque at a
+       time, and is in none while it is being advanced, so each tile
+       is still driven by only one thread at once.
+     */
+    struct TileWorker {
+      enum { ADVANCES_PER_QUANTUM = 8 };
+      Mutex m_dequeLock;
+      TileDriver * m_deque[MAX_TILES_SUPPORTED];
+      u32 m_head;
+      u32 m_count;
+      Grid* m_gridPtr;
+      pthread_t m_threadId;
+      Random m_random;  // for picking steal victims
+      TileWorker()
+        : m_head(0)
+        , m_count(0)
+        , m_gridPtr(0)
+      { }
+
+      ~TileWorker() {} //avoid inline error
+
+      void PushBack(TileDriver * td)
+      {
+        Mutex::ScopeLock lock(m_dequeLock);
+        MFM_API_ASSERT_STATE(m_count < MAX_TILES_SUPPORTED);
+        m_deque[(m_head + m_count++) % MAX_TILES_SUPPORTED] = td;
+      }
+
+      TileDriver * PopFront()
+      {
+        Mutex::ScopeLock lock(m_dequeLock);
+        if (m_count == 0) return 0;
+        TileDriver * td = m_deque[m_head];
+        m_head = (m_head + 1) % MAX_TILES_SUPPORTED;
+        --m_count;
+        return td;
+      }
+
+      TileDriver * PopBack()
+      {
+        Mutex::ScopeLock lock(m_dequeLock);
+        if (m_count == 0) return 0;
+        return m_deque[(m_head + --m_count) % MAX_TILES_SUPPORTED];
+      }
+    };
+
+    u32 m_tileWorkerCount;   // 0 means one thread per tile
+    TileWorker * m_tileWorkers;
+
+    Mutex m_liveTileLock;
+    u32 m_liveTileCount;     // TileDrivers not yet retired by EXIT_REQUEST
+
+    static void * TileWorkerRunner(void *) ;
+
+    /**
+       Try to take a TileDriver from some TileWorker other than \c
+       thief.  Returns null if every other deque was empty.
+     */
+    TileDriver * StealTileDriver(TileWorker & thief) ;
+
+    u32 RetireTileDriver()
+    {
+      Mutex::ScopeLock lock(m_liveTileLock);
+      MFM_API_ASSERT_STATE(m_liveTileCount > 0);
+      return --m_liveTileCount;
+    }
+
+    u32 GetLiveTileCount()
+    {
+      Mutex::ScopeLock lock(m_liveTileLock);
+      return m_liveTileCount;
+    }
+
+    /**
+       Idle TileWorkers park on m_workerIdle, for at most
+       MAX_WORKER_PARK_USEC while tiles are advancing, and at most
+       MAX_PAUSED_PARK_USEC while they are all paused.
+     */
+    enum { MAX_WORKER_PARK_USEC = 2000, MAX_PAUSED_PARK_USEC = 100000 };
+
+    Mutex m_workerIdleLock;
+    Mutex::Condition m_workerIdle;
+    u32 m_workerWakeups;     // Bumped by each WakeTileWorkers; __atomic access
+    u32 m_parkedWorkers;     // TileWorkers in ParkTileWorker; __atomic access
+
+    u32 GetTileWorkerWakeups()
+    {
+      return __atomic_load_n(&m_workerWakeups, __ATOMIC_SEQ_CST);
+    }
+
+    /**
+       Wake any parked TileWorkers.  A \c stateChanged wakeup always
+       counts, so a worker about to park will notice it; other wakeups
+       are dropped when no worker is parked.
+     */
+    void WakeTileWorkers(bool stateChanged)
+    {
+      if (m_tileWorkerCount == 0)
+        return;
+      if (!stateChanged && __atomic_load_n(&m_parkedWorkers, __ATOMIC_SEQ_CST) == 0)
+        return;
+      Mutex::ScopeLock lock(m_workerIdleLock);
+      __atomic_add_fetch(&m_workerWakeups, 1, __ATOMIC_SEQ_CST);
+      m_workerIdle.Broadcast();
+    }
+
+    /**
+       Park the calling TileWorker for up to \c usec microseconds,
+       unless there have been wakeups since it read \c seenWakeups
+       from GetTileWorkerWakeups.
+     */
+    void ParkTileWorker(u32 seenWakeups, u32 usec)
+    {
+      __atomic_add_fetch(&m_parkedWorkers, 1, __ATOMIC_SEQ_CST);
+      {
+        Mutex::ScopeLock lock(m_workerIdleLock);
+        if (GetTileWorkerWakeups() == seenWakeups)
+        {
+          m_workerIdle.WaitUsec(usec);
+        }
+      }
+      __atomic_sub_fetch(&m_parkedWorkers, 1, __ATOMIC_SEQ_CST);
+    }
+
+    /**
+       During a TileDriverControl, each TileDriver acknowledges the
+       request once it is ready.  Runners check after every advance,
+       and the last acknowledgement wakes the waiting controller.
+     */
+    enum { CONTROL_WAIT_USEC = 10000, CONTROL_REPORT_SECONDS = 10 };
+
+    Mutex m_controlLock;
+    Mutex::Condition m_controlDone;
+    u32 m_controlPendingCount;   // Guarded by m_controlLock
+
+    void AcknowledgeControl(TileDriver & td) ;
+
+    bool m_simulateBandwidth; // GridTransceivers if true, else SPSCChannels
+
+    bool m_batchedUnwind;     // One unwind_protect per TileDriver::AdvanceBatch
+
     bool m_backgroundRadiationEnabled; // shadows value pushed to tiles
     bool m_foregroundRadiationEnabled; // shadows value pushed to tiles
 
@@ -242,7 +597,6 @@ namespace MFM {
       virtual void MakeRequest(TileDriver & td)
       {
         Tile<EC> & tile = td.GetTile();
-        tile.NeedAtomRecount();
         tile.RequestStateActive();
       }
       virtual bool CheckIfReady(TileDriver & td)
@@ -313,9 +667,51 @@ namespace MFM {
       m_heroTile.SetWarpFactor(wf);
     }
 
+    u32 GetEventBatchLimit() const
+    {
+      return m_heroTile.GetEventBatchLimit();
+    }
+
+    /**
+       Let every Tile initiate up to \c limit events per Advance (see
+       Tile::SetEventBatchLimit).  Takes effect at Init.
+     */
+    void SetEventBatchLimit(u32 limit)
+    {
+      if (limit == 0)
+      {
+        FAIL(ILLEGAL_ARGUMENT);
+      }
+
+      m_heroTile.SetEventBatchLimit(limit);
+    }
+
+    u32 GetTileSnapshotInterval() const
+    {
+      return m_heroTile.GetSnapshotInterval();
+    }
+
+    /**
+       Let every Tile publish a snapshot of its owned atoms after
+       every \c interval events, for observers that read tiles while
+       the grid runs (see Tile::SetSnapshotInterval).  0 disables
+       snapshots.  Takes effect at Init.
+     */
+    void SetTileSnapshotInterval(u32 interval)
+    {
+      m_heroTile.SetSnapshotInterval(interval);
+    }
+
     double GetAverageCacheRedundancy() const;
     void SetCacheRedundancy(u32 redundancyOddsType) ;
 
+    /**
+       Choose binary batched (if binary, the default) or one-per-atom
+       text (if not) cache update packets for every tile.  Should be
+       called only while the grid is paused.
+     */
+    void SetBinaryCachePackets(bool binary) ;
+
     void ReportGridStatus(Logger::Level level) ;
 
     Random& GetRandom() { return m_random; }
@@ -324,9 +720,27 @@ namespace MFM {
 
     void SetSeed(u32 seed);
 
+    /**
+       Choose the PRNG of every Tile.  Under Random::GENERATOR_PHILOX,
+       each Tile draws its own stream, numbered by its position in the
+       Grid, from the seed, so a Tile's random numbers depend only on
+       the seed and where the Tile is.  Takes effect at Init.
+     */
+    void SetTileRandomGenerator(Random::Generator type)
+    {
+      m_tileGenerator = type;
+    }
+
+    Random::Generator GetTileRandomGenerator() const
+    {
+      return m_tileGenerator;
+    }
+
     Grid(ElementRegistry<EC>& elts, u32 width, u32 height, GridLayoutPattern layout)
       : m_random()
       , m_seed(0)
+      , m_tileGenerator(Random::GENERATOR_MT)
+      , m_nextRefreshTile(0)
       , m_width(width)
       , m_height(height)
       , m_layout(layout)
@@ -334,6 +748,16 @@ namespace MFM {
       , m_intertileLocks(new LonglivedLock[m_width * m_height * MAX_LOCKS_OWNED_PER_TILE])
       , m_tileDrivers(new TileDriver[m_width * m_height * MAX_LOCKS_OWNED_PER_TILE])
       , m_threadsInitted(false)
+      , m_tileWorkerCount(0)
+      , m_tileWorkers(0)
+      , m_liveTileCount(0)
+      , m_workerIdle(m_workerIdleLock)
+      , m_workerWakeups(0)
+      , m_parkedWorkers(0)
+      , m_controlDone(m_controlLock)
+      , m_controlPendingCount(0)
+      , m_simulateBandwidth(true)
+      , m_batchedUnwind(false)
       , m_backgroundRadiationEnabled(false)
       , m_foregroundRadiationEnabled(false)
       , m_er(elts)
@@ -360,6 +784,71 @@ namespace MFM {
      */
     void InitThreads();
 
+    /**
+       Set how many worker threads InitThreads() will create to drive
+       the tiles.  With the default of 0, each tile gets its own
+       thread.  Otherwise a pool of \c workers threads (at most
+       MAX_TILE_WORKERS) shares all the tiles, using work stealing to
+       keep busy.  FAILs ILLEGAL_STATE if the threads have already
+       been initted.
+     */
+    void SetTileWorkerCount(u32 workers)
+    {
+      MFM_API_ASSERT_STATE(!m_threadsInitted);
+      MFM_API_ASSERT_ARG(workers <= MAX_TILE_WORKERS);
+      m_tileWorkerCount = workers;
+    }
+
+    u32 GetTileWorkerCount() const
+    {
+      return m_tileWorkerCount;
+    }
+
+    /**
+       True between InitThreads and the JoinTileThreads (or
+       ShutdownTileThreads) that waits for those threads to exit
+     */
+    bool HasTileThreads() const
+    {
+      return m_threadsInitted;
+    }
+
+    /**
+       Choose how Init() connects neighboring tiles.  If simulate is
+       true (the default), tiles talk through GridTransceivers that
+       model a finite data rate.  If false, they talk through
+       lock-free SPSCChannels that deliver bytes immediately.  Must
+       be called before Init() to have any effect.
+     */
+    void SetSimulateBandwidth(bool simulate)
+    {
+      m_simulateBandwidth = simulate;
+    }
+
+    bool IsSimulatingBandwidth() const
+    {
+      return m_simulateBandwidth;
+    }
+
+    /**
+       Choose how tile threads recover from FAILs.  By default each
+       event's behavior, and each atom placed in a tile, runs in its
+       own unwind_protect.  If batched is true, a tile thread instead
+       sets up one unwind_protect per batch of advances, and only
+       repeats the setjmp after a failure; see
+       Tile::RecoverBatchFailure.  Must be called while the grid is
+       paused, or before InitThreads().
+     */
+    void SetBatchedUnwind(bool batched)
+    {
+      m_batchedUnwind = batched;
+    }
+
+    bool IsBatchedUnwind() const
+    {
+      return m_batchedUnwind;
+    }
+
     /**
        Enable or disable the tiles and the transceivers.
      */
@@ -484,9 +973,14 @@ namespace MFM {
 
     ~Grid()
     {
+      if (m_threadsInitted)
+      {
+        ShutdownTileThreads();
+      }
       delete [] m_tiles;
       delete [] m_intertileLocks;
       delete [] m_tileDrivers;
+      delete [] m_tileWorkers;
     }
 
     /**
@@ -535,11 +1029,14 @@ namespace MFM {
 
     /**
      * Update all cache sites from their corresponding source,
-     * 'non-physically'.  This is thread-unsafe and no tile driver
-     * threads should be active, else races and inconsistencies are
-     * likely.
+     * 'non-physically'.  Tiles are claimed by up to \c threads
+     * threads (0: one per online processor), each tile writing its
+     * shared sites into its neighbors' caches.  Every cache site has
+     * just one source, so the threads never write the same site.
+     * This is thread-unsafe and no tile driver threads should be
+     * active, else races and inconsistencies are likely.
      */
-    void RefreshAllCaches();
+    void RefreshAllCaches(u32 threads = 0);
 
     /**
      * Return true iff tileInGrid is a legal tile coordinate in this
@@ -657,7 +1154,7 @@ namespace MFM {
     }
 
     /**
-     * Shut down all tile threads
+     * Shut down all tile threads, returning once they have all exited
      */
     void ShutdownTileThreads()
     {
@@ -667,9 +1164,18 @@ namespace MFM {
         TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
         td.SetState(TileDriver::EXIT_REQUEST);
       }
-      SleepMsec(500);
+      JoinTileThreads();
     }
 
+    /**
+     * Wait for every thread InitThreads started -- one per tile, or
+     * the tile workers -- to exit, then release the tile workers, so
+     * InitThreads may be called again.  Every tile must already have
+     * been sent an exit request (see ShutdownTileThreads).  Does
+     * nothing if no threads are running.
+     */
+    void JoinTileThreads() ;
+
     /**
      * Synchronize and pause the entire grid
      */
@@ -677,6 +1183,7 @@ namespace MFM {
     {
       PauseControl pc;
       DoTileDriverControl(pc);
+      NotifyHistorySinks(false);
     }
 
     /**
@@ -684,10 +1191,17 @@ namespace MFM {
      */
     void Unpause()
     {
+      NotifyHistorySinks(true);
       RunControl rc;
       DoTileDriverControl(rc);
     }
 
+    /**
+     * Tell every tile's EventHistorySink, if any, that its tile has
+     * stopped running, or is \c resuming.
+     */
+    void NotifyHistorySinks(bool resuming) ;
+
     /**
      * Resets all atom counts and refreshes the atoms counts in
      * every tile in the grid.
@@ -700,6 +1214,14 @@ namespace MFM {
 
     void PlaceAtomInSite(bool placeInBase, const T& atom, const SPoint& location, bool checkOnly=false);
 
+    /**
+     * Store atom at location in the tile that owns it only, leaving
+     * the caches of its neighbors stale.  For bulk loads, which call
+     * RefreshAllCaches once when done instead of updating caches site
+     * by site.
+     */
+    void PlaceAtomInOwner(const T& atom, const SPoint& location);
+
     void XRayAtom(const SPoint& location);
 
     void MaybeXRayAtom(const SPoint& location);
@@ -800,12 +1322,55 @@ namespace MFM {
 
     void WriteEPSAverageImage(ByteSink & outstrm) const;
 
+    /**
+     * Write a PGM heatmap of lock stalls at tile boundaries, as
+     * recorded by each Tile's CacheProfile (tiles without one count
+     * as stall-free).  Each tile is drawn as a 3x3 block of cells:
+     * each outer cell shows the stalls toward the neighbor in that
+     * direction, and the center cell their average.
+     */
+    void WriteCacheStallImage(ByteSink & outstrm) const;
+
     void ResetEPSCounts();
 
     u32 GetAtomCount(ElementType atomType) const;
 
     s32 GetAtomCountFromSymbol(const u8 * elementSymbol) const;
 
+    /**
+     * True once every tile has published a snapshot of its atoms (see
+     * SetTileSnapshotInterval).  From then on, snapshot readers such
+     * as CountSnapshotAtoms and GridRasterizer may run alongside the
+     * grid.
+     */
+    bool HasTileSnapshots() const;
+
+    /**
+     * Set \c counts[i] to the number of atoms of \c types[i], for each
+     * of the \c typeCount types, in the tiles' latest published
+     * snapshots.  Unlike GetAtomCount, this may be called while the
+     * grid runs; each tile is counted as of its own snapshot.  Returns
+     * false, with the counts incomplete, if some tile has not yet
+     * published one.
+     */
+    bool CountSnapshotAtoms(const ElementType * types, u32 typeCount, u32 * counts) const;
+
+    /**
+     * Copy the event layer atom at \c siteInGrid, as of its tile's
+     * latest published snapshot, to \c atom.  Like
+     * CountSnapshotAtoms, this may be called while the grid runs.
+     * Returns false if \c siteInGrid is not in the grid or its tile
+     * has not yet published a snapshot.
+     */
+    bool GetSnapshotAtom(const SPoint & siteInGrid, T & atom) const;
+
+    /**
+     * Check every tile's incrementally-maintained atom counts against
+     * a rescan (see Tile::VerifyAtomCounts).  Returns false if any
+     * disagreed.  For debugging; call only while the grid is paused.
+     */
+    bool VerifyAtomCounts() const;
+
     /**
      * Counts the number of sites which are occupied in this Grid and
      * gets a percentage, in the range [0.0 , 1.0] , describing the
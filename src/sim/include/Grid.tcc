@@ -155,6 +155,8 @@ namespace MFM {
 
 	    TileDriver & td = _getTileDriver(tpt.GetX(),tpt.GetY());
 	    GridTransceiver & gt = td.m_channels[d - Dirs::NORTHEAST];
+	    SPSCChannel & sc = td.m_spscChannels[d - Dirs::NORTHEAST];
+	    AbstractChannel & channel = m_simulateBandwidth ? (AbstractChannel &) gt : (AbstractChannel &) sc;
 	    LonglivedLock & ctl = GetIntertileLock(tpt.GetX(),tpt.GetY(),d, isStaggered);
 
 	    Dir odir = Dirs::OppositeDir(d);
@@ -162,10 +164,16 @@ namespace MFM {
 
 	    LonglivedLock & otl = isStaggered ? ctl : GetIntertileLock(npt.GetX(),npt.GetY(),odir, false); //simpler for staggered, refs not changed
 
-	    ctile.Connect(gt, ctl, d);
-	    otile.Connect(gt, otl, odir);
+	    ctile.Connect(channel, ctl, d);
+	    otile.Connect(channel, otl, odir);
 
-	    gt.SetEnabled(true);
+	    // Writers to the channel wake its reader when it's parked
+	    TileDriver & otd = _getTileDriver(npt.GetX(),npt.GetY());
+	    td.AddNeighbor(otd);
+	    otd.AddNeighbor(td);
+
+	    // An SPSCChannel needs no driving, so leave gt disabled then
+	    gt.SetEnabled(m_simulateBandwidth);
 	    gt.SetDataRate(100000000);
 	    gt.SetMaxInFlight(0);
 	  } //direction loop
@@ -204,6 +212,16 @@ namespace MFM {
     return sum / count;
   }
 
+  template <class GC>
+  void Grid<GC>::SetBinaryCachePackets(bool binary)
+  {
+    for (iterator_type i = begin(); i != end(); ++i)
+    {
+      Tile<EC> & tile = *i;
+      tile.SetBinaryCachePackets(binary);
+    }
+  }
+
   template <class GC>
   void Grid<GC>::SetCacheRedundancy(u32 redundancyOddsType)
   {
@@ -244,15 +262,84 @@ namespace MFM {
       td.SetState(TileDriver::PAUSED);
       MFM_API_ASSERT_STATE(!td.GetTile().IsDummyTile());
 
-      if (pthread_create(&td.m_threadId, NULL, TileDriverRunner, &td))
+      if (m_tileWorkerCount == 0)
       {
-        FAIL(ILLEGAL_STATE);
+        // Request this before the thread exists, so it can't land
+        // after (and cancel) the request of a prompt Unpause()
+        td.GetTile().RequestStatePassive();
+
+        if (pthread_create(&td.m_threadId, NULL, TileDriverRunner, &td))
+        {
+          FAIL(ILLEGAL_STATE);
+        }
       }
     }
 
+    if (m_tileWorkerCount > 0)
+    {
+      const u32 tiles = m_width * m_height;
+      MFM_API_ASSERT_STATE(tiles <= MAX_TILES_SUPPORTED);
+
+      m_tileWorkers = new TileWorker[m_tileWorkerCount];
+      m_liveTileCount = tiles;
+
+      /* Deal the tiles round-robin in shuffled order */
+      u32 w = 0;
+      for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
+      {
+        SPoint tpt = IteratorIndexToCoord(m_rgi.Next());
+        TileDriver & td = _getTileDriver(tpt.GetX(),tpt.GetY());
+        td.GetTile().RequestStatePassive();
+        m_tileWorkers[w].PushBack(&td);
+        w = (w + 1) % m_tileWorkerCount;
+      }
+
+      for (u32 i = 0; i < m_tileWorkerCount; ++i)
+      {
+        TileWorker & tw = m_tileWorkers[i];
+        tw.m_gridPtr = this;
+        tw.m_random.SetSeed(m_random.Create());
+        if (pthread_create(&tw.m_threadId, NULL, TileWorkerRunner, &tw))
+        {
+          FAIL(ILLEGAL_STATE);
+        }
+      }
+      LOG.Message("Driving %d tiles with %d worker threads", tiles, m_tileWorkerCount);
+    }
+
     m_threadsInitted = true;
   }
 
+  template <class GC>
+  void Grid<GC>::JoinTileThreads()
+  {
+    if (!m_threadsInitted)
+    {
+      return;
+    }
+
+    if (m_tileWorkerCount == 0)
+    {
+      for (iterator_type i = begin(); i != end(); ++i)
+      {
+        TileDriver & td = _getTileDriver(i.GetX(),i.GetY());
+        MFM_API_ASSERT_STATE(td.GetState() == TileDriver::EXIT_REQUEST);
+        pthread_join(td.m_threadId, NULL);
+      }
+    }
+    else
+    {
+      // Workers exit once every tile has been retired
+      for (u32 i = 0; i < m_tileWorkerCount; ++i)
+      {
+        pthread_join(m_tileWorkers[i].m_threadId, NULL);
+      }
+      delete [] m_tileWorkers;
+      m_tileWorkers = 0;
+    }
+    m_threadsInitted = false;
+  }
+
   template <class GC>
   void Grid<GC>::SetGridRunning(bool running)
   {
@@ -288,10 +375,9 @@ namespace MFM {
 		  td->m_loc.GetY(),
 		  ctile.GetLabel()));
 
-    ctile.RequestStatePassive();
-
     bool running = true;
-    u32 pauseUsec = 0;
+    u32 idleAdvances = 0;
+    u32 parkUsec = TileDriver::MIN_PARK_USEC;
     while (running)
     {
       switch (td->GetState())
@@ -302,37 +388,143 @@ namespace MFM {
 
       case TileDriver::ADVANCING:
       {
-        // Drive this tile's transceivers
-        timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        for (u32 c = 0; c < 4; ++c)
+        // Drive this tile's transceivers and the tile itself
+        bool worked = td->AdvanceBatch(TileDriver::ADVANCES_PER_BATCH) > 0;
+        if (!worked)
+        {
+          if (++idleAdvances <= TileDriver::SPINS_BEFORE_PARK)
+          {
+            // We accomplished nothing.  Let somebody else try
+            pthread_yield();
+          }
+          else
+          {
+            // Still nothing.  Sleep until a neighbor ships us
+            // something, or the park times out
+            worked = td->Park(parkUsec);
+            if (!worked && parkUsec < TileDriver::MAX_PARK_USEC)
+              parkUsec *= 2;
+          }
+        }
+        if (worked)
         {
-	  if(td->m_channels[c].IsEnabled()) //esa
-	    td->m_channels[c].AdvanceToTime(now);
+          td->WakeNeighbors();
+          idleAdvances = 0;
+          parkUsec = TileDriver::MIN_PARK_USEC;
         }
+        td->m_gridPtr->AcknowledgeControl(*td);
+        break;
+      }
+
+      case TileDriver::PAUSED:
+        // Nothing to do until somebody changes our state
+        td->WaitWhilePaused();
+        break;
+
+      default:
+        FAIL(ILLEGAL_STATE);
+      }
+    }
+    MFM_LOG_DBG4(("Tile %s thread exiting", ctile.GetLabel()));
+    return NULL;
+  }
+
+  template <class GC>
+  typename Grid<GC>::TileDriver * Grid<GC>::StealTileDriver(TileWorker & thief)
+  {
+    const u32 workers = m_tileWorkerCount;
+    const u32 start = thief.m_random.Create(workers);
+    for (u32 i = 0; i < workers; ++i)
+    {
+      TileWorker & victim = m_tileWorkers[(start + i) % workers];
+      if (&victim == &thief) continue;
+      TileDriver * td = victim.PopBack();
+      if (td) return td;
+    }
+    return 0;
+  }
+
+  template <class GC>
+  void* Grid<GC>::TileWorkerRunner(void * arg)
+  {
+    TileWorker * tw = (TileWorker*) arg;
+    Grid & grid = *tw->m_gridPtr;
+
+    // Consecutive visits that accomplished nothing, and those of
+    // them that found the tile paused
+    u32 idleVisits = 0;
+    u32 pausedVisits = 0;
+    u32 parkUsec = TileDriver::MIN_PARK_USEC;
+    u32 seenWakeups = grid.GetTileWorkerWakeups();
+    while (true)
+    {
+      // Park once we've seen a whole grid's worth of idle visits in a
+      // row.  Any state change since seenWakeups cancels the park.
+      if (idleVisits >= grid.m_width * grid.m_height)
+      {
+        const bool allPaused = pausedVisits == idleVisits;
+        grid.ParkTileWorker(seenWakeups,
+                            allPaused ? (u32) MAX_PAUSED_PARK_USEC : parkUsec);
+        if (parkUsec < MAX_WORKER_PARK_USEC)
+          parkUsec *= 2;
+        idleVisits = pausedVisits = 0;
+        seenWakeups = grid.GetTileWorkerWakeups();
+      }
+
+      TileDriver * td = tw->PopFront();
+      if (!td)
+        td = grid.StealTileDriver(*tw);
+
+      if (!td)
+      {
+        // Nothing to run or steal.  If every tile has been retired,
+        // we're done; otherwise somebody else is holding them.
+        if (grid.GetLiveTileCount() == 0)
+          break;
+        ++idleVisits;
+        pthread_yield();
+        continue;
+      }
+
+      switch (td->GetState())
+      {
+      case TileDriver::EXIT_REQUEST:
+        grid.RetireTileDriver();  // Dropped from all deques for good
+        continue;
+
+      case TileDriver::ADVANCING:
+      {
+        // Errors in this tile unwind to this tile's stack
+        MFMPtrToErrEnvStackPtr = td->GetTile().GetErrorEnvironmentStackTop();
 
-        // Drive the tile itself
-        if (!ctile.Advance())
+        bool worked = td->AdvanceBatch(TileWorker::ADVANCES_PER_QUANTUM) > 0;
+        tw->PushBack(td);
+        grid.AcknowledgeControl(*td);
+        if (!worked)
         {
           // We accomplished nothing.  Let somebody else try
+          ++idleVisits;
           pthread_yield();
+          break;
         }
-        pauseUsec = 0;
+        td->WakeNeighbors();
+        idleVisits = pausedVisits = 0;
+        parkUsec = TileDriver::MIN_PARK_USEC;
+        seenWakeups = grid.GetTileWorkerWakeups();
         break;
       }
 
       case TileDriver::PAUSED:
-        // Sleep a little
-        if (pauseUsec < 100000)
-          pauseUsec += ctile.GetRandom().Between(10,100);
-        SleepUsec(pauseUsec);
+        tw->PushBack(td);
+        ++idleVisits;
+        ++pausedVisits;
         break;
 
       default:
         FAIL(ILLEGAL_STATE);
       }
     }
-    MFM_LOG_DBG4(("Tile %s thread exiting", ctile.GetLabel()));
+    MFM_LOG_DBG4(("TileWorker %p exiting", (void*) tw));
     return NULL;
   }
 
@@ -351,8 +543,25 @@ namespace MFM {
     }
 
     m_random.SetSeed(m_seed);
+    if (m_tileGenerator == Random::GENERATOR_PHILOX)
+    {
+      for (u32 y = 0; y < m_height; ++y)
+      {
+        for (u32 x = 0; x < m_width; ++x)
+        {
+          Random & random = _getTile(x, y).GetRandom();
+          random.SetGenerator(Random::GENERATOR_PHILOX);
+          random.SetStream(m_seed, y * m_width + x);
+        }
+      }
+      return;
+    }
+
     for (iterator_type i = begin(); i != end(); ++i)
+    {
+      i->GetRandom().SetGenerator(Random::GENERATOR_MT);
       i->GetRandom().SetSeed(m_random.Create());
+    }
   }
 
 
@@ -505,7 +714,7 @@ namespace MFM {
     }
 
     Tile<EC> & owner = GetTile(tileInGrid);
-    Site<AC> & site = owner.GetSite(siteInTile);
+    typename EC::SITE & site = owner.GetSite(siteInTile);
 
     //////// NOTE WE ARE RACING AGAINST THE TILE THREADS HERE!
     //
@@ -667,6 +876,26 @@ namespace MFM {
     }
   }
 
+  template <class GC>
+  void Grid<GC>::PlaceAtomInOwner(const T& atom, const SPoint& siteInGrid)
+  {
+    SPoint tileInGrid, siteInTile;
+    if (!MapGridToTile(siteInGrid, tileInGrid, siteInTile))
+    {
+      if(!IsGridLayoutStaggered())
+	{
+	  printf("Can't place at (%d,%d)\n", siteInGrid.GetX(), siteInGrid.GetY());
+	  FAIL(ILLEGAL_ARGUMENT);
+	}
+      return;
+    }
+
+    Tile<EC> & owner = GetTile(tileInGrid);
+    MFM_API_ASSERT_ARG(!owner.IsDummyTile());
+
+    owner.PlaceAtom(atom, siteInTile);
+  }
+
   template <class GC>
   void Grid<GC>::MaybeXRayAtom(const SPoint& siteInGrid)
   {
@@ -715,6 +944,23 @@ namespace MFM {
     }
   }
 
+  template <class GC>
+  void Grid<GC>::AcknowledgeControl(TileDriver & td)
+  {
+    TileDriverControl * tc = __atomic_load_n(&td.m_pendingControl, __ATOMIC_SEQ_CST);
+    if (!tc || !tc->CheckIfReady(td))
+      return;
+
+    // Whoever clears the pending control does the acknowledging
+    if (!__atomic_exchange_n(&td.m_pendingControl, (TileDriverControl *) 0, __ATOMIC_SEQ_CST))
+      return;
+
+    Mutex::ScopeLock lock(m_controlLock);
+    MFM_API_ASSERT_STATE(m_controlPendingCount > 0);
+    if (--m_controlPendingCount == 0)
+      m_controlDone.Broadcast();
+  }
+
   template <class GC>
   void Grid<GC>::DoTileDriverControl(TileDriverControl & tc)
   {
@@ -741,7 +987,12 @@ namespace MFM {
       }
     }
 
-    // Issue request to all
+    {
+      Mutex::ScopeLock lock(m_controlLock);
+      m_controlPendingCount = m_width * m_height;
+    }
+
+    // Issue request to all, and unpark them to see it
     for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
     {
       SPoint i = IteratorIndexToCoord(m_rgi.Next());
@@ -752,37 +1003,20 @@ namespace MFM {
       TileDriver & td = _getTileDriver(x,y);
       MFM_API_ASSERT_STATE(!td.GetTile().IsDummyTile());
       tc.MakeRequest(td);
+      __atomic_store_n(&td.m_pendingControl, &tc, __ATOMIC_SEQ_CST);
+      td.Wake();
     }
+    WakeTileWorkers(true);
 
-    // Wait until all acknowledge
+    // Wait until all acknowledge.  Tiles that are ready but not
+    // advancing (such as paused ones) are acknowledged here, as are
+    // any whose acknowledgement we may have slept through.
+    const u64 REPORT_NANOS = ((u64) CONTROL_REPORT_SECONDS) * 1000000000;
+    u64 startNanos = GetMonotonicNanos();
     u32 loops = 0;
     u32 notReady = 0;
-    s32 sleepTimer = 100000000; // XXX m_random.Between(1000,10000);
-    do
+    while (true)
     {
-      if (++loops >= 1000000)
-      {
-        LOG.Error("%s control looped %d times, but %d still not ready, killing",
-                  tc.GetName(), loops, notReady);
-        ReportGridStatus(Logger::ERROR);
-        LOG.Error("%s control: Sleeping", tc.GetName());
-        SleepUsec(60*1000000);  // 1 minute
-        LOG.Error("%s control: Resetting", tc.GetName());
-        loops = 0;
-      }
-
-      if (--sleepTimer < 0)
-      {
-        SleepUsec(m_random.Between(10,1000));  // 0.01ms..1ms
-        sleepTimer = m_random.Create(10000);
-      }
-      else
-      {
-        pthread_yield();
-      }
-
-      notReady = 0;
-
       for (m_rgi.ShuffleOrReset(m_random); m_rgi.HasNext(); )
       {
         SPoint i = IteratorIndexToCoord(m_rgi.Next());
@@ -793,18 +1027,38 @@ namespace MFM {
         TileDriver & td = _getTileDriver(x,y);
 	MFM_API_ASSERT_STATE(!td.GetTile().IsDummyTile());
 
-        if (!tc.CheckIfReady(td))
+        AcknowledgeControl(td);
+      }
+
+      {
+        Mutex::ScopeLock lock(m_controlLock);
+        if (m_controlPendingCount > 0)
         {
-          ++notReady;
-          pthread_yield();
+          m_controlDone.WaitUsec(CONTROL_WAIT_USEC);
         }
+        notReady = m_controlPendingCount;
       }
 
-    } while (notReady > 0);
+      if (notReady == 0)
+        break;
+
+      ++loops;
+      if (GetMonotonicNanos() - startNanos >= REPORT_NANOS)
+      {
+        LOG.Error("%s control waited %d times, but %d still not ready, killing",
+                  tc.GetName(), loops, notReady);
+        ReportGridStatus(Logger::ERROR);
+        LOG.Error("%s control: Sleeping", tc.GetName());
+        SleepUsec(60*1000000);  // 1 minute
+        LOG.Error("%s control: Resetting", tc.GetName());
+        startNanos = GetMonotonicNanos();
+        loops = 0;
+      }
+    }
 
-    if (loops > 5000)
+    if (loops > 100)
     {
-      LOG.Debug("%s control looped %d times",
+      LOG.Debug("%s control waited %d times",
                 tc.GetName(), loops);
     }
 
@@ -832,6 +1086,27 @@ namespace MFM {
             m_lastEventTile.GetY());
   }
 
+  template <class GC>
+  void Grid<GC>::NotifyHistorySinks(bool resuming)
+  {
+    for (iterator_type i = begin(); i != end(); ++i)
+    {
+      EventHistorySink * sink = i->GetEventHistoryBuffer().GetSink();
+      if (!sink)
+      {
+        continue;
+      }
+      if (resuming)
+      {
+        sink->Resuming();
+      }
+      else
+      {
+        sink->Paused();
+      }
+    }
+  }
+
   template <class GC>
   u64 Grid<GC>::GetTotalEventsExecuted() const
   {
@@ -922,6 +1197,56 @@ namespace MFM {
     }
   }
 
+  template <class GC>
+  void Grid<GC>::WriteCacheStallImage(ByteSink & outstrm) const
+  {
+    const u32 CELL_PIXELS = 8;
+    const u32 TILE_PIXELS = 3 * CELL_PIXELS;
+
+    // Stalls shown in each cell of each tile, in tile order
+    const u32 tiles = GetWidth() * GetHeight();
+    u64 * cells = new u64[tiles * 9];
+    u64 max = 1; //avoid division by zero
+    for (u32 ty = 0; ty < GetHeight(); ++ty)
+    {
+      for (u32 tx = 0; tx < GetWidth(); ++tx)
+      {
+        u64 * tcells = &cells[(ty * GetWidth() + tx) * 9];
+        for (u32 c = 0; c < 9; ++c)
+        {
+          tcells[c] = 0;
+        }
+        const CacheProfile * profile = GetTile(tx, ty).GetCacheProfile();
+        if (!profile)
+        {
+          continue;
+        }
+        for (Dir d = 0; d < Dirs::DIR_COUNT; ++d)
+        {
+          SPoint offset;
+          Dirs::FillDir(offset, d, false);  // (+-2, +-2), per axis
+          u32 c = (offset.GetY() / 2 + 1) * 3 + (offset.GetX() / 2 + 1);
+          tcells[c] = profile->GetBoundary(d).GetTotalStalls();
+          max = MAX(max, tcells[c]);
+        }
+        tcells[4] = profile->GetTotalStalls() / Dirs::DIR_COUNT;
+      }
+    }
+
+    outstrm.Printf("P5\n # Max boundary stalls = %d\n%d %d 255\n",
+                   (u32) max, GetWidth() * TILE_PIXELS, GetHeight() * TILE_PIXELS);
+    for (u32 y = 0; y < GetHeight() * TILE_PIXELS; ++y)
+    {
+      for (u32 x = 0; x < GetWidth() * TILE_PIXELS; ++x)
+      {
+        u32 tile = (y / TILE_PIXELS) * GetWidth() + x / TILE_PIXELS;
+        u32 c = ((y % TILE_PIXELS) / CELL_PIXELS) * 3 + (x % TILE_PIXELS) / CELL_PIXELS;
+        outstrm.WriteByte((u8) (cells[tile * 9 + c] * 255 / max));
+      }
+    }
+    delete [] cells;
+  }
+
   template <class GC>
   u32 Grid<GC>::GetAtomCount(ElementType atomType) const
   {
@@ -932,6 +1257,87 @@ namespace MFM {
     return total;
   }
 
+  template <class GC>
+  bool Grid<GC>::HasTileSnapshots() const
+  {
+    for (const_iterator_type i = begin(); i != end(); ++i)
+    {
+      if (!i->GetSnapshots().HasPublished())
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool Grid<GC>::CountSnapshotAtoms(const ElementType * types, u32 typeCount, u32 * counts) const
+  {
+    for (u32 t = 0; t < typeCount; ++t)
+    {
+      counts[t] = 0;
+    }
+
+    for (const_iterator_type i = begin(); i != end(); ++i)
+    {
+      typename TileSnapshots<T>::Reader snapshot(i->GetSnapshots());
+      if (!snapshot.IsValid())
+      {
+        return false;
+      }
+
+      for (u32 y = 0; y < OWNED_HEIGHT; ++y)
+      {
+        for (u32 x = 0; x < OWNED_WIDTH; ++x)
+        {
+          const u32 type = snapshot.GetAtom(x, y).GetType();
+          for (u32 t = 0; t < typeCount; ++t)
+          {
+            if (types[t] == type)
+            {
+              ++counts[t];
+              break;
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool Grid<GC>::GetSnapshotAtom(const SPoint & siteInGrid, T & atom) const
+  {
+    SPoint tileInGrid, siteInTile;
+    if (!MapGridToUncachedTile(siteInGrid, tileInGrid, siteInTile))
+    {
+      return false;
+    }
+
+    typename TileSnapshots<T>::Reader snapshot(GetTile(tileInGrid).GetSnapshots());
+    if (!snapshot.IsValid())
+    {
+      return false;
+    }
+    atom = snapshot.GetAtom(siteInTile.GetX(), siteInTile.GetY());
+    return true;
+  }
+
+  template <class GC>
+  bool Grid<GC>::VerifyAtomCounts() const
+  {
+    bool ok = true;
+    for (const_iterator_type i = begin(); i != end(); ++i)
+    {
+      if (!i->VerifyAtomCounts())
+      {
+        LOG.Warning("Atom counts were wrong in tile %s", i->GetLabel());
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
   template <class GC>
   s32 Grid<GC>::GetAtomCountFromSymbol(const u8 * symbol) const
   {
@@ -996,21 +1402,117 @@ namespace MFM {
   } //CheckCaches
 
   template <class GC>
-  void Grid<GC>::RefreshAllCaches()
+  void Grid<GC>::RefreshAllCaches(u32 threads)
   {
-    const u32 gridWidth = this->GetWidthSites(); //includes dummy tiles in scattered grid
-    const u32 gridHeight = this->GetHeightSites();
+    enum { MAX_REFRESH_THREADS = 64 };
+    const u32 tiles = m_width * m_height;
+    if (threads == 0)
+    {
+      threads = Utils::GetOnlineProcessorCount();
+    }
+    threads = MIN(threads, MIN(tiles, (u32) MAX_REFRESH_THREADS));
 
-    for(u32 y = 0; y < gridHeight; y++)
+    m_nextRefreshTile = 0;
+
+    // The calling thread refreshes too
+    pthread_t ids[MAX_REFRESH_THREADS];
+    u32 started = 0;
+    for (u32 i = 1; i < threads; ++i)
     {
-      for(u32 x = 0; x < gridWidth; x++)
+      if (pthread_create(&ids[started], NULL, RefreshCachesRunner, this))
       {
-        SPoint siteInGrid(x, y);
-	if(this->IsGridCoord(siteInGrid))
-	  {
-	    T atom = *this->GetAtom(siteInGrid);
-	    this->PlaceAtom(atom, siteInGrid);  // This updates caches
-	  }
+        break;  // Fewer threads will do
+      }
+      ++started;
+    }
+
+    RefreshCachesOfClaimedTiles();
+
+    for (u32 i = 0; i < started; ++i)
+    {
+      pthread_join(ids[i], NULL);
+    }
+
+    // RefreshCachesFrom writes cache sites directly
+    for (iterator_type i = begin(); i != end(); ++i)
+    {
+      i->NoteAllSitesChanged();
+    }
+  }
+
+  template <class GC>
+  void * Grid<GC>::RefreshCachesRunner(void * arg)
+  {
+    ((Grid<GC> *) arg)->RefreshCachesOfClaimedTiles();
+    return NULL;
+  }
+
+  template <class GC>
+  void Grid<GC>::RefreshCachesOfClaimedTiles()
+  {
+    const u32 tiles = m_width * m_height;
+    for (u32 t = __atomic_fetch_add(&m_nextRefreshTile, 1, __ATOMIC_RELAXED);
+         t < tiles;
+         t = __atomic_fetch_add(&m_nextRefreshTile, 1, __ATOMIC_RELAXED))
+    {
+      RefreshCachesFrom(SPoint(t / m_height, t % m_height));
+    }
+  }
+
+  template <class GC>
+  void Grid<GC>::RefreshCachesFrom(const SPoint & tileInGrid)
+  {
+    const Tile<EC> & owner = GetTile(tileInGrid);
+    if (owner.IsDummyTile())
+    {
+      return;
+    }
+
+    const bool isStaggered = IsGridLayoutStaggered();
+    const SPoint ownedph(OWNED_WIDTH/2, OWNED_HEIGHT/2);
+
+    // Only owned sites within 2R of an edge are shared
+    for (u32 y = R; y < TILE_HEIGHT - R; ++y)
+    {
+      const bool midRow = y >= 3 * R && y < TILE_HEIGHT - 3 * R;
+      for (u32 x = R; x < TILE_WIDTH - R; ++x)
+      {
+        if (midRow && x == 3 * R && x < TILE_WIDTH - 3 * R)
+        {
+          x = TILE_WIDTH - 3 * R;  // Skip the rest of the hidden region
+        }
+
+        const SPoint siteInTile(x, y);
+        THREEDIR connectedDirs;
+        u32 dircount = owner.SharedAt(siteInTile, connectedDirs, YESCHKCONNECT);
+        if (dircount == 0)
+        {
+          continue;
+        }
+
+        const T & atom = *owner.GetAtom(siteInTile);
+        for (u32 d = 0; d < dircount; d++)
+        {
+          // As in PlaceAtomInSite
+          Dir dir = connectedDirs[d];
+          SPoint tileOffset;
+          Dirs::ToNeighborTileInGrid(tileOffset, dir, isStaggered, tileInGrid);
+
+          SPoint otherTileIndex = tileInGrid + tileOffset;
+          MFM_API_ASSERT_ARG(IsLegalTileIndex(otherTileIndex));
+
+          Tile<EC> & other = GetTile(otherTileIndex);
+          if (other.IsDummyTile()) continue;  // edge of grid
+
+          SPoint siteOffset;
+          Dirs::FillDir(siteOffset, dir, isStaggered);
+          SPoint otherIndex = siteInTile - siteOffset * ownedph;
+
+          if (other.IsLiveSite(otherIndex))
+          {
+            other.GetSite(otherIndex).GetAtom() = atom;  // Cache sites need no change counting
+          }
+        }
       }
     }
   }
@@ -0,0 +1,131 @@
+/*                                              -*- mode:C++ -*-
+  GridRasterizer.h Offscreen atom-color images of a Grid
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file GridRasterizer.h Offscreen atom-color images of a Grid
+  \lgpl
+ */
+#ifndef GRIDRASTERIZER_H
+#define GRIDRASTERIZER_H
+
+#include <pthread.h>
+#include "itype.h"
+#include "Fail.h"
+#include "ByteSink.h"
+#include "PNGEncoder.h"
+#include "Grid.h"
+
+namespace MFM
+{
+  /**
+   * A GridRasterizer draws each owned site of a Grid as one pixel of
+   * its atom's color, into a buffer in memory, without SDL or a
+   * display, and writes the result as a PNG or a binary PPM frame.
+   * Colors come from Element::GetDynamicColor, so Ulam elements are
+   * drawn by their getColor methods, as the GUI draws them.
+   *
+   * Tiles are rasterized in parallel, by up to MAX_THREADS threads
+   * claiming whole tiles.  A tile that has published a snapshot (see
+   * Grid::SetTileSnapshotInterval) is drawn from its latest one, so
+   * Render may run alongside the Grid once every tile has published;
+   * otherwise, Render only while the Grid is paused.
+   */
+  template <class GC>
+  class GridRasterizer
+  {
+    typedef typename GC::EVENT_CONFIG EC;
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+
+  public:
+    enum
+    {
+      MAX_THREADS = 64,
+      EMPTY_COLOR = 0xff000000,    //< Black, as the GUI draws no atom
+      BAD_ATOM_COLOR = 0xffff00ff  //< Magenta, for insane or unknown atoms
+    };
+
+    GridRasterizer(const Grid<GC> & grid) ;
+
+    ~GridRasterizer()
+    {
+      delete [] m_pixels;
+    }
+
+    /**
+       Rasterize every tile using up to \c threads threads (0: one per
+       online processor), coloring atoms with \c selector as in
+       Element::GetAtomColor (0 gives each element's static color).
+     */
+    void Render(u32 selector, u32 threads) ;
+
+    u32 GetWidth() const
+    {
+      return m_width;
+    }
+
+    u32 GetHeight() const
+    {
+      return m_height;
+    }
+
+    /**
+       The ARGB pixel at (\c x, \c y) as of the last Render
+     */
+    u32 GetPixel(u32 x, u32 y) const
+    {
+      MFM_API_ASSERT_ARG(x < m_width && y < m_height);
+      return m_pixels[y * m_width + x];
+    }
+
+    void WritePNG(ByteSink & sink) const
+    {
+      PNGEncoder::WriteRGB(sink, m_pixels, m_width, m_height);
+    }
+
+    /**
+       Write the image as a binary (P6) PPM.  Concatenated frames form
+       a stream that video encoders accept as-is, e.g., via \c ffmpeg
+       \c -f \c image2pipe \c -i \c frames.ppm.
+     */
+    void WritePPM(ByteSink & sink) const ;
+
+  private:
+    const Grid<GC> & m_grid;
+    const u32 m_width;
+    const u32 m_height;
+    u32 * const m_pixels;
+
+    u32 m_selector;     //< For the Render in progress
+    u32 m_nextTile;     //< Next tile to claim; __atomic access
+
+    static void * RenderRunner(void * arg) ;
+
+    void RenderTiles() ;
+
+    void RenderTile(u32 tx, u32 ty) ;
+
+    u32 GetAtomPixel(const Tile<EC> & tile, const T & atom) const ;
+  };
+} /* namespace MFM */
+
+#include "GridRasterizer.tcc"
+
+#endif /* GRIDRASTERIZER_H */
@@ -0,0 +1,159 @@
+/* -*- C++ -*- */
+#include "Utils.h"
+
+namespace MFM
+{
+  template <class GC>
+  GridRasterizer<GC>::GridRasterizer(const Grid<GC> & grid)
+    : m_grid(grid)
+    , m_width(grid.GetWidthSites())
+    , m_height(grid.GetHeightSites())
+    , m_pixels(new u32[m_width * m_height])
+    , m_selector(0)
+    , m_nextTile(0)
+  {
+    for (u32 i = 0; i < m_width * m_height; ++i)
+    {
+      m_pixels[i] = EMPTY_COLOR;
+    }
+  }
+
+  template <class GC>
+  void GridRasterizer<GC>::Render(u32 selector, u32 threads)
+  {
+    const u32 tiles = m_grid.GetWidth() * m_grid.GetHeight();
+    if (threads == 0)
+    {
+      threads = Utils::GetOnlineProcessorCount();
+    }
+    threads = MIN(threads, MIN(tiles, (u32) MAX_THREADS));
+
+    m_selector = selector;
+    m_nextTile = 0;
+
+    // The calling thread renders too
+    pthread_t ids[MAX_THREADS];
+    u32 started = 0;
+    for (u32 i = 1; i < threads; ++i)
+    {
+      if (pthread_create(&ids[started], NULL, RenderRunner, this))
+      {
+        break;  // Fewer threads will do
+      }
+      ++started;
+    }
+
+    RenderTiles();
+
+    for (u32 i = 0; i < started; ++i)
+    {
+      pthread_join(ids[i], NULL);
+    }
+  }
+
+  template <class GC>
+  void * GridRasterizer<GC>::RenderRunner(void * arg)
+  {
+    ((GridRasterizer<GC> *) arg)->RenderTiles();
+    return NULL;
+  }
+
+  template <class GC>
+  void GridRasterizer<GC>::RenderTiles()
+  {
+    const u32 gridWidth = m_grid.GetWidth();
+    const u32 tiles = gridWidth * m_grid.GetHeight();
+    for (u32 t = __atomic_fetch_add(&m_nextTile, 1, __ATOMIC_RELAXED);
+         t < tiles;
+         t = __atomic_fetch_add(&m_nextTile, 1, __ATOMIC_RELAXED))
+    {
+      RenderTile(t % gridWidth, t / gridWidth);
+    }
+  }
+
+  template <class GC>
+  void GridRasterizer<GC>::RenderTile(u32 tx, u32 ty)
+  {
+    const Tile<EC> & tile = m_grid.GetTile(tx, ty);
+    if (tile.IsDummyTile())
+    {
+      return;
+    }
+
+    const u32 ow = Grid<GC>::OWNED_WIDTH;
+    const u32 oh = Grid<GC>::OWNED_HEIGHT;
+
+    // Inverting Grid::MapGridToUncachedTile
+    SPoint tileOrigin(tx * ow, ty * oh);
+    if (m_grid.IsGridRowStaggered(tileOrigin))
+    {
+      tileOrigin.SetX(tileOrigin.GetX() + ow / 2);
+    }
+
+    typename TileSnapshots<T>::Reader snapshot(tile.GetSnapshots());
+    for (u32 y = 0; y < oh; ++y)
+    {
+      u32 * row = &m_pixels[(tileOrigin.GetY() + y) * m_width + tileOrigin.GetX()];
+      if (snapshot.IsValid())
+      {
+        for (u32 x = 0; x < ow; ++x)
+        {
+          row[x] = GetAtomPixel(tile, snapshot.GetAtom(x, y));
+        }
+        continue;
+      }
+
+      for (u32 x = 0; x < ow; ++x)
+      {
+        const T * atom = tile.GetUncachedAtom(x, y);
+        row[x] = atom ? GetAtomPixel(tile, *atom) : (u32) BAD_ATOM_COLOR;
+      }
+    }
+  }
+
+  template <class GC>
+  u32 GridRasterizer<GC>::GetAtomPixel(const Tile<EC> & tile, const T & atom) const
+  {
+    if (!atom.IsSane())
+    {
+      return BAD_ATOM_COLOR;
+    }
+
+    u32 type = atom.GetType();
+    if (type == T::ATOM_EMPTY_TYPE)
+    {
+      return EMPTY_COLOR;
+    }
+
+    const Element<EC> * elt = tile.GetElementTable().Lookup(type);
+    if (!elt)
+    {
+      return BAD_ATOM_COLOR;
+    }
+
+    if (m_selector == 0)
+    {
+      return elt->GetStaticColor();
+    }
+    return elt->GetDynamicColor(tile.GetElementTable(), tile.GetUlamClassRegistry(), atom, m_selector);
+  }
+
+  template <class GC>
+  void GridRasterizer<GC>::WritePPM(ByteSink & sink) const
+  {
+    sink.Printf("P6\n%d %d\n255\n", m_width, m_height);
+    u8 * row = new u8[3 * m_width];
+    for (u32 y = 0; y < m_height; ++y)
+    {
+      const u32 * pixels = &m_pixels[y * m_width];
+      for (u32 x = 0; x < m_width; ++x)
+      {
+        row[3 * x + 0] = (u8) (pixels[x] >> 16);
+        row[3 * x + 1] = (u8) (pixels[x] >> 8);
+        row[3 * x + 2] = (u8) pixels[x];
+      }
+      sink.WriteBytes(row, 3 * m_width);
+    }
+    delete [] row;
+  }
+} /* namespace MFM */
@@ -0,0 +1,225 @@
+/*                                              -*- mode:C++ -*-
+  GridSnapshot.h Binary save and restore of a whole grid
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file GridSnapshot.h Binary save and restore of a whole grid
+  \lgpl
+ */
+#ifndef GRIDSNAPSHOT_H
+#define GRIDSNAPSHOT_H
+
+#include <stdio.h>
+#include "itype.h"
+#include "ByteSource.h"
+#include "ExternalConfig.h"
+#include "ExternalConfigSectionGrid.h"
+
+namespace MFM
+{
+  /**
+   * A GridSnapshot writes and reads a whole grid as a binary .mfs
+   * file.  It holds the same information as the text format written
+   * by ExternalConfig, but the per-site data -- which is nearly all
+   * of a text save -- is stored as raw arrays rather than as
+   * Printf'd Site(..) lines.
+   *
+   * A snapshot file is:
+   *
+   *  - A header: SNAPSHOT_MAGIC, a byte order mark, the
+   *    SNAPSHOT_VERSION, flags, the atom size, the owned tile size,
+   *    the event window radius, and the grid size in tiles.  All
+   *    integers are in the byte order of the writing machine.
+   *
+   *  - The ExternalConfig text, written with
+   *    ExternalConfigSectionGrid::SetWriteSites(false).  This carries
+   *    the driver section, the element registrations and parameters,
+   *    and each Tile's metadata, and is read back by ExternalConfig.
+   *
+   *  - An element table mapping each saved atom type to its UUID,
+   *    resolved on load like RegisterElement, via
+   *    ElementRegistry::Lookup then LookupCompatible.
+   *
+   *  - For each tile, its position and then the owned sites of the
+   *    tile as one array per Plane.  With SNAPSHOT_FLAG_RUN_LENGTH,
+   *    each array is a sequence of (u32 count, record) runs, which
+   *    collapses the large uniform regions (empty space, untouched
+   *    sensors and paint) that dominate most grids.
+   */
+  template <class GC>
+  class GridSnapshot
+  {
+    typedef typename GC::EVENT_CONFIG EC;
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+    typedef typename EC::SITE S;
+    typedef BitVector<AC::BITS_PER_ATOM> BV;
+
+    enum
+    {
+      ATOM_WORDS = BV::ARRAY_LENGTH,
+      ATOM_BYTES = ATOM_WORDS * sizeof(u32),
+      SENSORS_BYTES = sizeof(u32) + sizeof(u64),
+      COUNTERS_BYTES = 3 * sizeof(u64) + 1,
+      MAX_RECORD_BYTES = ATOM_BYTES > COUNTERS_BYTES ? ATOM_BYTES : COUNTERS_BYTES
+    };
+
+  public:
+    // SNAPSHOT_VERSION = 1 Original version
+    enum { SNAPSHOT_VERSION = 1 };
+
+    enum { BYTE_ORDER_MARK = 0x01020304 };
+
+    enum { MAX_SNAPSHOT_TYPES = 256 };
+
+    enum { MAX_UUID_BYTES = 256 };
+
+    enum Flags
+    {
+      SNAPSHOT_FLAG_RUN_LENGTH = 0x1  //< Plane arrays are run-length encoded
+    };
+
+    /**
+     * The per-site arrays stored for each tile, in file order.
+     */
+    enum Plane
+    {
+      PLANE_ATOM,      //< Site atom bits (ATOM_WORDS u32s)
+      PLANE_BASE,      //< Base atom bits (ATOM_WORDS u32s)
+      PLANE_PAINT,     //< Base paint (u32)
+      PLANE_SENSORS,   //< Touch type (u32) and last touch (u64)
+      PLANE_COUNTERS,  //< SiteCounters (3 u64s and a u8 live flag)
+      PLANE_COUNT
+    };
+
+    static const char SNAPSHOT_MAGIC[8];
+
+    GridSnapshot(ExternalConfig<GC> & config, ExternalConfigSectionGrid<GC> & section, Grid<GC> & grid) ;
+
+    void SetRunLengthEncoding(bool value)
+    {
+      m_runLengthEncoding = value;
+    }
+
+    bool IsRunLengthEncoding() const
+    {
+      return m_runLengthEncoding;
+    }
+
+    /**
+     * Is \c path a readable file that starts with SNAPSHOT_MAGIC?
+     */
+    static bool IsSnapshotFile(const char * path) ;
+
+    /**
+     * Write the grid and the rest of the external configuration to \c
+     * path.  Returns false, after logging an error, if \c path could
+     * not be opened; FAILs with IO_ERROR if writing fails after that.
+     */
+    bool Write(const char * path) ;
+
+    /**
+     * Read a snapshot written by Write from \c path.  Returns false,
+     * after logging an error, if the file is unreadable, malformed,
+     * or was written for a different atom or grid geometry, in which
+     * case the grid may be partially loaded.
+     */
+    bool Read(const char * path) ;
+
+  private:
+    ExternalConfig<GC> & m_config;
+    ExternalConfigSectionGrid<GC> & m_section;
+    Grid<GC> & m_grid;
+    bool m_runLengthEncoding;
+
+    struct TypeMapping
+    {
+      u32 m_savedType;
+      const Element<EC> * m_element;  //< 0 if unknown here
+    };
+    TypeMapping m_typeMappings[MAX_SNAPSHOT_TYPES];
+    u32 m_typeMappingCount;
+    u32 m_lastTypeMapping;
+    u32 m_unmappedAtoms;
+
+    /**
+     * A ByteSource for the configuration text embedded in a snapshot,
+     * which reads no further than its end.
+     */
+    class FileRangeByteSource : public ByteSource
+    {
+      FILE * m_fp;
+      u32 m_remaining;
+    public:
+      FileRangeByteSource(FILE * fp, u32 length)
+        : m_fp(fp)
+        , m_remaining(length)
+      { }
+
+      virtual s32 ReadByte()
+      {
+        if (m_remaining == 0) return -1;
+        --m_remaining;
+        return fgetc(m_fp);
+      }
+    };
+
+    static u32 GetRecordBytes(u32 plane) ;
+
+    static void PackRecord(u32 plane, const S & site, u8 * record) ;
+
+    void UnpackRecord(u32 plane, const u8 * record, S & site) ;
+
+    void UnpackAtom(const u8 * record, T & atom) ;
+
+    const TypeMapping * FindTypeMapping(u32 savedType) ;
+
+    void WritePlane(FILE * fp, const Tile<EC> & tile, u32 plane) ;
+
+    bool ReadPlane(FILE * fp, Tile<EC> & tile, u32 plane, bool runLengthEncoded) ;
+
+    bool ReadTypeMappings(FILE * fp) ;
+
+    void WriteTypeMappings(FILE * fp) ;
+
+    bool ReadFile(FILE * fp, const char * path) ;
+
+    static void WriteBytes(FILE * fp, const void * data, u32 length) ;
+
+    static void WriteU32(FILE * fp, u32 value)
+    {
+      WriteBytes(fp, &value, sizeof(value));
+    }
+
+    static bool ReadBytes(FILE * fp, void * data, u32 length)
+    {
+      return fread(data, 1, length, fp) == length;
+    }
+
+    static bool ReadU32(FILE * fp, u32 & value)
+    {
+      return ReadBytes(fp, &value, sizeof(value));
+    }
+
+  };
+}
+
+#include "GridSnapshot.tcc"
+
+#endif /* GRIDSNAPSHOT_H */
@@ -0,0 +1,561 @@
+/* -*- C++ -*- */
+#include "FileByteSink.h"
+#include "CharBufferByteSource.h"
+#include "Logger.h"
+#include <string.h>  /* For memcpy, memcmp */
+
+namespace MFM
+{
+  template <class GC>
+  const char GridSnapshot<GC>::SNAPSHOT_MAGIC[8] = { 'M', 'F', 'S', 'B', 'I', 'N', '\r', '\n' };
+
+  template <class GC>
+  GridSnapshot<GC>::GridSnapshot(ExternalConfig<GC> & config, ExternalConfigSectionGrid<GC> & section, Grid<GC> & grid)
+    : m_config(config)
+    , m_section(section)
+    , m_grid(grid)
+    , m_runLengthEncoding(true)
+    , m_typeMappingCount(0)
+    , m_lastTypeMapping(0)
+    , m_unmappedAtoms(0)
+  { }
+
+  template <class GC>
+  bool GridSnapshot<GC>::IsSnapshotFile(const char * path)
+  {
+    FILE * fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    bool ret = ReadBytes(fp, magic, sizeof(magic)) &&
+      !memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic));
+    fclose(fp);
+    return ret;
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::WriteBytes(FILE * fp, const void * data, u32 length)
+  {
+    if (fwrite(data, 1, length, fp) != length)
+    {
+      FAIL(IO_ERROR);
+    }
+  }
+
+  template <class GC>
+  u32 GridSnapshot<GC>::GetRecordBytes(u32 plane)
+  {
+    switch (plane)
+    {
+    case PLANE_ATOM:     return ATOM_BYTES;
+    case PLANE_BASE:     return ATOM_BYTES;
+    case PLANE_PAINT:    return sizeof(u32);
+    case PLANE_SENSORS:  return SENSORS_BYTES;
+    case PLANE_COUNTERS: return COUNTERS_BYTES;
+    default: FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::PackRecord(u32 plane, const S & site, u8 * record)
+  {
+    switch (plane)
+    {
+    case PLANE_ATOM:
+    case PLANE_BASE:
+    {
+      const T & atom = (plane == PLANE_ATOM) ? site.GetAtom() : site.GetBase().GetBaseAtom();
+      u32 words[ATOM_WORDS];
+      Element<EC>::GetBits(atom).ToArray(words);
+      memcpy(record, words, ATOM_BYTES);
+      break;
+    }
+    case PLANE_PAINT:
+    {
+      u32 paint = site.GetBase().GetPaint();
+      memcpy(record, &paint, sizeof(paint));
+      break;
+    }
+    case PLANE_SENSORS:
+    {
+      const SiteTouchSensor & sts = site.GetBase().GetSensory().m_touchSensor;
+      u32 touchType = sts.m_touchType;
+      memcpy(&record[0], &touchType, sizeof(touchType));
+      memcpy(&record[4], &sts.m_lastTouchEventCount, sizeof(u64));
+      break;
+    }
+    case PLANE_COUNTERS:
+    {
+      const SiteCounters & sc = site.GetCounters();
+      memcpy(&record[0], &sc.m_eventCount, sizeof(u64));
+      memcpy(&record[8], &sc.m_lastChangedEventCount, sizeof(u64));
+      memcpy(&record[16], &sc.m_lastEventNumber, sizeof(u64));
+      record[24] = sc.m_isLiveSite ? 1 : 0;
+      break;
+    }
+    default:
+      FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+  template <class GC>
+  const typename GridSnapshot<GC>::TypeMapping * GridSnapshot<GC>::FindTypeMapping(u32 savedType)
+  {
+    // Atom types come in runs, so check the last hit first
+    if (m_lastTypeMapping < m_typeMappingCount &&
+        m_typeMappings[m_lastTypeMapping].m_savedType == savedType)
+    {
+      return &m_typeMappings[m_lastTypeMapping];
+    }
+
+    for (u32 i = 0; i < m_typeMappingCount; ++i)
+    {
+      if (m_typeMappings[i].m_savedType == savedType)
+      {
+        m_lastTypeMapping = i;
+        return &m_typeMappings[i];
+      }
+    }
+    return 0;
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::UnpackAtom(const u8 * record, T & atom)
+  {
+    u32 words[ATOM_WORDS];
+    memcpy(words, record, ATOM_BYTES);
+
+    T saved;
+    Element<EC>::GetBits(saved).FromArray(words);
+
+    const TypeMapping * tm = FindTypeMapping(saved.GetType());
+    if (!tm || !tm->m_element)
+    {
+      ++m_unmappedAtoms;
+      atom.SetEmpty();
+      return;
+    }
+
+    if (tm->m_element->GetType() == tm->m_savedType)
+    {
+      atom = saved;
+      return;
+    }
+
+    // Type number changed since the save: same merge as LoadSiteConfig
+    atom = tm->m_element->GetDefaultAtom();
+    for (u32 i = T::ATOM_FIRST_STATE_BIT; i < T::BPA; ++i)
+    {
+      atom.GetBits().StoreBit(i, saved.GetBits().ReadBit(i));
+    }
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::UnpackRecord(u32 plane, const u8 * record, S & site)
+  {
+    switch (plane)
+    {
+    case PLANE_ATOM:
+      UnpackAtom(record, site.GetAtom());
+      break;
+    case PLANE_BASE:
+      UnpackAtom(record, site.GetBase().GetBaseAtom());
+      break;
+    case PLANE_PAINT:
+    {
+      u32 paint;
+      memcpy(&paint, record, sizeof(paint));
+      site.GetBase().SetPaint(paint);
+      break;
+    }
+    case PLANE_SENSORS:
+    {
+      SiteTouchSensor & sts = site.GetBase().GetSensory().m_touchSensor;
+      u32 touchType;
+      memcpy(&touchType, &record[0], sizeof(touchType));
+      sts.m_touchType = (SiteTouchType) touchType;
+      memcpy(&sts.m_lastTouchEventCount, &record[4], sizeof(u64));
+      break;
+    }
+    case PLANE_COUNTERS:
+    {
+      SiteCounters & sc = site.GetCounters();
+      memcpy(&sc.m_eventCount, &record[0], sizeof(u64));
+      memcpy(&sc.m_lastChangedEventCount, &record[8], sizeof(u64));
+      memcpy(&sc.m_lastEventNumber, &record[16], sizeof(u64));
+      sc.m_isLiveSite = record[24] != 0;
+      break;
+    }
+    default:
+      FAIL(ILLEGAL_ARGUMENT);
+    }
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::WritePlane(FILE * fp, const Tile<EC> & tile, u32 plane)
+  {
+    const u32 bytes = GetRecordBytes(plane);
+    u8 record[MAX_RECORD_BYTES];
+    u8 runRecord[MAX_RECORD_BYTES];
+    u32 runLength = 0;
+
+    for (u32 y = 0; y < tile.OWNED_HEIGHT; ++y)
+    {
+      for (u32 x = 0; x < tile.OWNED_WIDTH; ++x)
+      {
+        PackRecord(plane, tile.GetUncachedSite(SPoint(x, y)), record);
+
+        if (!m_runLengthEncoding)
+        {
+          WriteBytes(fp, record, bytes);
+          continue;
+        }
+
+        if (runLength > 0 && !memcmp(record, runRecord, bytes))
+        {
+          ++runLength;
+          continue;
+        }
+
+        if (runLength > 0)
+        {
+          WriteU32(fp, runLength);
+          WriteBytes(fp, runRecord, bytes);
+        }
+        memcpy(runRecord, record, bytes);
+        runLength = 1;
+      }
+    }
+
+    if (runLength > 0)
+    {
+      WriteU32(fp, runLength);
+      WriteBytes(fp, runRecord, bytes);
+    }
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::ReadPlane(FILE * fp, Tile<EC> & tile, u32 plane, bool runLengthEncoded)
+  {
+    const u32 bytes = GetRecordBytes(plane);
+    const u32 sites = tile.OWNED_WIDTH * tile.OWNED_HEIGHT;
+    u8 record[MAX_RECORD_BYTES];
+    u32 runLength = 0;
+
+    for (u32 i = 0; i < sites; ++i)
+    {
+      if (runLength == 0)
+      {
+        if (!runLengthEncoded)
+        {
+          runLength = 1;
+        }
+        else if (!ReadU32(fp, runLength) || runLength == 0 || runLength > sites - i)
+        {
+          return false;
+        }
+
+        if (!ReadBytes(fp, record, bytes))
+        {
+          return false;
+        }
+      }
+      --runLength;
+
+      SPoint owned(i % tile.OWNED_WIDTH, i / tile.OWNED_WIDTH);
+      UnpackRecord(plane, record, tile.GetUncachedSite(owned));
+    }
+    return true;
+  }
+
+  template <class GC>
+  void GridSnapshot<GC>::WriteTypeMappings(FILE * fp)
+  {
+    ElementRegistry<EC> & er = m_grid.GetElementRegistry();
+    const u32 entries = er.GetEntryCount();
+
+    u32 count = 0;
+    for (u32 i = 0; i < entries; ++i)
+    {
+      if (er.GetRegisteredElement(i)) ++count;
+    }
+    if (count > MAX_SNAPSHOT_TYPES)
+    {
+      FAIL(OUT_OF_ROOM);
+    }
+    WriteU32(fp, count);
+
+    for (u32 i = 0; i < entries; ++i)
+    {
+      Element<EC> * elt = er.GetRegisteredElement(i);
+      if (!elt) continue;
+
+      UUID::OStringUUIDName name;
+      er.GetEntryUUID(i).Print(name);
+      if (name.HasOverflowed())
+      {
+        FAIL(OUT_OF_ROOM);
+      }
+
+      WriteU32(fp, elt->GetDefaultAtom().GetType());
+      WriteU32(fp, name.GetLength());
+      WriteBytes(fp, name.GetZString(), name.GetLength());
+    }
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::ReadTypeMappings(FILE * fp)
+  {
+    ElementRegistry<EC> & er = m_grid.GetElementRegistry();
+
+    m_typeMappingCount = 0;
+    m_lastTypeMapping = 0;
+
+    u32 count;
+    if (!ReadU32(fp, count) || count > MAX_SNAPSHOT_TYPES)
+    {
+      return false;
+    }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+      u32 savedType, length;
+      char name[MAX_UUID_BYTES];
+      if (!ReadU32(fp, savedType) || !ReadU32(fp, length) ||
+          length >= sizeof(name) || !ReadBytes(fp, name, length))
+      {
+        return false;
+      }
+
+      UUID uuid;
+      CharBufferByteSource cbs(name, length);
+      if (!uuid.Read(cbs))
+      {
+        LOG.Error("Bad element UUID in snapshot table entry %d", i);
+        return false;
+      }
+
+      Element<EC> * elt = er.Lookup(uuid);
+      if (!elt)
+      {
+        elt = er.LookupCompatible(uuid);
+        if (elt)
+        {
+          LOG.Warning("Using more recent '%@' for '%@'", &elt->GetUUID(), &uuid);
+        }
+        else
+        {
+          LOG.Warning("No alternatives found for unknown/unregistered element '%@'", &uuid);
+        }
+      }
+
+      TypeMapping & tm = m_typeMappings[m_typeMappingCount++];
+      tm.m_savedType = savedType;
+      tm.m_element = elt;
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Write(const char * path)
+  {
+    FILE * fp = fopen(path, "wb");
+    if (!fp)
+    {
+      LOG.Error("Can't write snapshot file '%s'", path);
+      return false;
+    }
+
+    const Tile<EC> & firstTile = *m_grid.begin();
+
+    u32 tiles = 0;
+    for (typename Grid<GC>::iterator_type i = m_grid.begin(); i != m_grid.end(); ++i)
+    {
+      ++tiles;
+    }
+
+    WriteBytes(fp, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    WriteU32(fp, BYTE_ORDER_MARK);
+    WriteU32(fp, SNAPSHOT_VERSION);
+    WriteU32(fp, m_runLengthEncoding ? SNAPSHOT_FLAG_RUN_LENGTH : 0);
+    WriteU32(fp, AC::BITS_PER_ATOM);
+    WriteU32(fp, ATOM_WORDS);
+    WriteU32(fp, firstTile.OWNED_WIDTH);
+    WriteU32(fp, firstTile.OWNED_HEIGHT);
+    WriteU32(fp, EC::EVENT_WINDOW_RADIUS);
+    WriteU32(fp, m_grid.GetWidth());
+    WriteU32(fp, m_grid.GetHeight());
+
+    /* The configuration text, minus the sites, with its length
+       patched in once we know it */
+    long lengthAt = ftell(fp);
+    WriteU32(fp, 0);
+    {
+      FileByteSink fs(fp);
+      m_section.SetWriteSites(false);
+      m_config.Write(fs);
+      m_section.SetWriteSites(true);
+    }
+    long textEnd = ftell(fp);
+    if (lengthAt < 0 || textEnd < 0 || fseek(fp, lengthAt, SEEK_SET))
+    {
+      FAIL(IO_ERROR);
+    }
+    WriteU32(fp, (u32) (textEnd - lengthAt - sizeof(u32)));
+    if (fseek(fp, textEnd, SEEK_SET))
+    {
+      FAIL(IO_ERROR);
+    }
+
+    WriteTypeMappings(fp);
+
+    WriteU32(fp, tiles);
+    for (typename Grid<GC>::iterator_type i = m_grid.begin(); i != m_grid.end(); ++i)
+    {
+      const Tile<EC> & tile = *i;
+      SPoint tpt = i.At();
+      WriteU32(fp, (u32) tpt.GetX());
+      WriteU32(fp, (u32) tpt.GetY());
+      for (u32 plane = 0; plane < PLANE_COUNT; ++plane)
+      {
+        WritePlane(fp, tile, plane);
+      }
+    }
+
+    if (fclose(fp))
+    {
+      FAIL(IO_ERROR);
+    }
+    return true;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::Read(const char * path)
+  {
+    FILE * fp = fopen(path, "rb");
+    if (!fp)
+    {
+      LOG.Error("Can't read snapshot file '%s'", path);
+      return false;
+    }
+
+    bool ret = ReadFile(fp, path);
+    fclose(fp);
+
+    m_grid.RefreshAllCaches();
+    m_grid.RecountAtoms();
+
+    return ret;
+  }
+
+  template <class GC>
+  bool GridSnapshot<GC>::ReadFile(FILE * fp, const char * path)
+  {
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    if (!ReadBytes(fp, magic, sizeof(magic)) || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)))
+    {
+      LOG.Error("'%s' is not a grid snapshot", path);
+      return false;
+    }
+
+    u32 header[10];
+    if (!ReadBytes(fp, header, sizeof(header)))
+    {
+      LOG.Error("Truncated snapshot header in '%s'", path);
+      return false;
+    }
+
+    if (header[0] != BYTE_ORDER_MARK)
+    {
+      LOG.Error("Snapshot '%s' was written with a different byte order", path);
+      return false;
+    }
+
+    if (header[1] > SNAPSHOT_VERSION)
+    {
+      LOG.Error("Snapshot version %d newer than us (%d)", header[1], SNAPSHOT_VERSION);
+      return false;
+    }
+
+    const u32 flags = header[2];
+    if (flags & ~SNAPSHOT_FLAG_RUN_LENGTH)
+    {
+      LOG.Error("Unknown snapshot flags 0x%x", flags);
+      return false;
+    }
+
+    const Tile<EC> & firstTile = *m_grid.begin();
+    if (header[3] != AC::BITS_PER_ATOM || header[4] != ATOM_WORDS ||
+        header[5] != firstTile.OWNED_WIDTH || header[6] != firstTile.OWNED_HEIGHT ||
+        header[7] != EC::EVENT_WINDOW_RADIUS ||
+        header[8] != m_grid.GetWidth() || header[9] != m_grid.GetHeight())
+    {
+      LOG.Error("Snapshot geometry (%d bit atoms, %dx%d owned sites, radius %d, %dx%d tiles)"
+                " does not match this grid",
+                header[3], header[5], header[6], header[7], header[8], header[9]);
+      return false;
+    }
+
+    u32 textLength;
+    if (!ReadU32(fp, textLength))
+    {
+      return false;
+    }
+    long textStart = ftell(fp);
+    {
+      FileRangeByteSource frbs(fp, textLength);
+      m_config.SetByteSource(frbs, path);
+      if (!m_config.Read())
+      {
+        return false;  // Error message already issued
+      }
+    }
+    if (textStart < 0 || fseek(fp, textStart + textLength, SEEK_SET))
+    {
+      return false;
+    }
+
+    if (!ReadTypeMappings(fp))
+    {
+      LOG.Error("Bad element table in snapshot '%s'", path);
+      return false;
+    }
+
+    const bool runLengthEncoded = (flags & SNAPSHOT_FLAG_RUN_LENGTH) != 0;
+    m_unmappedAtoms = 0;
+
+    u32 tiles;
+    if (!ReadU32(fp, tiles))
+    {
+      return false;
+    }
+
+    for (u32 t = 0; t < tiles; ++t)
+    {
+      u32 tx, ty;
+      if (!ReadU32(fp, tx) || !ReadU32(fp, ty) ||
+          !m_grid.IsLegalTileIndex(SPoint(tx, ty)))
+      {
+        LOG.Error("Bad tile position in snapshot '%s'", path);
+        return false;
+      }
+
+      Tile<EC> & tile = m_grid.GetTile(SPoint(tx, ty));
+      for (u32 plane = 0; plane < PLANE_COUNT; ++plane)
+      {
+        if (!ReadPlane(fp, tile, plane, runLengthEncoded))
+        {
+          LOG.Error("Truncated or corrupt tile data in snapshot '%s'", path);
+          return false;
+        }
+      }
+    }
+
+    if (m_unmappedAtoms > 0)
+    {
+      LOG.Warning("%d atoms of unknown types were loaded as empty", m_unmappedAtoms);
+    }
+
+    return true;
+  }
+}
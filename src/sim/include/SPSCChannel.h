@@ -0,0 +1,158 @@
+/*                                              -*- mode:C++ -*-
+  SPSCChannel.h A lock-free two-way communications channel
+  Copyright (C) 2026 The Regents of the University of New Mexico.  All rights reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301
+  USA
+*/
+
+/**
+  \file SPSCChannel.h A lock-free two-way byte communications channel
+  \lgpl
+ */
+#ifndef SPSCCHANNEL_H
+#define SPSCCHANNEL_H
+
+#include "itype.h"
+#include "AbstractChannel.h"
+
+namespace MFM
+{
+  /**
+    An AbstractChannel made of two single-producer, single-consumer
+    ring buffers, one per direction, with no locks and no bandwidth
+    simulation.  Bytes written by one side are readable by the other
+    side immediately.
+
+    Each ring has a write index stored only by its producer and a
+    read index stored only by its consumer.  The producer publishes
+    data by storing the write index with release semantics after
+    copying the bytes in, and the consumer acquires the write index
+    before copying them out; the read index works the same way in the
+    other direction.  So this is only correct when, in each direction,
+    at most one thread at a time writes and at most one thread at a
+    time reads -- which is what a Tile's CacheProcessor guarantees
+    for its ChannelEnd.
+
+    \sa GridTransceiver
+   */
+  class SPSCChannel : public AbstractChannel
+  {
+  public:
+
+    ////
+    // BEGIN AbstractChannel interface
+
+    virtual u32 CanWrite(bool byA)
+    {
+      return GetOutputRing(byA).CanWrite();
+    }
+
+    virtual u32 Write(bool byA, const u8 * data, u32 length)
+    {
+      return GetOutputRing(byA).Write(data, length);
+    }
+
+    virtual u32 CanRead(bool byA)
+    {
+      return GetInputRing(byA).CanRead();
+    }
+
+    virtual u32 Read(bool byA, u8 * data, u32 length)
+    {
+      return GetInputRing(byA).Read(data, length);
+    }
+
+    // END AbstractChannel interface
+    ////
+
+    SPSCChannel() { }
+
+  private:
+
+    friend class SPSCChannel_Test;
+
+    enum {
+      BUFFER_SIZE = 2048,  // Must be a power of two
+      CACHE_LINE_SIZE = 64
+    };
+
+    struct Ring {
+
+      static inline u32 BytesBetween(u32 idxHi, u32 idxLo)
+      {
+        return (idxHi - idxLo) & (BUFFER_SIZE - 1);
+      }
+
+      static inline u32 LoadAcquire(const u32 & idx)
+      {
+        return __atomic_load_n(&idx, __ATOMIC_ACQUIRE);
+      }
+
+      static inline void StoreRelease(u32 & idx, u32 value)
+      {
+        __atomic_store_n(&idx, value, __ATOMIC_RELEASE);
+      }
+
+      Ring()
+        : m_writeIndex(0)
+        , m_readIndex(0)
+      { }
+
+      /** Called only by the producer */
+      u32 CanWrite() const
+      {
+        return BytesBetween(LoadAcquire(m_readIndex), m_writeIndex + 1);
+      }
+
+      /** Called only by the producer */
+      u32 Write(const u8 * data, u32 length) ;
+
+      /** Called only by the consumer */
+      u32 CanRead() const
+      {
+        return BytesBetween(LoadAcquire(m_writeIndex), m_readIndex);
+      }
+
+      /** Called only by the consumer */
+      u32 Read(u8 * data, u32 length) ;
+
+    private:
+      u32 m_writeIndex;
+      u8 m_writerPad[CACHE_LINE_SIZE - sizeof(u32)];  // keep the indices on separate lines
+
+      u32 m_readIndex;
+      u8 m_readerPad[CACHE_LINE_SIZE - sizeof(u32)];
+
+      u8 m_buffer[BUFFER_SIZE];
+    };
+
+    Ring m_ringAtoB;
+    Ring m_ringBtoA;
+
+    Ring & GetOutputRing(bool byA)
+    {
+      return byA ? m_ringAtoB : m_ringBtoA;
+    }
+
+    Ring & GetInputRing(bool byA)
+    {
+      return byA ? m_ringBtoA : m_ringAtoB;
+    }
+
+  };
+}
+
+#endif /* SPSCCHANNEL_H */
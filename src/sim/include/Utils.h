@@ -103,6 +103,12 @@ namespace MFM
      */
     const char * ReadablePath(const char * path) ;
 
+    /**
+       Return the number of processors currently online, or 1 if that
+       cannot be determined.
+     */
+    u32 GetOnlineProcessorCount() ;
+
   }
 }
 
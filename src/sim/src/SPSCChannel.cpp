@@ -0,0 +1,32 @@
+#include "SPSCChannel.h"
+#include "Util.h"  // For MIN
+#include <string.h>  // For memcpy
+
+namespace MFM
+{
+  u32 SPSCChannel::Ring::Write(const u8 * data, u32 length)
+  {
+    const u32 w = m_writeIndex;  // Only we store it
+    const u32 amt = MIN(length, BytesBetween(LoadAcquire(m_readIndex), w + 1));
+    const u32 first = MIN(amt, BUFFER_SIZE - w);
+
+    memcpy(&m_buffer[w], data, first);
+    memcpy(&m_buffer[0], data + first, amt - first);
+
+    StoreRelease(m_writeIndex, (w + amt) & (BUFFER_SIZE - 1));
+    return amt;
+  }
+
+  u32 SPSCChannel::Ring::Read(u8 * data, u32 length)
+  {
+    const u32 r = m_readIndex;  // Only we store it
+    const u32 amt = MIN(length, BytesBetween(LoadAcquire(m_writeIndex), r));
+    const u32 first = MIN(amt, BUFFER_SIZE - r);
+
+    memcpy(data, &m_buffer[r], first);
+    memcpy(data + first, &m_buffer[0], amt - first);
+
+    StoreRelease(m_readIndex, (r + amt) & (BUFFER_SIZE - 1));
+    return amt;
+  }
+}
@@ -2,7 +2,7 @@
 #include "Fail.h"
 #include "Logger.h" /* for LOG */
 #include <stdlib.h>
-#include <unistd.h> /* for open(), close() */
+#include <unistd.h> /* for open(), close(), sysconf() */
 #include <fcntl.h>  /* for O_RDONLY */
 #include <string.h> /* for strerror */
 #include <errno.h> /* for errno */
@@ -53,6 +53,12 @@ namespace MFM {
       return strerror(errno);
     }
 
+    u32 GetOnlineProcessorCount()
+    {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      return n > 0 ? (u32) n : 1;
+    }
+
     bool GetReadableResourceFile(const char * relativePath, ByteSink& result)
     {
       OString512 buffer;
@@ -0,0 +1,27 @@
+#ifndef EVENTHISTORYLOG_TEST_H      /* -*- C++ -*- */
+#define EVENTHISTORYLOG_TEST_H
+
+#include "Test_Common.h"
+#include "EventHistoryLog.h"
+
+namespace MFM {
+
+  /**
+   * Tests for the EventHistoryLog class
+   */
+  class EventHistoryLog_Test
+  {
+  public:
+    static void Test_RunTests();
+
+    static void Test_EventHistoryLogReplay();
+
+    static void Test_EventHistoryLogEditsWhilePaused();
+
+    static void Test_EventHistoryLogSegmentFailure();
+
+    static void Test_EventHistoryLogSeekGrid();
+  };
+} /* namespace MFM */
+
+#endif /*EVENTHISTORYLOG_TEST_H*/
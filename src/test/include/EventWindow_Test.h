@@ -14,8 +14,21 @@ public:
 
   static void Test_EventWindowNoLockOpen();
 
+  static void Test_EventWindowPhaseProfile();
+
   static void Test_EventWindowWrite();
 
+  static void Test_EventWindowSwapWriteBack();
+
+  static void Test_EventWindowBatchedUnwind();
+  static void Test_EventWindowBatchedAdvanceFailure();
+
+  static void Test_EventWindowElementProfile();
+
+  static void Test_EventWindowCacheProfile();
+
+  static void Test_EventWindowTypeQueries();
+
   static void Test_RunTests();
 };
 } /* namespace MFM */
@@ -15,6 +15,11 @@ namespace MFM {
   {
   public:
     static void Test_gridPlaceAtom();
+    static void Test_gridRasterize();
+    static void Test_gridRefreshCaches();
+    static void Test_gridShutdownTileThreads();
+    static void Test_gridPauseUnpauseCycles();
+    static void Test_gridSnapshotAtomCounts();
   };
 } /* namespace MFM */
 #endif /*GRID_TEST_H*/
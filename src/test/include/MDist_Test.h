@@ -12,6 +12,8 @@ namespace MFM {
   {
   public:
     static void Test_MDistConversion();
+
+    static void Test_MDistSymPermutation();
   };
 } /* namespace MFM */
 #endif /*MDIST_TEST_H*/
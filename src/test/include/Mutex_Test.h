@@ -0,0 +1,22 @@
+#ifndef MUTEX_TEST_H      /* -*- C++ -*- */
+#define MUTEX_TEST_H
+
+#include "Mutex.h"
+
+namespace MFM {
+
+  class Mutex_Test
+  {
+  private:
+
+  public:
+    static void Test_ConditionTimeout();
+    static void Test_ConditionSignal();
+    static void Test_ConditionBroadcast();
+    static void Test_ConditionSignalBeforeTimeout();
+
+    static void Test_RunTests();
+
+  };
+} /* namespace MFM */
+#endif /*MUTEX_TEST_H*/
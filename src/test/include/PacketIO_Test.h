@@ -0,0 +1,25 @@
+#ifndef PACKETIO_TEST_H      /* -*- C++ -*- */
+#define PACKETIO_TEST_H
+
+#include "Test_Common.h"
+#include "PacketIO.h"
+#include "ChannelEnd.h"
+
+namespace MFM {
+
+  /**
+   * Tests for packet framing on a ChannelEnd and for cache update
+   * packets sent and received through PacketIO
+   */
+  class PacketIO_Test
+  {
+  public:
+    static void Test_RunTests();
+
+    static void Test_packetFraming();
+    static void Test_packetFramingOutOfRoom();
+    static void Test_packetUpdateBatch();
+  };
+} /* namespace MFM */
+
+#endif /*PACKETIO_TEST_H*/
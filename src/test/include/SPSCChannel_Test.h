@@ -0,0 +1,21 @@
+#ifndef SPSCCHANNEL_TEST_H      /* -*- C++ -*- */
+#define SPSCCHANNEL_TEST_H
+
+#include "SPSCChannel.h"
+
+namespace MFM {
+
+  class SPSCChannel_Test
+  {
+  private:
+
+  public:
+    static void Test_Basic();
+    static void Test_Wraparound();
+    static void Test_Threaded();
+
+    static void Test_RunTests();
+
+  };
+} /* namespace MFM */
+#endif /*SPSCCHANNEL_TEST_H*/
@@ -7,6 +7,7 @@
 #include "ElementTable.h"
 #include "EventWindow.h"
 #include "SizedTile.h"
+#include "SoASite.h"
 
 namespace MFM {
 
@@ -23,6 +24,10 @@ namespace MFM {
   typedef Grid<TestGridConfig> TestGrid;
   typedef TestGrid::GridTile TestTile;
 
+  typedef SoASite<P3AtomConfig> TestSoASite;
+  typedef EventConfig<TestSoASite, 4> TestSoAEventConfig;
+  typedef SizedTile<TestSoAEventConfig,40,40,1000> TestSoATile;
+
   typedef ElementTable<TestEventConfig> TestElementTable;
   typedef EventWindow<TestEventConfig> TestEventWindow;
 
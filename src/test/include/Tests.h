@@ -7,7 +7,11 @@
 #include "UlamRef_Test.h"
 #include "BitRef_Test.h"
 #include "UlamElement_Test.h"
+#include "UlamClassRegistry_Test.h"
 #include "GridTransceiver_Test.h"
+#include "SPSCChannel_Test.h"
+#include "Mutex_Test.h"
+#include "PacketIO_Test.h"
 #include "ElementRegistry_Test.h"
 #include "ByteSource_Test.h"
 #include "LineTailByteSink_Test.h"
@@ -30,5 +34,6 @@
 #include "ColorMap_Test.h"
 #include "FXP_Test.h"
 #include "ExternalConfig_Test.h"
+#include "EventHistoryLog_Test.h"
 
 #endif /*TESTS_H*/
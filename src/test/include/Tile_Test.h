@@ -15,6 +15,13 @@ namespace MFM {
 
     static void Test_tilePlaceAtom();
     static void Test_tileSquareDistances();
+    static void Test_tileSoASites();
+    static void Test_tileLiveSites();
+    static void Test_tileAtomCounts();
+    static void Test_tileChangeStamps();
+    static void Test_tileEventBatching();
+    static void Test_tileSnapshots();
+    static void Test_tileSnapshotsWhileRunning();
   };
 } /* namespace MFM */
 
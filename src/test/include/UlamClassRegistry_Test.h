@@ -0,0 +1,22 @@
+#ifndef ULAMCLASSREGISTRY_TEST_H      /* -*- C++ -*- */
+#define ULAMCLASSREGISTRY_TEST_H
+
+#include "Test_Common.h"
+#include "UlamClassRegistry.h"
+
+namespace MFM {
+
+  class UlamClassRegistry_Test
+  {
+  private:
+
+  public:
+    static void Test_RunTests();
+
+    static void Test_UlamClassRegistryMangledNames();
+
+    static void Test_UlamClassRegistryIsA();
+
+  };
+} /* namespace MFM */
+#endif /*ULAMCLASSREGISTRY_TEST_H*/
@@ -30,6 +30,8 @@ namespace MFM {
 
     static void Test_UlamElementLong();
 
+    static void Test_UlamElementColorCache();
+
   };
 } /* namespace MFM */
 #endif /*ULAMELEMENT_TEST_H*/
@@ -30,6 +30,8 @@ namespace MFM {
 
     static void Test_UlamRefWriteBV();
 
+    static void Test_UlamRefTyped();
+
   };
 } /* namespace MFM */
 #endif /*ULAMREF_TEST_H*/
@@ -0,0 +1,458 @@
+#include "assert.h"
+#include <stdio.h>  /* For remove */
+#include "EventHistoryLog_Test.h"
+#include "Element_Res.h"
+#include "Grid.h"
+#include <sys/stat.h>  /* For mkdir */
+#include <unistd.h>    /* For rmdir, getpid */
+
+namespace MFM {
+
+  typedef EventHistoryLog<TestEventConfig> TestEventHistoryLog;
+
+  void EventHistoryLog_Test::Test_RunTests()
+  {
+    Test_EventHistoryLogReplay();
+    Test_EventHistoryLogEditsWhilePaused();
+    Test_EventHistoryLogSegmentFailure();
+    Test_EventHistoryLogSeekGrid();
+  }
+
+  static void CopyAtoms(const TestTile & tile, TestAtom * atoms)
+  {
+    const u32 sites = tile.TILE_WIDTH * tile.TILE_HEIGHT;
+    for (u32 i = 0; i < sites; ++i)
+    {
+      atoms[i] = tile.GetSiteByNumber(i).GetAtom();
+    }
+  }
+
+  static bool SameAtoms(const TestTile & tile, const TestAtom * atoms)
+  {
+    const u32 sites = tile.TILE_WIDTH * tile.TILE_HEIGHT;
+    for (u32 i = 0; i < sites; ++i)
+    {
+      if (tile.GetSiteByNumber(i).GetAtom() != atoms[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Name the logs under /tmp after \c name and this process, so
+   * concurrent test runs don't share them
+   */
+  static void MakeTempPrefix(char * prefix, u32 size, const char * name)
+  {
+    snprintf(prefix, size, "/tmp/%s.%d", name, (s32) getpid());
+  }
+
+  static void RemoveSegments(const char * prefix)
+  {
+    char path[100];
+    for (u32 n = 0; ; ++n)
+    {
+      snprintf(path, sizeof(path), "%s-%06d.ehl", prefix, n);
+      if (remove(path) != 0)
+      {
+        break;
+      }
+    }
+  }
+
+  /**
+   * Try events at random until \c log has logged \c target of them
+   */
+  static void LogEventsUntil(TestTile & tile, TestEventHistoryLog & log, u64 target)
+  {
+    const s32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    TestEventWindow & ew = tile.GetEventWindow();
+    Random & random = tile.GetRandom();
+    for (u32 tries = 0; log.GetEventsLogged() < target && tries < 1000000; ++tries)
+    {
+      ew.SetEventWindowsExecuted(ew.GetEventWindowsExecuted() + 1000000); // avoid recency rejects
+      SPoint center(random.Between(R, tile.TILE_WIDTH - R - 1),
+                    random.Between(R, tile.TILE_HEIGHT - R - 1));
+      ew.TryEventAtForTesting(center);
+    }
+    assert(log.GetEventsLogged() == target);
+  }
+
+  void EventHistoryLog_Test::Test_EventHistoryLogReplay()
+  {
+    char prefix[64];
+    MakeTempPrefix(prefix, sizeof(prefix), "EventHistoryLog_Test");
+    const u32 KEYFRAME_EVENTS = 7;
+    const u32 SEGMENT_BYTES = 200000;  // About three keyframes
+    const u32 MIDDLE_EVENT = 20;
+    const u32 LAST_EVENT = 60;
+
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    res.AllocateTypeForTesting(etnm);
+
+    TestTile tile;
+    tile.RegisterElement(res);
+    tile.SetHistoryActive(true);
+    const s32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    for (s32 y = R; y < (s32) tile.TILE_HEIGHT - R; y += 3)
+    {
+      for (s32 x = R; x < (s32) tile.TILE_WIDTH - R; x += 3)
+      {
+        tile.PlaceAtom(res.GetDefaultAtom(), SPoint(x, y));
+      }
+    }
+
+    const u32 sites = tile.TILE_WIDTH * tile.TILE_HEIGHT;
+    TestAtom * initial = new TestAtom[sites];
+    TestAtom * middle = new TestAtom[sites];
+    CopyAtoms(tile, initial);
+
+    {
+      TestEventHistoryLog log(tile);
+      assert(log.Open(prefix, KEYFRAME_EVENTS, SEGMENT_BYTES));
+      assert(tile.GetEventHistoryBuffer().GetSink() == &log);
+
+      TestEventWindow & ew = tile.GetEventWindow();
+      Random & random = tile.GetRandom();
+      for (u32 tries = 0; log.GetEventsLogged() < LAST_EVENT && tries < 1000000; ++tries)
+      {
+        ew.SetEventWindowsExecuted(1000000 * (u64) (tries + 1)); // avoid recency rejects
+        SPoint center(random.Between(R, tile.TILE_WIDTH - R - 1),
+                      random.Between(R, tile.TILE_HEIGHT - R - 1));
+        ew.TryEventAtForTesting(center);
+        if (log.GetEventsLogged() == MIDDLE_EVENT)
+        {
+          CopyAtoms(tile, middle);
+        }
+      }
+      assert(log.GetEventsLogged() == LAST_EVENT);
+      assert(!SameAtoms(tile, initial));
+    }
+    assert(tile.GetEventHistoryBuffer().GetSink() == 0);
+
+    // The log outgrew one segment
+    char path[100];
+    snprintf(path, sizeof(path), "%s-000001.ehl", prefix);
+    FILE * fp = fopen(path, "rb");
+    assert(fp);
+    fclose(fp);
+
+    // Replay onto a fresh tile, from various keyframes
+    TestTile replay;
+    replay.RegisterElement(res);
+    assert(TestEventHistoryLog::Seek(prefix, replay, LAST_EVENT));
+    TestAtom * last = new TestAtom[sites];
+    CopyAtoms(tile, last);
+    assert(SameAtoms(replay, last));
+
+    assert(TestEventHistoryLog::Seek(prefix, replay, MIDDLE_EVENT));
+    assert(SameAtoms(replay, middle));
+
+    assert(TestEventHistoryLog::Seek(prefix, replay, 0));
+    assert(SameAtoms(replay, initial));
+
+    assert(!TestEventHistoryLog::Seek(prefix, replay, LAST_EVENT + 1));
+
+    for (u32 n = 0; ; ++n)
+    {
+      snprintf(path, sizeof(path), "%s-%06d.ehl", prefix, n);
+      if (remove(path) != 0)
+      {
+        break;
+      }
+    }
+    delete [] last;
+    delete [] middle;
+    delete [] initial;
+  }
+
+  void EventHistoryLog_Test::Test_EventHistoryLogEditsWhilePaused()
+  {
+    char prefix[64];
+    MakeTempPrefix(prefix, sizeof(prefix), "EventHistoryLog_Test_Edits");
+    const u32 EDIT_EVENT = 10;
+    const u32 LAST_EVENT = 20;
+
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    res.AllocateTypeForTesting(etnm);
+
+    TestTile tile;
+    tile.RegisterElement(res);
+    tile.SetHistoryActive(true);
+    const s32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+
+    const u32 sites = tile.TILE_WIDTH * tile.TILE_HEIGHT;
+    TestAtom * loaded = new TestAtom[sites];
+    TestAtom * edited = new TestAtom[sites];
+    TestAtom * last = new TestAtom[sites];
+
+    {
+      // Opened before anything is loaded, as a driver does
+      TestEventHistoryLog log(tile);
+      assert(log.Open(prefix));
+
+      for (s32 y = R; y < (s32) tile.TILE_HEIGHT - R; y += 4)
+      {
+        for (s32 x = R; x < (s32) tile.TILE_WIDTH - R; x += 4)
+        {
+          tile.PlaceAtom(res.GetDefaultAtom(), SPoint(x, y));
+        }
+      }
+      CopyAtoms(tile, loaded);
+
+      // The loaded tile gets a keyframe as it first runs
+      const u32 RUN = TestEventHistoryLog::RUN_BYTES;
+      u32 used = log.m_used;
+      log.Resuming();
+      assert(log.m_used == used + log.GetKeyframeBytes() + RUN);
+      LogEventsUntil(tile, log, EDIT_EVENT);
+
+      // Pausing and resuming with no changes costs just the run record
+      log.Paused();
+      used = log.m_used;
+      log.Resuming();
+      assert(log.m_used == used + RUN);
+
+      // But an edit while paused gets a keyframe
+      log.Paused();
+      used = log.m_used;
+      tile.PlaceAtom(tile.GetEmptyAtom(), SPoint(R, R));
+      tile.GetSite(SPoint(R + 1, R)).SetPaint(0xff00ff00);
+      CopyAtoms(tile, edited);
+      log.Resuming();
+      assert(log.m_used == used + log.GetKeyframeBytes() + RUN);
+      assert(log.GetRunsLogged() == 3);
+
+      LogEventsUntil(tile, log, LAST_EVENT);
+      CopyAtoms(tile, last);
+    }
+
+    TestTile replay;
+    replay.RegisterElement(res);
+    assert(TestEventHistoryLog::Seek(prefix, replay, 0));
+    assert(SameAtoms(replay, loaded));
+
+    assert(TestEventHistoryLog::Seek(prefix, replay, EDIT_EVENT));
+    assert(SameAtoms(replay, edited));
+    assert(replay.GetSite(SPoint(R + 1, R)).GetPaint() == 0xff00ff00);
+
+    assert(TestEventHistoryLog::Seek(prefix, replay, LAST_EVENT));
+    assert(SameAtoms(replay, last));
+
+    RemoveSegments(prefix);
+    delete [] last;
+    delete [] edited;
+    delete [] loaded;
+  }
+
+  void EventHistoryLog_Test::Test_EventHistoryLogSegmentFailure()
+  {
+    char prefix[64];
+    MakeTempPrefix(prefix, sizeof(prefix), "EventHistoryLog_Test_Failure");
+    const u32 SEGMENT_BYTES = 100000;  // Room for one keyframe
+
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    res.AllocateTypeForTesting(etnm);
+
+    TestTile tile;
+    tile.RegisterElement(res);
+    tile.SetHistoryActive(true);
+    const s32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    for (s32 y = R; y < (s32) tile.TILE_HEIGHT - R; y += 3)
+    {
+      for (s32 x = R; x < (s32) tile.TILE_WIDTH - R; x += 3)
+      {
+        tile.PlaceAtom(res.GetDefaultAtom(), SPoint(x, y));
+      }
+    }
+
+    // Nothing can be created where the second segment goes
+    char blocker[100];
+    snprintf(blocker, sizeof(blocker), "%s-000001.ehl", prefix);
+    rmdir(blocker);
+    assert(!mkdir(blocker, 0755));
+
+    u64 logged;
+    {
+      TestEventHistoryLog log(tile);
+      assert(log.Open(prefix, 1000000, SEGMENT_BYTES));
+
+      TestEventWindow & ew = tile.GetEventWindow();
+      Random & random = tile.GetRandom();
+      for (u32 tries = 0; log.IsOpen() && tries < 1000000; ++tries)
+      {
+        ew.SetEventWindowsExecuted(ew.GetEventWindowsExecuted() + 1000000); // avoid recency rejects
+        SPoint center(random.Between(R, tile.TILE_WIDTH - R - 1),
+                      random.Between(R, tile.TILE_HEIGHT - R - 1));
+        ew.TryEventAtForTesting(center);
+      }
+
+      // The log stopped, and everything after is ignored
+      assert(!log.IsOpen());
+      logged = log.GetEventsLogged();
+      assert(logged > 0);
+      ew.SetEventWindowsExecuted(ew.GetEventWindowsExecuted() + 1000000);
+      log.Resuming();
+      assert(log.GetRunsLogged() == 0);
+    }
+    assert(tile.GetEventHistoryBuffer().GetSink() == 0);
+
+    // Seek reaches the end of what was logged, but no further
+    TestTile replay;
+    replay.RegisterElement(res);
+    assert(TestEventHistoryLog::Seek(prefix, replay, logged));
+    assert(!TestEventHistoryLog::Seek(prefix, replay, logged + 1));
+
+    assert(!rmdir(blocker));
+    RemoveSegments(prefix);
+  }
+
+  static void CopyGridAtoms(TestGrid & grid, TestAtom * atoms)
+  {
+    for (u32 y = 0; y < grid.GetHeightSites(); ++y)
+    {
+      for (u32 x = 0; x < grid.GetWidthSites(); ++x)
+      {
+        SPoint at(x, y);
+        *atoms++ = *grid.GetAtom(at);
+      }
+    }
+  }
+
+  /**
+   * True if every site of \c grid, cache sites included, is as
+   * placing \c atoms into a fresh grid would leave it
+   */
+  static bool IsGridOf(TestGrid & grid, const TestAtom * atoms)
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid placed(ereg, grid.GetWidth(), grid.GetHeight(), (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+    placed.SetSeed(1);
+    placed.Init();
+    placed.Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+    for (u32 y = 0; y < placed.GetHeightSites(); ++y)
+    {
+      for (u32 x = 0; x < placed.GetWidthSites(); ++x)
+      {
+        placed.PlaceAtom(*atoms++, SPoint(x, y));
+      }
+    }
+
+    for (u32 tx = 0; tx < grid.GetWidth(); ++tx)
+    {
+      for (u32 ty = 0; ty < grid.GetHeight(); ++ty)
+      {
+        const Tile<TestEventConfig> & p = placed.GetTile(tx, ty);
+        const Tile<TestEventConfig> & g = grid.GetTile(tx, ty);
+        for (u32 y = 0; y < TestGrid::TILE_HEIGHT; ++y)
+        {
+          for (u32 x = 0; x < TestGrid::TILE_WIDTH; ++x)
+          {
+            if (*p.GetAtom(SPoint(x, y)) != *g.GetAtom(SPoint(x, y)))
+            {
+              return false;
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  void EventHistoryLog_Test::Test_EventHistoryLogSeekGrid()
+  {
+    char prefix[64];
+    MakeTempPrefix(prefix, sizeof(prefix), "EventHistoryLog_Test_Grid");
+    const u32 W = 3, H = 2;
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid * grid = new TestGrid(ereg, W, H, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+    grid->SetSeed(1);
+    grid->Init();
+    grid->Needed(res);
+
+    TestEventHistoryLog * logs[W * H];
+    char tilePrefix[TestEventHistoryLog::MAX_PATH_LENGTH];
+    for (u32 y = 0; y < H; ++y)
+    {
+      for (u32 x = 0; x < W; ++x)
+      {
+        Tile<TestEventConfig> & tile = grid->GetTile(x, y);
+        logs[y * W + x] = new TestEventHistoryLog(tile);
+        TestEventHistoryLog::MakeTilePathPrefix(tilePrefix, prefix, x, y);
+        assert(logs[y * W + x]->Open(tilePrefix));
+        tile.SetHistoryActive(true);
+      }
+    }
+
+    // Loaded after the logs open, as a driver does
+    for (u32 y = 0; y < grid->GetHeightSites(); y += 3)
+    {
+      for (u32 x = (y * 5) % 7; x < grid->GetWidthSites(); x += 7)
+      {
+        grid->PlaceAtom(res.GetDefaultAtom(), SPoint(x, y));
+      }
+    }
+
+    const u32 sites = grid->GetWidthSites() * grid->GetHeightSites();
+    const u32 RUNS = 3;
+    TestAtom * starts[RUNS];
+    for (u32 r = 0; r < RUNS; ++r)
+    {
+      starts[r] = new TestAtom[sites];
+    }
+
+    grid->InitThreads();
+    for (u32 r = 0; r < RUNS; ++r)
+    {
+      if (r == RUNS - 1)
+      {
+        // Edited while paused
+        grid->PlaceAtom(grid->GetTile(0, 0).GetEmptyAtom(), SPoint(3, 3));
+        grid->PlaceAtom(res.GetDefaultAtom(), SPoint(4, 4));
+      }
+      CopyGridAtoms(*grid, starts[r]);
+      grid->Unpause();
+      SleepMsec(30);
+      grid->Pause();
+    }
+    grid->ShutdownTileThreads();
+    for (u32 i = 0; i < W * H; ++i)
+    {
+      assert(logs[i]->GetRunsLogged() == RUNS);
+      delete logs[i];
+    }
+    delete grid;
+
+    // Rebuild a fresh grid at the start of each run
+    TestGrid replay(ereg, W, H, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+    replay.SetSeed(1);
+    replay.Init();
+    replay.Needed(res);
+    for (u32 r = RUNS; r > 0; --r)
+    {
+      assert(TestEventHistoryLog::SeekGrid(prefix, replay, r));
+      assert(IsGridOf(replay, starts[r - 1]));
+    }
+    assert(!TestEventHistoryLog::SeekGrid(prefix, replay, RUNS + 1));
+
+    for (u32 y = 0; y < H; ++y)
+    {
+      for (u32 x = 0; x < W; ++x)
+      {
+        TestEventHistoryLog::MakeTilePathPrefix(tilePrefix, prefix, x, y);
+        RemoveSegments(tilePrefix);
+      }
+    }
+    for (u32 r = 0; r < RUNS; ++r)
+    {
+      delete [] starts[r];
+    }
+  }
+} /* namespace MFM */
@@ -5,15 +5,74 @@
 #include "assert.h"
 #include "EventWindow_Test.h"
 #include "EventWindow.h"
+#include "WindowScanner.h"
 #include "Point.h"
+#include "SPSCChannel.h"
+#include "LonglivedLock.h"
 
 namespace MFM {
 
+  /**
+   * An element whose behavior always FAILs
+   */
+  template <class EC>
+  class Element_FailTest : public Element<EC>
+  {
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+
+  public:
+    static Element_FailTest THE_INSTANCE;
+
+    virtual u32 GetTypeFromThisElement() const
+    {
+      return 0xFA11;
+    }
+
+    Element_FailTest() : Element<EC>(MFM_UUID_FOR("FailTest", 1))
+    {
+      Element<EC>::SetAtomicSymbol("Ft");
+      Element<EC>::SetName("FailTest");
+    }
+
+    virtual const T & GetDefaultAtom() const
+    {
+      static T defaultAtom(THE_INSTANCE.GetType(),0,0,0);
+      return defaultAtom;
+    }
+
+    virtual u32 GetElementColor() const
+    {
+      return 0xffff0000;
+    }
+
+    virtual u32 PercentMovable(const T& you,
+                               const T& me, const SPoint& offset) const
+    {
+      return 0;
+    }
+
+    virtual void Behavior(EventWindow<EC>& window) const
+    {
+      FAIL(ILLEGAL_STATE);
+    }
+  };
+
+  template <class EC>
+  Element_FailTest<EC> Element_FailTest<EC>::THE_INSTANCE;
+
   void EventWindow_Test::Test_RunTests()
   {
     Test_EventWindowConstruction();
     Test_EventWindowNoLockOpen();
+    Test_EventWindowPhaseProfile();
     Test_EventWindowWrite();
+    Test_EventWindowSwapWriteBack();
+    Test_EventWindowBatchedUnwind();
+    Test_EventWindowBatchedAdvanceFailure();
+    Test_EventWindowElementProfile();
+    Test_EventWindowCacheProfile();
+    Test_EventWindowTypeQueries();
   }
 
   void EventWindow_Test::Test_EventWindowConstruction()
@@ -52,6 +111,48 @@ namespace MFM {
 
   }
 
+  void EventWindow_Test::Test_EventWindowPhaseProfile()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+
+    SPoint center(15, 20);  // Hitting no caches
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center);
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+
+    EventPhaseProfile profile;
+    tile.SetEventPhaseProfile(&profile);
+
+    // A single phase can take less than one clock tick, so check
+    // only that many events, all told, took some time
+    const u32 EVENTS = 1000;
+    bool success;
+    for (u32 i = 0; i < EVENTS; ++i)
+    {
+      ew.SetEventWindowsExecuted(1000000 * (i + 1));
+      success = ew.TryEventAt(center);
+      assert(success);
+    }
+
+    tile.SetEventPhaseProfile(0);
+    assert(profile.m_events == EVENTS);
+    assert(profile.m_nanos[EventPhaseProfile::PHASE_LOAD] +
+           profile.m_nanos[EventPhaseProfile::PHASE_BEHAVE] +
+           profile.m_nanos[EventPhaseProfile::PHASE_STORE] > 0);
+
+    // Detached, it's left alone
+    ew.SetEventWindowsExecuted(1000000 * (EVENTS + 1));
+    success = ew.TryEventAt(center);
+    assert(success);
+    assert(profile.m_events == EVENTS);
+    assert(ew.GetCenterAtomDirect().GetType() == WALL_TYPE);
+  }
+
   void EventWindow_Test::Test_EventWindowWrite()
   {
     TestTile tile;
@@ -107,4 +208,355 @@ namespace MFM {
 
   }
 
+  void EventWindow_Test::Test_EventWindowSwapWriteBack()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 RES_TYPE = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 EMPTY_TYPE = Element_Empty<TestEventConfig>::THE_INSTANCE.GetType();
+
+    SPoint center(12, 12);
+    SPoint east(1, 0);
+    SPoint south(0, 1);
+    SPoint north(0, -1);
+    SPoint zero(0, 0);
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center);
+    tile.PlaceAtom(TestAtom(RES_TYPE,0,0,0), center + south);
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+    assert(ew.TryEventAt(center));
+
+    // Each site reached by a Swap or by an atom bit storage reference
+    // must be written back, not just those set via SetRelativeAtom*
+    ew.SwapAtomsDirect(zero, east);
+    assert(ew.GetRelativeAtomDirect(east).GetType() == WALL_TYPE);
+    const u32 northSite = (u32) MDist<4>::get().FromPoint(north, 4);
+    ew.GetAtomBitStorage(northSite).WriteAtom(TestAtom(RES_TYPE,0,0,0));
+    ew.StoreToTile();
+
+    assert(tile.GetAtom(center)->GetType() == EMPTY_TYPE);
+    assert(tile.GetAtom(center + east)->GetType() == WALL_TYPE);
+    assert(tile.GetAtom(center + south)->GetType() == RES_TYPE);
+    assert(tile.GetAtom(center + north)->GetType() == RES_TYPE);
+  }
+
+  void EventWindow_Test::Test_EventWindowBatchedUnwind()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_FailTest<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_FailTest<TestEventConfig>::THE_INSTANCE);
+
+    const TestAtom failer = Element_FailTest<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    const u32 EMPTY_TYPE = Element_Empty<TestEventConfig>::THE_INSTANCE.GetType();
+
+    SPoint center(15, 20);  // Hitting no caches
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+
+    // Unbatched, ExecuteBehavior's own unwind_protect erases the failer
+    tile.PlaceAtom(failer, center);
+    assert(ew.TryEventAt(center));
+    assert(tile.GetAtom(center)->GetType() == EMPTY_TYPE);
+    assert(ew.IsFree());
+
+    // Batched, placements go straight through..
+    tile.SetUnwindBatched(true);
+    tile.PlaceAtom(failer, center);
+    assert(tile.GetAtom(center)->GetType() == failer.GetType());
+
+    // ..and the failure unwinds to our unwind_protect, after which
+    // RecoverBatchFailure gives the same result
+    ew.SetEventWindowsExecuted(2000000); // make the last event look old too
+    bool recovered = false;
+    unwind_protect(
+    {
+      tile.SetUnwindBatched(false);
+      tile.RecoverBatchFailure(MFMThrownFailCode,
+                               MFMThrownFromFile,
+                               MFMThrownFromLineNo,
+                               MFMThrownBacktraceArray,
+                               MFMThrownBacktraceSize);
+      recovered = true;
+    },
+    {
+      ew.TryEventAt(center);
+    });
+    assert(recovered);
+    assert(!tile.IsUnwindBatched());
+    assert(tile.GetAtom(center)->GetType() == EMPTY_TYPE);
+    assert(ew.IsFree());
+  }
+
+  void EventWindow_Test::Test_EventWindowBatchedAdvanceFailure()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_FailTest<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_FailTest<TestEventConfig>::THE_INSTANCE);
+
+    const TestAtom failer = Element_FailTest<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+    const u32 FAIL_TYPE = failer.GetType();
+
+    // Wherever the event lands, it fails
+    for (u32 x = 0; x < tile.OWNED_WIDTH; ++x)
+      for (u32 y = 0; y < tile.OWNED_HEIGHT; ++y)
+        tile.PlaceAtom(failer, TestTile::OwnedCoordToTile(SPoint(x, y)));
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+
+    EventPhaseProfile phaseProfile;
+    ElementProfile elementProfile;
+    tile.SetEventPhaseProfile(&phaseProfile);
+    tile.SetElementProfile(&elementProfile);
+    tile.SetEventBatchLimit(4);
+    tile.SetSnapshotInterval(1);
+    tile.SetRequestedState(TestTile::ACTIVE);
+
+    // Fail inside Advance, as a TileDriver's batch would
+    bool recovered = false;
+    tile.SetUnwindBatched(true);
+    unwind_protect(
+    {
+      tile.SetUnwindBatched(false);
+      tile.RecoverBatchFailure(MFMThrownFailCode,
+                               MFMThrownFromFile,
+                               MFMThrownFromLineNo,
+                               MFMThrownBacktraceArray,
+                               MFMThrownBacktraceSize);
+      recovered = true;
+    },
+    {
+      tile.Advance();
+    });
+    tile.SetEventPhaseProfile(0);
+    tile.SetElementProfile(0);
+    assert(recovered);
+    assert(ew.IsFree());
+
+    // The event was charged as if it had failed unbatched..
+    assert(phaseProfile.m_events == 1);
+    // (Recovery's backtrace alone takes well over a clock tick, but
+    // the store might not)
+    assert(phaseProfile.m_nanos[EventPhaseProfile::PHASE_BEHAVE] > 0);
+    const ElementProfile::Entry * entry = elementProfile.FindEntry(FAIL_TYPE);
+    assert(entry);
+    assert(entry->m_events == 1);
+    assert(entry->m_behaviorFailures == 1);
+
+    // ..and the rest of the Advance happened: the batch size adapted,
+    // and the snapshot shows the failer erased
+    assert(tile.GetEventBatchSize() == 2);
+    TileSnapshots<TestAtom>::Reader snapshot(tile.GetSnapshots());
+    assert(snapshot.IsValid());
+    assert(snapshot.GetEpoch() == tile.GetEventsExecuted());
+    u32 erased = 0;
+    for (u32 x = 0; x < tile.OWNED_WIDTH; ++x)
+      for (u32 y = 0; y < tile.OWNED_HEIGHT; ++y)
+        if (snapshot.GetAtom(x, y).GetType() != FAIL_TYPE) ++erased;
+    assert(erased == 1);
+  }
+
+  void EventWindow_Test::Test_EventWindowElementProfile()
+  {
+    assert(ElementProfile::Histogram::GetBucket(0) == 0);
+    assert(ElementProfile::Histogram::GetBucket(1) == 0);
+    assert(ElementProfile::Histogram::GetBucket(2) == 1);
+    assert(ElementProfile::Histogram::GetBucket(1000) == 9);
+    assert(ElementProfile::Histogram::GetBucket(1ul << 40) == ElementProfile::HISTOGRAM_BUCKETS - 1);
+    assert(Log2Histogram<64>::GetBucket(1ul << 40) == 40);
+    assert(Log2Histogram<64>::GetBucket(~((u64) 0)) == 63);
+
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Dreg<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Dreg<TestEventConfig>::THE_INSTANCE);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 DREG_TYPE = Element_Dreg<TestEventConfig>::THE_INSTANCE.GetType();
+    SPoint center(15, 20);
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center);
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+
+    ElementProfile profile;
+    tile.SetElementProfile(&profile);
+    assert(ew.TryEventAt(center));
+    tile.SetElementProfile(0);
+
+    const ElementProfile::Entry * wall = profile.FindEntry(WALL_TYPE);
+    assert(wall);
+    assert(wall->m_events == 1);
+    assert(wall->m_behaviorFailures == 0);
+    assert(wall->m_lockFailures == 0);
+    assert(wall->m_sitesChanged == 0);  // Wall does nothing
+    u64 histogramEvents = 0;
+    for (u32 b = 0; b < ElementProfile::HISTOGRAM_BUCKETS; ++b)
+    {
+      histogramEvents += wall->m_histogram.GetCount(b);
+    }
+    assert(histogramEvents == 1);
+    assert(!profile.FindEntry(DREG_TYPE));
+
+    ElementProfile sum;
+    sum.RecordEvent(DREG_TYPE, 100, 2, true);
+    sum.RecordLockFailure(WALL_TYPE);
+    sum.Add(profile);
+    assert(sum.FindEntry(WALL_TYPE)->m_events == 1);
+    assert(sum.FindEntry(WALL_TYPE)->m_lockFailures == 1);
+    assert(sum.FindEntry(DREG_TYPE)->m_sitesChanged == 2);
+    assert(sum.FindEntry(DREG_TYPE)->m_behaviorFailures == 1);
+    assert(sum.FindEntry(DREG_TYPE)->m_histogram.GetCount(6) == 1);
+  }
+
+  void EventWindow_Test::Test_EventWindowCacheProfile()
+  {
+    assert(CacheProfile::Histogram::GetBucket(0) == 0);
+    assert(CacheProfile::Histogram::GetBucket(1000) == 9);
+    assert(CacheProfile::Histogram::GetBucket(((u64) 1) << 40) == CacheProfile::HISTOGRAM_BUCKETS - 1);
+
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+
+    SPSCChannel channel;
+    LonglivedLock lock;
+    tile.Connect(channel, lock, Dirs::EAST);
+
+    const s32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    SPoint center(tile.TILE_WIDTH - R - 1, tile.TILE_HEIGHT / 2);  // Window reaches the east cache
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center);
+
+    CacheProfile profile;
+    tile.SetCacheProfile(&profile);
+    const CacheProfile::Boundary & east = profile.GetBoundary(Dirs::EAST);
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+
+    // While the far side holds the boundary, events there stall
+    int farSide;
+    assert(lock.TryLock(&farSide));
+    assert(!ew.TryEventAt(center));
+    assert(east.m_stalls[CacheProfile::STALL_CONTENDED] == 1);
+    assert(lock.Unlock(&farSide));
+
+    // Once it's released, the event ships its update east
+    ew.SetEventWindowsExecuted(2000000); // make the last attempt look old too
+    assert(ew.TryEventAt(center));
+    CacheProcessor<TestEventConfig> & cp = tile.GetCacheProcessor(Dirs::EAST);
+    for (u32 i = 0; i < 10 && cp.Advance(); ++i) { }
+    assert(east.m_packets > 0);
+    assert(east.m_bytes > 0);
+    assert(east.m_atomsUpdated == 0);  // Wall changes nothing
+    assert(east.m_updates == 0);       // No reply has come back
+
+    // ..and until the reply comes, the boundary stays busy
+    THREEDIR lockRegions = { Dirs::EAST, (Dir) -1, (Dir) -1 };
+    assert(ew.AcquireDirLock(Dirs::EAST, 1, lockRegions) == TestEventWindow::LOCK_UNAVAILABLE);
+    assert(east.m_stalls[CacheProfile::STALL_BUSY] == 1);
+    assert(profile.GetTotalStalls() == 2);
+
+    for (Dir d = 0; d < Dirs::DIR_COUNT; ++d)
+    {
+      if (d != Dirs::EAST)
+      {
+        assert(profile.GetBoundary(d).m_packets == 0);
+      }
+    }
+
+    CacheProfile sum;
+    sum.RecordLatency(Dirs::WEST, 1000);
+    sum.Add(profile);
+    assert(sum.GetBoundary(Dirs::WEST).m_updates == 1);
+    assert(sum.GetBoundary(Dirs::WEST).m_latency.GetCount(9) == 1);
+    assert(sum.GetBoundary(Dirs::EAST).m_bytes == east.m_bytes);
+
+    tile.SetCacheProfile(0);
+  }
+
+
+  void EventWindow_Test::Test_EventWindowTypeQueries()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Wall<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(Element_Wall<TestEventConfig>::THE_INSTANCE);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    const u32 WALL_TYPE = Element_Wall<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 RES_TYPE = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 EMPTY_TYPE = Element_Empty<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 TYPES[3] = { WALL_TYPE, RES_TYPE, EMPTY_TYPE };
+
+    const MDist<4> & md = MDist<4>::get();
+    SPoint center(15, 20);  // Hitting no caches
+    tile.PlaceAtom(TestAtom(WALL_TYPE,0,0,0), center);
+    for (u32 i = 1; i < md.GetTableSize(4); i += 3)
+    {
+      tile.PlaceAtom(TestAtom(i % 2 ? RES_TYPE : WALL_TYPE,0,0,0), center + md.GetPoint(i));
+    }
+
+    TestEventWindow & ew = tile.GetEventWindow();
+    ew.SetEventWindowsExecuted(1000000); // make event 0 look very old to avoid recency reject
+    assert(ew.TryEventAt(center));
+
+    // Writes since loading must be seen too
+    const SPoint east(1, 0);
+    ew.SetRelativeAtomDirect(east, TestAtom(RES_TYPE,0,0,0));
+
+    WindowScanner<TestEventConfig> scanner(ew);
+    for (u32 radius = 1; radius <= 4; ++radius)
+    {
+      for (u32 t = 0; t < 3; ++t)
+      {
+        u32 expected = 0;
+        for (u32 i = 1; i <= md.GetLastIndex(radius); ++i)
+        {
+          if (ew.IsLiveSiteDirect(md.GetPoint(i)) &&
+              ew.GetRelativeAtomDirect(md.GetPoint(i)).GetType() == TYPES[t])
+          {
+            ++expected;
+          }
+        }
+        assert(radius < 4 || expected > 0);
+        assert(ew.CountSitesOfType(TYPES[t], radius) == expected);
+        assert(scanner.CountAtomsOfType(TYPES[t], radius) == expected);
+        assert(scanner.CanSeeAtomOfType(TYPES[t], radius) == (expected > 0));
+
+        for (u32 k = 0; expected > 0 && k < 10; ++k)
+        {
+          SPoint found;
+          assert(scanner.FindRandomLocationOfType(TYPES[t], radius, found) == expected);
+          assert(found != SPoint(0, 0));
+          assert(found.GetManhattanLength() <= radius);
+          assert(ew.GetRelativeAtomDirect(found).GetType() == TYPES[t]);
+        }
+      }
+    }
+
+    // The center is never counted, and missing types are not found
+    SPoint untouched(7, 7);
+    assert(ew.CountSitesOfType(0xFA11, 4) == 0);
+    assert(!scanner.CanSeeAtomOfType(0xFA11, 4));
+    assert(scanner.FindRandomLocationOfType(0xFA11, 4, untouched) == 0);
+    assert(untouched == SPoint(7, 7));
+
+    ew.StoreToTile();
+    assert(tile.GetAtom(center + east)->GetType() == RES_TYPE);
+  }
 } /* namespace MFM */
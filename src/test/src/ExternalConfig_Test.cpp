@@ -6,7 +6,11 @@
 #include "ZStringByteSource.h"
 #include "FileByteSink.h"  /* For STDERR */
 #include "Element_Dreg.h"
+#include "Element_Empty.h"
 #include "AbstractDriver.h"
+#include "GridSnapshot.h"
+#include <stdio.h>  /* For remove */
+#include <unistd.h> /* For getpid */
 
 namespace MFM
 {
@@ -47,8 +51,127 @@ namespace MFM
 
   }
 
+  static void TestSnapshotRoundTrip()
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/ExternalConfig_Test_snapshot.%d.mfs", (s32) getpid());
+    Element<TestEventConfig> & dreg = Element_Dreg<TestEventConfig>::THE_INSTANCE;
+
+    ElementRegistry<TestEventConfig> ereg;
+    TestDriver td;
+
+    TestGrid grid(ereg,4,3,GRID_LAYOUT_CHECKERBOARD);
+    grid.SetSeed(1);
+    grid.Init();
+    grid.Needed(Element_Empty<TestEventConfig>::THE_INSTANCE);
+    grid.Needed(dreg);
+
+    const u32 W = grid.GetWidthSites();
+    const u32 H = grid.GetHeightSites();
+    for (u32 i = 0; i < 50; ++i)
+    {
+      SPoint pt((i * 37) % W, (i * 53) % H);
+      grid.PlaceAtom(dreg.GetDefaultAtom(), pt);
+    }
+    const u32 dregs = grid.GetAtomCount(dreg.GetType());
+    assert(dregs > 0);
+
+    // Give every other plane something to carry too
+    for (u32 i = 0; i < 20; ++i)
+    {
+      SPoint pt((i * 41) % W, (i * 29) % H);
+      grid.PlaceAtomInSite(true, dreg.GetDefaultAtom(), pt);
+    }
+    for (u32 ty = 0; ty < grid.GetHeight(); ++ty)
+    {
+      for (u32 tx = 0; tx < grid.GetWidth(); ++tx)
+      {
+        Tile<TestEventConfig> & tile = grid.GetTile(tx, ty);
+        for (u32 y = 0; y < tile.OWNED_HEIGHT; ++y)
+        {
+          for (u32 x = 0; x < tile.OWNED_WIDTH; ++x)
+          {
+            const u32 n = (ty * grid.GetWidth() + tx) * tile.OWNED_HEIGHT * tile.OWNED_WIDTH +
+              y * tile.OWNED_WIDTH + x;
+            TestSite & site = tile.GetUncachedSite(SPoint(x, y));
+            site.GetBase().SetPaint(0xff000000 | (n * 2654435761u >> 8));
+            if (n % 3 == 0)
+            {
+              site.GetBase().GetSensory().m_touchSensor.Touch(TOUCH_TYPE_LIGHT, n + 7);
+            }
+            SiteCounters & sc = site.GetCounters();
+            sc.m_eventCount = n;
+            sc.m_lastChangedEventCount = n / 2;
+            sc.m_lastEventNumber = (((u64) n) << 32) | 5;
+            sc.m_isLiveSite = (n % 5) != 0;
+          }
+        }
+      }
+    }
+
+    {
+      ExternalConfig<TestGridConfig> cfg(td);
+      ExternalConfigSectionGrid<TestGridConfig> section(cfg, grid);
+      cfg.RegisterSection(section);
+      GridSnapshot<TestGridConfig> snap(cfg, section, grid);
+      assert(snap.Write(path));
+      assert(section.IsWriteSites());
+    }
+    assert(GridSnapshot<TestGridConfig>::IsSnapshotFile(path));
+
+    TestGrid copy(ereg,4,3,GRID_LAYOUT_CHECKERBOARD);
+    copy.SetSeed(2);
+    copy.Init();
+    copy.Needed(Element_Empty<TestEventConfig>::THE_INSTANCE);
+    copy.Needed(dreg);
+    {
+      ExternalConfig<TestGridConfig> cfg(td);
+      OverflowableCharBufferByteSink<1024> errs;
+      cfg.SetErrorByteSink(errs);
+      ExternalConfigSectionGrid<TestGridConfig> section(cfg, copy);
+      cfg.RegisterSection(section);
+      GridSnapshot<TestGridConfig> snap(cfg, section, copy);
+      assert(snap.Read(path));
+    }
+    remove(path);
+
+    assert(copy.GetAtomCount(dreg.GetType()) == dregs);
+    for (u32 ty = 0; ty < grid.GetHeight(); ++ty)
+    {
+      for (u32 tx = 0; tx < grid.GetWidth(); ++tx)
+      {
+        Tile<TestEventConfig> & was = grid.GetTile(tx, ty);
+        Tile<TestEventConfig> & is = copy.GetTile(tx, ty);
+        for (u32 y = 0; y < was.OWNED_HEIGHT; ++y)
+        {
+          for (u32 x = 0; x < was.OWNED_WIDTH; ++x)
+          {
+            TestSite & a = was.GetUncachedSite(SPoint(x, y));
+            TestSite & b = is.GetUncachedSite(SPoint(x, y));
+            assert(b.GetAtom() == a.GetAtom());
+            assert(b.GetBase().GetBaseAtom() == a.GetBase().GetBaseAtom());
+            assert(b.GetBase().GetPaint() == a.GetBase().GetPaint());
+
+            const SiteTouchSensor & as = a.GetBase().GetSensory().m_touchSensor;
+            const SiteTouchSensor & bs = b.GetBase().GetSensory().m_touchSensor;
+            assert(bs.m_touchType == as.m_touchType);
+            assert(bs.m_lastTouchEventCount == as.m_lastTouchEventCount);
+
+            const SiteCounters & ac = a.GetCounters();
+            const SiteCounters & bc = b.GetCounters();
+            assert(bc.m_eventCount == ac.m_eventCount);
+            assert(bc.m_lastChangedEventCount == ac.m_lastChangedEventCount);
+            assert(bc.m_lastEventNumber == ac.m_lastEventNumber);
+            assert(bc.m_isLiveSite == ac.m_isLiveSite);
+          }
+        }
+      }
+    }
+  }
+
   void ExternalConfig_Test::Test_RunTests()
   {
     TestBasic();
+    TestSnapshotRoundTrip();
   }
 }
@@ -1,10 +1,70 @@
 #include "assert.h"
 #include "Grid.h"
 #include "Grid_Test.h"
+#include "GridRasterizer.h"
+#include "PNGEncoder.h"
 #include "Element_Res.h"
+#include "OverflowableCharBufferByteSink.h"
+#include "Mutex.h"
+#include <stdio.h>   /* For fprintf */
+#include <stdlib.h>  /* For abort */
+#include <pthread.h>
 
 namespace MFM {
 
+  /**
+   * Aborts the test run, naming what hung, unless destroyed within
+   * its time limit.  A lost wakeup in grid control would otherwise
+   * leave the test waiting forever instead of failing.
+   */
+  class TestWatchdog
+  {
+  public:
+    TestWatchdog(const char * what, u32 seconds)
+      : m_done(m_lock)
+      , m_what(what)
+      , m_seconds(seconds)
+      , m_disarmed(false)
+    {
+      assert(!pthread_create(&m_thread, NULL, Watch, this));
+    }
+
+    ~TestWatchdog()
+    {
+      {
+        Mutex::ScopeLock lock(m_lock);
+        m_disarmed = true;
+        m_done.Signal();
+      }
+      assert(!pthread_join(m_thread, NULL));
+    }
+
+  private:
+    Mutex m_lock;
+    Mutex::Condition m_done;
+    const char * m_what;
+    const u32 m_seconds;
+    bool m_disarmed;
+    pthread_t m_thread;
+
+    static void * Watch(void * arg)
+    {
+      TestWatchdog & dog = *(TestWatchdog *) arg;
+      const u64 deadline = GetMonotonicNanos() + ((u64) dog.m_seconds) * 1000000000;
+      Mutex::ScopeLock lock(dog.m_lock);
+      while (!dog.m_disarmed)
+      {
+        if (GetMonotonicNanos() >= deadline)
+        {
+          fprintf(stderr, "%s: no progress in %d seconds\n", dog.m_what, dog.m_seconds);
+          abort();
+        }
+        dog.m_done.WaitUsec(100000);
+      }
+      return NULL;
+    }
+  };
+
   void Grid_Test::Test_gridPlaceAtom()
   {
 
@@ -27,4 +87,243 @@ namespace MFM {
     assert(out->GetType() == atom.GetType());
 
   }
+
+  void Grid_Test::Test_gridRasterize()
+  {
+    // Checksums of "123456789", as published for CRC-32 and Adler-32
+    const u8 * check = (const u8 *) "123456789";
+    assert(PNGEncoder::CRC32(check, 9) == 0xcbf43926);
+    assert(PNGEncoder::CRC32(check + 4, 5, PNGEncoder::CRC32(check, 4)) == 0xcbf43926);
+    assert(PNGEncoder::Adler32(check, 9) == 0x091e01de);
+
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid grid(ereg,4,3, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    grid.SetSeed(1);
+    grid.Init();
+
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    grid.Needed(res);
+
+    SPoint gloc(37, 50);  // Not in tile (0,0)
+    grid.PlaceAtom(res.GetDefaultAtom(), gloc);
+
+    GridRasterizer<TestGridConfig> raster(grid);
+    assert(raster.GetWidth() == grid.GetWidthSites());
+    assert(raster.GetHeight() == grid.GetHeightSites());
+
+    raster.Render(0, 3);
+    assert(raster.GetPixel(37, 50) == res.GetStaticColor());
+    assert(raster.GetPixel(36, 50) == (u32) GridRasterizer<TestGridConfig>::EMPTY_COLOR);
+    assert(raster.GetPixel(0, 0) == (u32) GridRasterizer<TestGridConfig>::EMPTY_COLOR);
+
+    OString8192 png;
+    raster.WritePNG(png);
+    assert(!png.HasOverflowed());
+    const u8 * bytes = (const u8 *) png.GetBuffer();
+    assert(png.GetLength() > 8 + 25 + 12 + 12);
+    assert(!memcmp(bytes, "\x89PNG\r\n\x1a\n", 8));
+    assert(!memcmp(bytes + 12, "IHDR", 4));
+    assert(bytes[16 + 3] == raster.GetWidth() && bytes[20 + 3] == raster.GetHeight());
+    assert(!memcmp(bytes + png.GetLength() - 12, "\0\0\0\0IEND\xae\x42\x60\x82", 12));
+
+    OString1024 ppmHeader;
+    ppmHeader.Printf("P6\n%d %d\n255\n", raster.GetWidth(), raster.GetHeight());
+    OString8192 ppm;
+    raster.WritePPM(ppm);
+    assert(ppm.HasOverflowed());  // 3 bytes per pixel won't fit
+    assert(!memcmp(ppm.GetBuffer(), ppmHeader.GetBuffer(), ppmHeader.GetLength()));
+  }
+
+  void Grid_Test::Test_gridRefreshCaches()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid placed(ereg,4,3, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+    TestGrid bulk(ereg,4,3, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    TestGrid * grids[2] = { &placed, &bulk };
+    for (u32 g = 0; g < 2; ++g)
+    {
+      grids[g]->SetSeed(1);
+      grids[g]->Init();
+      grids[g]->Needed(res);
+    }
+
+    // PlaceAtom updates caches as it goes; PlaceAtomInOwner leaves
+    // them to RefreshAllCaches
+    for (u32 y = 0; y < placed.GetHeightSites(); ++y)
+    {
+      for (u32 x = (y * 3) % 7; x < placed.GetWidthSites(); x += 7)
+      {
+        placed.PlaceAtom(res.GetDefaultAtom(), SPoint(x, y));
+        bulk.PlaceAtomInOwner(res.GetDefaultAtom(), SPoint(x, y));
+      }
+    }
+
+    for (u32 pass = 0; pass < 2; ++pass)
+    {
+      u32 differences = 0;
+      for (u32 tx = 0; tx < placed.GetWidth(); ++tx)
+      {
+        for (u32 ty = 0; ty < placed.GetHeight(); ++ty)
+        {
+          const Tile<TestEventConfig> & p = placed.GetTile(SPoint(tx, ty));
+          const Tile<TestEventConfig> & b = bulk.GetTile(SPoint(tx, ty));
+          for (u32 y = 0; y < TestGrid::TILE_HEIGHT; ++y)
+          {
+            for (u32 x = 0; x < TestGrid::TILE_WIDTH; ++x)
+            {
+              differences += *p.GetAtom(SPoint(x, y)) != *b.GetAtom(SPoint(x, y));
+            }
+          }
+        }
+      }
+      assert(pass == 0 ? differences > 0 : differences == 0);
+      bulk.RefreshAllCaches(3);
+    }
+  }
+
+  void Grid_Test::Test_gridShutdownTileThreads()
+  {
+    // Thread per tile, then a pool of workers
+    const u32 WORKERS[2] = { 0, 3 };
+    for (u32 w = 0; w < 2; ++w)
+    {
+      ElementRegistry<TestEventConfig> ereg;
+      TestGrid * grid = new TestGrid(ereg,4,3, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+      grid->SetSeed(1);
+      grid->Init();
+      grid->Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+      grid->PlaceAtom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom(), SPoint(20, 20));
+
+      grid->SetTileWorkerCount(WORKERS[w]);
+      grid->InitThreads();
+      assert(grid->HasTileThreads());
+
+      grid->Unpause();
+      SleepMsec(20);
+      grid->Pause();
+
+      // Returns only after every thread has exited, so nothing can
+      // touch the grid once it's gone
+      grid->ShutdownTileThreads();
+      assert(!grid->HasTileThreads());
+      delete grid;
+    }
+  }
+
+  void Grid_Test::Test_gridPauseUnpauseCycles()
+  {
+    // Thread per tile, then a pool of workers
+    const u32 WORKERS[2] = { 0, 3 };
+    const u32 CYCLES = 30;
+    for (u32 w = 0; w < 2; ++w)
+    {
+      ElementRegistry<TestEventConfig> ereg;
+      TestGrid * grid = new TestGrid(ereg,4,3, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+      grid->SetSeed(1);
+      grid->Init();
+      grid->Needed(Element_Res<TestEventConfig>::THE_INSTANCE);
+      for (u32 i = 0; i < 10; ++i)
+        grid->PlaceAtom(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom(),
+                        SPoint(10 + 11 * i, 10 + 7 * i));
+
+      grid->SetTileWorkerCount(WORKERS[w]);
+      grid->InitThreads();
+
+      {
+        TestWatchdog dog(WORKERS[w] ? "Pause/Unpause with workers" : "Pause/Unpause per tile", 60);
+
+        u64 running = 0;
+        for (u32 c = 0; c < CYCLES; ++c)
+        {
+          const u64 before = grid->GetTotalEventsExecuted();
+          grid->Unpause();
+
+          // Mix back-to-back controls with runs long enough to do
+          // events, and with pauses long enough for threads to park
+          if (c % 3 != 0)
+            SleepMsec(10);
+          grid->Pause();
+
+          const u64 paused = grid->GetTotalEventsExecuted();
+          running += paused - before;
+          if (c % 5 == 0)
+            SleepMsec(20);
+
+          // Nothing runs while paused
+          assert(grid->GetTotalEventsExecuted() == paused);
+        }
+        assert(running > 0);
+
+        grid->ShutdownTileThreads();
+      }
+      assert(!grid->HasTileThreads());
+      delete grid;
+    }
+  }
+
+  void Grid_Test::Test_gridSnapshotAtomCounts()
+  {
+    ElementRegistry<TestEventConfig> ereg;
+    TestGrid * grid = new TestGrid(ereg,4,3, (GridLayoutPattern) GRID_LAYOUT_CHECKERBOARD);
+    grid->SetSeed(1);
+    grid->SetTileSnapshotInterval(1);
+    grid->Init();
+
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    grid->Needed(res);
+    for (u32 i = 0; i < 10; ++i)
+      grid->PlaceAtom(res.GetDefaultAtom(), SPoint(10 + 11 * i, 10 + 7 * i));
+
+    const ElementType types[2] = { res.GetType(), Element_Empty<TestEventConfig>::THE_INSTANCE.GetType() };
+    const u32 sites = grid->GetWidth() * grid->GetHeight() * TestGrid::OWNED_WIDTH * TestGrid::OWNED_HEIGHT;
+    u32 counts[2];
+
+    // Nothing to count until every tile has published
+    assert(!grid->HasTileSnapshots());
+    assert(!grid->CountSnapshotAtoms(types, 2, counts));
+    TestAtom atom;
+    assert(!grid->GetSnapshotAtom(SPoint(10, 10), atom));
+
+    for (TestGrid::iterator_type i = grid->begin(); i != grid->end(); ++i)
+      i->PublishSnapshot();
+    assert(grid->HasTileSnapshots());
+    assert(grid->CountSnapshotAtoms(types, 2, counts));
+    assert(counts[0] == 10);
+    assert(counts[0] == grid->GetAtomCount(types[0]));
+    assert(counts[1] == grid->GetAtomCount(types[1]));
+
+    // Single sites read from snapshots match the live grid
+    for (u32 i = 0; i < 10; ++i)
+    {
+      SPoint site(10 + 11 * i, 10 + 7 * i), next(11 + 11 * i, 10 + 7 * i);
+      assert(grid->GetSnapshotAtom(site, atom) && atom == *grid->GetAtom(site));
+      assert(grid->GetSnapshotAtom(next, atom) && atom == *grid->GetAtom(next));
+    }
+    assert(!grid->GetSnapshotAtom(SPoint(-1, 0), atom));
+
+    // Counting and rasterizing from snapshots while the tiles run
+    GridRasterizer<TestGridConfig> raster(*grid);
+    grid->SetTileWorkerCount(3);
+    grid->InitThreads();
+    {
+      TestWatchdog dog("Snapshot reads while running", 60);
+      const u64 before = grid->GetTotalEventsExecuted();
+      grid->Unpause();
+      for (u32 i = 0; i < 20; ++i)
+      {
+        assert(grid->CountSnapshotAtoms(types, 2, counts));
+        assert(counts[0] > 0 && counts[0] + counts[1] == sites);
+        raster.Render(0, 2);
+        SleepMsec(2);
+      }
+      grid->Pause();
+      assert(grid->GetTotalEventsExecuted() > before);
+
+      grid->ShutdownTileThreads();
+    }
+    delete grid;
+  }
 } /* namespace MFM */
@@ -23,4 +23,38 @@ void MDist_Test::Test_MDistConversion()
   assert(out.GetX() == 1);
   assert(out.GetY() == -1);
 }
+
+void MDist_Test::Test_MDistSymPermutation()
+{
+  const MDist<4> & md = MDist<4>::get();
+  const u32 sites = md.GetSiteCount();
+
+  for (u32 psym = 0; psym < PSYM_SYMMETRY_COUNT; ++psym)
+  {
+    const u8 * perm = md.GetSymPermutation((PointSymmetry) psym);
+    bool seen[EVENT_WINDOW_SITES(4)];
+    for (u32 i = 0; i < sites; ++i) seen[i] = false;
+
+    for (u32 i = 0; i < sites; ++i)
+    {
+      const SPoint & pt = md.GetPoint(i);
+      s32 expected = md.GetSiteNumber(SymMap(pt, (PointSymmetry) psym, pt));
+      u32 sn = md.GetSymSiteNumber(i, (PointSymmetry) psym);
+
+      assert(expected >= 0);
+      assert(sn == (u32) expected);
+      assert(perm[i] == sn);
+      assert(pt.GetManhattanLength() == md.GetPoint(sn).GetManhattanLength());
+      assert(!seen[sn]);
+      seen[sn] = true;
+    }
+  }
+
+  /* Illegal symmetries map everything out of the window */
+  const u8 * none = md.GetSymPermutation(PSYM_SYMMETRY_COUNT);
+  for (u32 i = 0; i < sites; ++i)
+  {
+    assert(none[i] == sites);
+  }
+}
 } /* namespace MFM */
@@ -0,0 +1,187 @@
+#include "assert.h"
+#include "Mutex_Test.h"
+#include "Util.h"
+#include "itype.h"
+#include <pthread.h>
+
+namespace MFM {
+
+  /**
+   * Waiters that each take one token, waiting for it on a shared
+   * Condition, so a test can see how many a Signal or Broadcast let
+   * through.  Waiters loop on the token count, so spurious wakeups
+   * don't count as releases.
+   */
+  struct TokenWaiters
+  {
+    enum { WAITERS = 3, TIMED_WAIT_USEC = 10000000 };
+
+    Mutex m_lock;
+    Mutex::Condition m_cond;
+    u32 m_tokens;
+    u32 m_waiting;
+    u32 m_released;
+    u32 m_timeouts;
+    bool m_timed;
+    pthread_t m_threads[WAITERS];
+
+    TokenWaiters(bool timed)
+      : m_cond(m_lock)
+      , m_tokens(0)
+      , m_waiting(0)
+      , m_released(0)
+      , m_timeouts(0)
+      , m_timed(timed)
+    { }
+
+    static void * Waiter(void * arg)
+    {
+      TokenWaiters & tw = *(TokenWaiters *) arg;
+      Mutex::ScopeLock lock(tw.m_lock);
+      ++tw.m_waiting;
+      while (tw.m_tokens == 0)
+      {
+        if (!tw.m_timed)
+          tw.m_cond.Wait();
+        else if (!tw.m_cond.WaitUsec(TIMED_WAIT_USEC))
+          ++tw.m_timeouts;
+      }
+      --tw.m_tokens;
+      --tw.m_waiting;
+      ++tw.m_released;
+      return NULL;
+    }
+
+    /**
+     * Start \c count waiters and return once all of them are inside
+     * the Condition: each counts itself in holding the lock, and only
+     * lets go of it by waiting.
+     */
+    void Start(u32 count)
+    {
+      assert(count <= WAITERS);
+      for (u32 i = 0; i < count; ++i)
+        assert(!pthread_create(&m_threads[i], NULL, Waiter, this));
+      while (GetWaiting() < count)
+        SleepMsec(1);
+    }
+
+    void Join(u32 count)
+    {
+      for (u32 i = 0; i < count; ++i)
+        assert(!pthread_join(m_threads[i], NULL));
+    }
+
+    u32 GetWaiting()
+    {
+      Mutex::ScopeLock lock(m_lock);
+      return m_waiting;
+    }
+
+    u32 GetReleased()
+    {
+      Mutex::ScopeLock lock(m_lock);
+      return m_released;
+    }
+
+    /**
+     * Wait up to ten seconds for \c count releases in all, and say
+     * whether they happened
+     */
+    bool AwaitReleased(u32 count)
+    {
+      for (u32 ms = 0; ms < 10000; ++ms)
+      {
+        if (GetReleased() >= count) return true;
+        SleepMsec(1);
+      }
+      return false;
+    }
+  };
+
+  void Mutex_Test::Test_ConditionTimeout() {
+    Mutex m;
+    Mutex::Condition c(m);
+    Mutex::ScopeLock lock(m);
+
+    const u32 USEC = 20000;
+    const u64 start = GetMonotonicNanos();
+    assert(!c.WaitUsec(USEC));
+    assert(GetMonotonicNanos() - start >= USEC * 1000);
+
+    // Timing out gives the lock back
+    m.AssertIHoldTheLock();
+
+    // Deadlines already past return promptly
+    assert(!c.WaitUsec(0));
+    m.AssertIHoldTheLock();
+  }
+
+  void Mutex_Test::Test_ConditionSignal() {
+    TokenWaiters tw(false);
+    tw.Start(TokenWaiters::WAITERS);
+
+    {
+      Mutex::ScopeLock lock(tw.m_lock);
+      tw.m_tokens = 1;
+      tw.m_cond.Signal();
+    }
+    assert(tw.AwaitReleased(1));
+
+    // Nobody else got out
+    SleepMsec(20);
+    assert(tw.GetReleased() == 1);
+    assert(tw.GetWaiting() == TokenWaiters::WAITERS - 1);
+
+    {
+      Mutex::ScopeLock lock(tw.m_lock);
+      tw.m_tokens = TokenWaiters::WAITERS - 1;
+      for (u32 i = 0; i < TokenWaiters::WAITERS - 1; ++i)
+        tw.m_cond.Signal();
+    }
+    assert(tw.AwaitReleased(TokenWaiters::WAITERS));
+    tw.Join(TokenWaiters::WAITERS);
+    assert(tw.m_tokens == 0);
+  }
+
+  void Mutex_Test::Test_ConditionBroadcast() {
+    TokenWaiters tw(false);
+    tw.Start(TokenWaiters::WAITERS);
+
+    {
+      Mutex::ScopeLock lock(tw.m_lock);
+      tw.m_tokens = TokenWaiters::WAITERS;
+      tw.m_cond.Broadcast();
+    }
+    assert(tw.AwaitReleased(TokenWaiters::WAITERS));
+    tw.Join(TokenWaiters::WAITERS);
+    assert(tw.m_tokens == 0);
+    assert(tw.GetWaiting() == 0);
+  }
+
+  void Mutex_Test::Test_ConditionSignalBeforeTimeout() {
+    TokenWaiters tw(true);
+    tw.Start(1);
+
+    const u64 start = GetMonotonicNanos();
+    {
+      Mutex::ScopeLock lock(tw.m_lock);
+      tw.m_tokens = 1;
+      tw.m_cond.Signal();
+    }
+    assert(tw.AwaitReleased(1));
+    tw.Join(1);
+
+    // Woken by the signal, long before its deadline
+    assert(tw.m_timeouts == 0);
+    assert(GetMonotonicNanos() - start < ((u64) TokenWaiters::TIMED_WAIT_USEC) * 1000);
+  }
+
+  void Mutex_Test::Test_RunTests() {
+    Test_ConditionTimeout();
+    Test_ConditionSignal();
+    Test_ConditionBroadcast();
+    Test_ConditionSignalBeforeTimeout();
+  }
+
+} /* namespace MFM */
@@ -0,0 +1,240 @@
+#include "assert.h"
+#include "PacketIO_Test.h"
+#include "SPSCChannel.h"
+#include "LonglivedLock.h"
+#include "MDist.h"
+#include "Element_Res.h"
+
+namespace MFM {
+
+  /**
+   * An SPSCChannel whose B side can read only as many bytes as the
+   * test has allowed so far, so packets arrive in whatever pieces the
+   * test chooses.
+   */
+  class TrickleChannel : public AbstractChannel
+  {
+    SPSCChannel m_channel;
+    u32 m_allowance;
+
+  public:
+    TrickleChannel()
+      : m_allowance(0)
+    { }
+
+    void Allow(u32 bytes)
+    {
+      m_allowance += bytes;
+    }
+
+    virtual u32 CanWrite(bool byA)
+    {
+      return m_channel.CanWrite(byA);
+    }
+
+    virtual u32 Write(bool byA, const u8 * data, u32 length)
+    {
+      return m_channel.Write(byA, data, length);
+    }
+
+    virtual u32 CanRead(bool byA)
+    {
+      u32 can = m_channel.CanRead(byA);
+      return byA ? can : MIN(can, m_allowance);
+    }
+
+    virtual u32 Read(bool byA, u8 * data, u32 length)
+    {
+      if (byA)
+      {
+        return m_channel.Read(byA, data, length);
+      }
+      u32 got = m_channel.Read(byA, data, MIN(length, m_allowance));
+      m_allowance -= got;
+      return got;
+    }
+  };
+
+  void PacketIO_Test::Test_RunTests()
+  {
+    Test_packetFraming();
+    Test_packetFramingOutOfRoom();
+    Test_packetUpdateBatch();
+  }
+
+  void PacketIO_Test::Test_packetFraming()
+  {
+    TrickleChannel channel;
+    ChannelEnd sender, receiver;
+    sender.ClaimChannelEnd(channel, true);
+    receiver.ClaimChannelEnd(channel, false);
+
+    // A short packet, then one needing the extended length
+    const u8 shortPacket[4] = { 3, 'a', 'b', 'c' };
+    sender.Write(shortPacket, sizeof(shortPacket));
+
+    const u32 LONG_LENGTH = 600;
+    u8 longPacket[3 + LONG_LENGTH];
+    longPacket[0] = PacketFraming::EXTENDED_LENGTH;
+    longPacket[1] = (u8) LONG_LENGTH;
+    longPacket[2] = (u8) (LONG_LENGTH >> 8);
+    for (u32 i = 0; i < LONG_LENGTH; ++i)
+    {
+      longPacket[3 + i] = (u8) (i * 7);
+    }
+    sender.Write(longPacket, sizeof(longPacket));
+
+    assert(receiver.ReceivePacket() == 0);     // Nothing readable yet
+
+    channel.Allow(3);                          // Length and part of the body
+    assert(receiver.ReceivePacket() == 0);
+    channel.Allow(1);
+    PacketBuffer * pb = receiver.ReceivePacket();
+    assert(pb != 0);
+    assert(pb->GetLength() == 3);
+    assert(pb->Equals("abc"));
+
+    channel.Allow(2);                          // Escape, and half the length
+    assert(receiver.ReceivePacket() == 0);
+    channel.Allow(1);                          // Rest of the length
+    assert(receiver.ReceivePacket() == 0);
+    channel.Allow(LONG_LENGTH - 1);
+    assert(receiver.ReceivePacket() == 0);
+    channel.Allow(1);
+    pb = receiver.ReceivePacket();
+    assert(pb != 0);
+    assert(pb->GetLength() == LONG_LENGTH);
+    assert(!memcmp(pb->GetBuffer(), &longPacket[3], LONG_LENGTH));
+
+    assert(receiver.ReceivePacket() == 0);
+  }
+
+  void PacketIO_Test::Test_packetFramingOutOfRoom()
+  {
+    SPSCChannel channel;
+    ChannelEnd sender, receiver;
+    sender.ClaimChannelEnd(channel, true);
+    receiver.ClaimChannelEnd(channel, false);
+
+    // Longer than any PacketBuffer
+    const u32 length = PacketBuffer().GetCapacity() + 1;
+    const u8 header[3] = { PacketFraming::EXTENDED_LENGTH, (u8) length, (u8) (length >> 8) };
+    sender.Write(header, sizeof(header));
+
+    volatile bool failed = false;
+    unwind_protect({
+        assert(MFMThrownFailCode == MFM_FAIL_CODE_NUMBER(OUT_OF_ROOM));
+        failed = true;
+      },{
+        receiver.ReceivePacket();
+      });
+    assert(failed);
+  }
+
+  /**
+     Load \c atoms, indexed by site number, into \c cp as a cache
+     update centered on \c center, ship it, and feed it to \c peer a
+     few bytes at a time until it has been received and acknowledged.
+   */
+  static void ShipUpdate(TrickleChannel & channel,
+                         CacheProcessor<TestEventConfig> & cp,
+                         CacheProcessor<TestEventConfig> & peer,
+                         const SPoint & center, const TestAtom * atoms)
+  {
+    const u32 SITES = EVENT_WINDOW_SITES(TestEventConfig::EVENT_WINDOW_RADIUS);
+
+    THREEDIR locks;
+    locks[0] = Dirs::EAST;
+    assert(cp.TryLock(1, locks));
+    cp.Activate();
+    cp.StartLoading(center);
+    for (u32 s = 0; s < SITES; ++s)
+    {
+      cp.MaybeSendAtom(atoms[s], true, s);
+    }
+    cp.StartShipping();
+    assert(cp.Advance());
+
+    while (!peer.Advance())
+    {
+      channel.Allow(7);
+    }
+    while (!peer.IsIdle())
+    {
+      channel.Allow(7);
+      peer.Advance();
+    }
+
+    assert(cp.Advance());   // The reply
+    assert(cp.IsBlocking());
+    cp.Unblock();
+  }
+
+  void PacketIO_Test::Test_packetUpdateBatch()
+  {
+    const u32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    const u32 SITES = EVENT_WINDOW_SITES(R);
+    const MDist<R> & md = MDist<R>::get();
+
+    TestTile west, east;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    west.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    east.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+
+    TrickleChannel channel;
+    LonglivedLock lock;
+    west.Connect(channel, lock, Dirs::EAST);   // Side A
+    east.Connect(channel, lock, Dirs::WEST);   // Side B
+    CacheProcessor<TestEventConfig> & cp = west.GetCacheProcessor(Dirs::EAST);
+    CacheProcessor<TestEventConfig> & peer = east.GetCacheProcessor(Dirs::WEST);
+
+    // Every site of each update gets a distinguishable atom
+    TestAtom atoms[SITES];
+    for (u32 s = 0; s < SITES; ++s)
+    {
+      atoms[s] = Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom();
+      atoms[s].SetStateField(0, 8, s + 1);
+    }
+
+    // First as text, then binary, over the same channel
+    for (u32 binary = 0; binary < 2; ++binary)
+    {
+      cp.SetBinaryPackets(binary != 0);
+      const u64 shippedBefore = cp.GetBytesShipped();
+
+      // Centered on the west tile's last owned column
+      const SPoint westCenter(west.TILE_WIDTH - R - 1, 2 * R + 3 * binary);
+      ShipUpdate(channel, cp, peer, westCenter, atoms);
+
+      // Where that column lands in the east tile's coordinates
+      const SPoint eastCenter(westCenter.GetX() - west.OWNED_WIDTH, westCenter.GetY());
+      u32 sent = 0;
+      for (u32 s = 0; s < SITES; ++s)
+      {
+        SPoint loc = eastCenter + md.GetPoint(s);
+        if (!east.IsInTile(loc))
+        {
+          continue;  // Not visible to the east tile; not sent
+        }
+        assert(*east.GetAtom(loc) == atoms[s]);
+        ++sent;
+      }
+      assert(sent > 0);
+
+      if (binary)
+      {
+        // One packet, long enough to need the extended length
+        const u32 ATOM_BYTES = BitVector<P3AtomConfig::BITS_PER_ATOM>::ARRAY_LENGTH * sizeof(u32);
+        assert(6 + sent * (2 + ATOM_BYTES) >= PacketFraming::EXTENDED_LENGTH);
+        assert(cp.GetBytesShipped() - shippedBefore == 3 + 6 + sent * (2 + ATOM_BYTES));
+      }
+
+      // Change them all for the next round
+      for (u32 s = 0; s < SITES; ++s)
+      {
+        atoms[s].SetStateField(8, 8, binary + 1);
+      }
+    }
+  }
+} /* namespace MFM */
@@ -7,6 +7,8 @@ namespace MFM {
   void Random_Test::Test_RunTests() {
     Test_randomSetSeed();
     Test_randomDeterministics();
+    Test_randomPhiloxKnownAnswers();
+    Test_randomPhiloxStreams();
   }
 
   Random & Random_Test::setup()
@@ -70,4 +72,132 @@ namespace MFM {
     }
   }
 
+  void Random_Test::Test_randomPhiloxKnownAnswers()
+  {
+    // Philox4x32-10 answers from the Random123 distribution
+    const u32 ctr[3][4] = {
+      { 0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+      { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+      { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }
+    };
+    const u32 key[3][2] = {
+      { 0x00000000, 0x00000000 },
+      { 0xffffffff, 0xffffffff },
+      { 0xa4093822, 0x299f31d0 }
+    };
+    const u32 answer[3][4] = {
+      { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+      { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+      { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+    };
+
+    for (u32 i = 0; i < 3; ++i)
+    {
+      u32 x0 = ctr[i][0], x1 = ctr[i][1], x2 = ctr[i][2], x3 = ctr[i][3];
+      RandPhilox::Blocks(key[i], &x0, &x1, &x2, &x3, 1);
+      assert(x0 == answer[i][0]);
+      assert(x1 == answer[i][1]);
+      assert(x2 == answer[i][2]);
+      assert(x3 == answer[i][3]);
+    }
+
+    // The bulk generator produces block n from counter n
+    RandPhilox philox;
+    philox.SetKey(key[2][0], key[2][1]);
+    for (u32 block = 0; block < 3 * RandPhilox::BULK_BLOCKS; ++block)
+    {
+      u32 x0 = block, x1 = 0, x2 = 0, x3 = 0;
+      RandPhilox::Blocks(key[2], &x0, &x1, &x2, &x3, 1);
+      assert(philox.Next() == x0);
+      assert(philox.Next() == x1);
+      assert(philox.Next() == x2);
+      assert(philox.Next() == x3);
+    }
+
+    // And can enter the stream anywhere
+    philox.SetCounter(5);
+    u32 x0 = 5, x1 = 0, x2 = 0, x3 = 0;
+    RandPhilox::Blocks(key[2], &x0, &x1, &x2, &x3, 1);
+    assert(philox.Next() == x0);
+  }
+
+  void Random_Test::Test_randomPhiloxStreams()
+  {
+    const u32 NUMS = 100;
+    Random r1, r2;
+    r1.SetGenerator(Random::GENERATOR_PHILOX);
+    r2.SetGenerator(Random::GENERATOR_PHILOX);
+    assert(r1.GetGenerator() == Random::GENERATOR_PHILOX);
+
+    // Same seed and stream reproduce; SetSeed is stream 0
+    r1.SetStream(7, 0);
+    r2.SetSeed(7);
+    for (u32 i = 0; i < NUMS; ++i)
+    {
+      assert(r1.Create() == r2.Create());
+    }
+
+    // Neighboring streams and seeds differ
+    u32 countSame = 0;
+    r1.SetStream(7, 1);
+    r2.SetStream(7, 2);
+    for (u32 i = 0; i < NUMS; ++i)
+    {
+      if (r1.Create() == r2.Create()) ++countSame;
+    }
+    assert(countSame < NUMS);
+
+    countSame = 0;
+    r1.SetStream(7, 1);
+    r2.SetStream(8, 1);
+    for (u32 i = 0; i < NUMS; ++i)
+    {
+      if (r1.Create() == r2.Create()) ++countSame;
+    }
+    assert(countSame < NUMS);
+
+    // Multiply-shift reduction stays in range and is roughly uniform
+    const u32 BINS = 7;
+    const u32 DRAWS = 70000;
+    u32 counts[BINS] = { 0 };
+    r1.SetStream(1, 1);
+    for (u32 i = 0; i < DRAWS; ++i)
+    {
+      u32 num = r1.Create(BINS);
+      assert(num < BINS);
+      ++counts[num];
+    }
+    for (u32 i = 0; i < BINS; ++i)
+    {
+      assert(counts[i] > 9000 && counts[i] < 11000);
+    }
+
+    for (u32 max = 1; max < 100000; max *= 3)
+    {
+      assert(r1.Create(max) < max);
+      assert(r1.OddsOf(0, max) == false);
+      assert(r1.OddsOf(max, max) == true);
+      s32 smax = (s32) max;
+      s32 num = r1.Between(-smax, smax);
+      assert(num >= -smax && num <= smax);
+    }
+    assert(r1.Create(U32_MAX) < U32_MAX);
+
+    // MT streams are reproducible too, and switching back restores MT
+    Random r3(1);
+    r1.SetGenerator(Random::GENERATOR_MT);
+    r1.SetSeed(1);
+    for (u32 i = 0; i < NUMS; ++i)
+    {
+      assert(r1.Create() == r3.Create());
+    }
+    r1.SetStream(3, 4);
+    r2.SetGenerator(Random::GENERATOR_MT);
+    r2.SetStream(3, 4);
+    for (u32 i = 0; i < NUMS; ++i)
+    {
+      assert(r1.Create() == r2.Create());
+    }
+  }
+
 } /* namespace MFM */
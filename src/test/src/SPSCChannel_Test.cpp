@@ -0,0 +1,119 @@
+#include "assert.h"
+#include "SPSCChannel_Test.h"
+#include "itype.h"
+#include <string.h> // For strlen, memcmp
+#include <pthread.h>
+
+namespace MFM {
+
+  void SPSCChannel_Test::Test_Basic() {
+    SPSCChannel sc;
+
+    assert(sc.CanRead(true) == 0);
+    assert(sc.CanRead(false) == 0);
+
+    assert(sc.CanWrite(true) == SPSCChannel::BUFFER_SIZE - 1);
+    assert(sc.CanWrite(false) == SPSCChannel::BUFFER_SIZE - 1);
+
+    const char * aWrite = "foo";
+    const u32 aLen = strlen(aWrite);
+    const char * bWrite = "barf";
+    const u32 bLen = strlen(bWrite);
+
+    assert(sc.Write(true, (const u8 *) aWrite, aLen) == aLen);
+    assert(sc.Write(false, (const u8 *) bWrite, bLen) == bLen);
+
+    // No transceiving: arrivals are immediate
+    assert(sc.CanRead(false) == aLen);
+    assert(sc.CanRead(true) == bLen);
+    assert(sc.CanWrite(true) == SPSCChannel::BUFFER_SIZE - 1 - aLen);
+    assert(sc.CanWrite(false) == SPSCChannel::BUFFER_SIZE - 1 - bLen);
+
+    u8 buf[10];
+    assert(sc.Read(false, buf, sizeof(buf)) == aLen);
+    assert(!memcmp(buf, aWrite, aLen));
+
+    assert(sc.Read(true, buf, 2) == 2);
+    assert(!memcmp(buf, bWrite, 2));
+    assert(sc.Read(true, buf, sizeof(buf)) == bLen - 2);
+    assert(!memcmp(buf, bWrite + 2, bLen - 2));
+
+    assert(sc.CanRead(true) == 0);
+    assert(sc.CanRead(false) == 0);
+    assert(sc.Read(true, buf, sizeof(buf)) == 0);
+  }
+
+  void SPSCChannel_Test::Test_Wraparound() {
+    SPSCChannel sc;
+    const u32 SIZE = SPSCChannel::BUFFER_SIZE;
+
+    u8 out[SIZE];
+    u8 in[SIZE];
+    for (u32 i = 0; i < SIZE; ++i)
+      out[i] = (u8) (i * 7 + 3);
+
+    // Fill it up; the last byte must not fit
+    assert(sc.Write(true, out, SIZE) == SIZE - 1);
+    assert(sc.CanWrite(true) == 0);
+    assert(sc.Write(true, out, 1) == 0);
+
+    assert(sc.Read(false, in, SIZE - 100) == SIZE - 100);
+    assert(!memcmp(in, out, SIZE - 100));
+
+    // This write straddles the end of the buffer
+    assert(sc.CanWrite(true) == SIZE - 100);
+    assert(sc.Write(true, out, 100) == 100);
+    assert(sc.CanRead(false) == 99 + 100);
+
+    assert(sc.Read(false, in, SIZE) == 99 + 100);
+    assert(!memcmp(in, out + SIZE - 100, 99));
+    assert(!memcmp(in + 99, out, 100));
+    assert(sc.CanRead(false) == 0);
+  }
+
+  static const u32 THREADED_BYTES = 10 * 1000 * 1000;
+
+  static void * SPSCProducer(void * arg)
+  {
+    SPSCChannel & sc = *(SPSCChannel *) arg;
+    u8 buf[97];
+    u32 sent = 0;
+    while (sent < THREADED_BYTES)
+    {
+      u32 len = THREADED_BYTES - sent;
+      if (len > sizeof(buf)) len = sizeof(buf);
+      for (u32 i = 0; i < len; ++i)
+        buf[i] = (u8) (sent + i);
+      u32 amt = sc.Write(true, buf, len);
+      if (amt < len) pthread_yield();
+      sent += amt;
+    }
+    return 0;
+  }
+
+  void SPSCChannel_Test::Test_Threaded() {
+    SPSCChannel sc;
+    pthread_t producer;
+    assert(!pthread_create(&producer, NULL, SPSCProducer, &sc));
+
+    u8 buf[113];
+    u32 received = 0;
+    while (received < THREADED_BYTES)
+    {
+      u32 amt = sc.Read(false, buf, sizeof(buf));
+      if (amt == 0) pthread_yield();
+      for (u32 i = 0; i < amt; ++i)
+        assert(buf[i] == (u8) (received + i));
+      received += amt;
+    }
+    assert(!pthread_join(producer, NULL));
+    assert(sc.CanRead(false) == 0);
+  }
+
+  void SPSCChannel_Test::Test_RunTests() {
+    Test_Basic();
+    Test_Wraparound();
+    Test_Threaded();
+  }
+
+} /* namespace MFM */
@@ -3,12 +3,22 @@
 #include "Point.h"
 #include "Tile_Test.h"
 #include "Element_Res.h"
+#include "Element_Empty.h"
+#include "SPSCChannel.h"
+#include "LonglivedLock.h"
 
 namespace MFM {
 
   void Tile_Test::Test_RunTests() {
     Test_tileSquareDistances();
     Test_tilePlaceAtom();
+    Test_tileSoASites();
+    Test_tileLiveSites();
+    Test_tileAtomCounts();
+    Test_tileChangeStamps();
+    Test_tileEventBatching();
+    Test_tileSnapshots();
+    Test_tileSnapshotsWhileRunning();
   }
 
   void Tile_Test::Test_tileSquareDistances()
@@ -58,4 +68,307 @@ namespace MFM {
 
     assert(other.GetType() == atom.GetType());
   }
+
+  void Tile_Test::Test_tileSoASites()
+  {
+    TestSoATile tile;
+    ElementTypeNumberMap<TestSoAEventConfig> etnm;
+    Element_Res<TestSoAEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestSoAEventConfig>::THE_INSTANCE);
+
+    TestAtom atom(Element_Res<TestSoAEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    SPoint loc(10, 10);
+
+    tile.PlaceAtom(atom, loc);
+
+    // Same API as an array of Sites..
+    assert(tile.GetAtom(loc)->GetType() == atom.GetType());
+    assert(&tile.GetSite(loc).GetAtom() == tile.GetAtom(loc));
+
+    TestSoASite & site = tile.GetSite(loc);
+    assert(site.GetEventCount() == 0);
+    site.RecordEventAtSite(7);
+    site.RecordEventAtSite(8);
+    assert(site.GetEventCount() == 2);
+    assert(site.GetWriteAge() == 2);
+    site.MarkChanged();
+    assert(site.GetWriteAge() == 0);
+
+    site.SetPaint(0xff123456);
+    assert(tile.GetSite(loc).GetPaint() == 0xff123456);
+
+    // ..but the atoms themselves are packed densely, in row-major order
+    const TestAtom * a0 = &tile.GetSite(SPoint(10, 10)).GetAtom();
+    assert(&tile.GetSite(SPoint(11, 10)).GetAtom() == a0 + 1);
+    assert(&tile.GetSite(SPoint(10, 11)).GetAtom() == a0 + TestSoATile::TILE_WIDTH);
+
+    // and the tile reaches them without going through the sites
+    const u32 sn = tile.GetSiteInTileNumber(loc);
+    assert(&tile.GetAtomByNumber(sn) == a0);
+    assert(&tile.GetAtomByNumber(0) == a0 - sn);
+    assert(sizeof(TestSoASite) == sizeof(u32));
+
+    TestTile aosTile;
+    aosTile.PlaceAtom(atom, loc);
+    assert(&aosTile.GetAtomByNumber(aosTile.GetSiteInTileNumber(loc)) == aosTile.GetAtom(loc));
+    assert(&aosTile.GetAtomByNumber(1) == &aosTile.GetSiteByNumber(1).GetAtom());
+
+    site.Clear();
+    assert(site.GetEventCount() == 0);
+    assert(tile.GetAtom(loc)->GetType() != atom.GetType());
+  }
+
+  void Tile_Test::Test_tileLiveSites()
+  {
+    TestTile tile;
+    const s32 W = tile.TILE_WIDTH;
+    const s32 H = tile.TILE_HEIGHT;
+    const s32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+
+    // Unconnected: exactly the owned sites are live
+    assert(!tile.IsLiveSite(SPoint(-1, 10)));
+    assert(!tile.IsLiveSite(SPoint(W, 10)));
+    assert(!tile.IsLiveSite(SPoint(0, 10)));
+    assert(!tile.IsLiveSite(SPoint(W - 1, H / 2)));
+    assert(tile.IsLiveSite(SPoint(R, R)));
+    assert(tile.IsLiveSite(SPoint(W / 2, H / 2)));
+    assert(!tile.IsReachableViaCacheProtocol(SPoint(R, R)));
+
+    // Connecting east must update the cached liveness of the east cache
+    SPSCChannel channel;
+    LonglivedLock lock;
+    tile.Connect(channel, lock, Dirs::EAST);
+
+    bool anyEastCacheLive = false;
+    for (s32 y = 0; y < H; ++y)
+    {
+      for (s32 x = W - R; x < W; ++x)
+      {
+        SPoint pt(x, y);
+        bool live = tile.IsLiveSite(pt);
+        assert(live == tile.IsCacheSitePossibleEventCenter(pt));
+        anyEastCacheLive |= live;
+      }
+    }
+    assert(anyEastCacheLive);
+    assert(!tile.IsLiveSite(SPoint(0, H / 2)));  // West still unconnected
+  }
+
+  void Tile_Test::Test_tileAtomCounts()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    res.AllocateType(etnm);
+    tile.RegisterElement(res);
+
+    const u32 resType = res.GetType();
+    const u32 emptyType = Element_Empty<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 owned = tile.OWNED_WIDTH * tile.OWNED_HEIGHT;
+
+    assert(tile.GetAtomCount(resType) == 0);
+    assert(tile.GetAtomCount(emptyType) == owned);
+
+    // Placements adjust the counts without a rescan
+    SPoint a(10, 10), b(11, 10);
+    tile.PlaceAtom(res.GetDefaultAtom(), a);
+    tile.PlaceAtom(res.GetDefaultAtom(), b);
+    tile.PlaceAtom(res.GetDefaultAtom(), b);  // No change
+    assert(tile.GetAtomCount(resType) == 2);
+    assert(tile.GetAtomCount(emptyType) == owned - 2);
+
+    tile.PlaceAtom(tile.GetEmptyAtom(), a);
+    assert(tile.GetAtomCount(resType) == 1);
+    assert(tile.GetAtomCount(emptyType) == owned - 1);
+    assert(tile.VerifyAtomCounts());
+
+    // Writes that bypass PlaceAtom fall back to a rescan
+    *tile.GetWritableAtom(b) = tile.GetEmptyAtom();
+    assert(tile.GetAtomCount(resType) == 0);
+    assert(tile.GetAtomCount(emptyType) == owned);
+    assert(tile.VerifyAtomCounts());
+  }
+
+  void Tile_Test::Test_tileChangeStamps()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element<TestEventConfig> & res = Element_Res<TestEventConfig>::THE_INSTANCE;
+    res.AllocateType(etnm);
+    tile.RegisterElement(res);
+
+    const s32 W = tile.TILE_WIDTH;
+    const s32 R = TestEventConfig::EVENT_WINDOW_RADIUS;
+    const SPoint owned(10, 10), other(11, 10), cache(W - 1, 10);
+    const u32 ownedNum = tile.GetSiteInTileNumber(owned);
+    const u32 otherNum = tile.GetSiteInTileNumber(other);
+    const u32 cacheNum = tile.GetSiteInTileNumber(cache);
+
+    // An owned write stamps just that site
+    u32 stamp = tile.GetChangeStamp();
+    tile.PlaceAtom(res.GetDefaultAtom(), owned);
+    assert(tile.IsSiteChangedSince(ownedNum, stamp));
+    assert(!tile.IsSiteChangedSince(otherNum, stamp));
+
+    // Rewriting the same atom is no change
+    stamp = tile.GetChangeStamp();
+    tile.PlaceAtom(res.GetDefaultAtom(), owned);
+    assert(!tile.IsSiteChangedSince(ownedNum, stamp));
+
+    // Base writes count too
+    tile.PlaceAtomInSite(true, res.GetDefaultAtom(), other);
+    assert(tile.IsSiteChangedSince(otherNum, stamp));
+    assert(!tile.IsSiteChangedSince(ownedNum, stamp));
+
+    // So do cache sites, once they are live
+    SPSCChannel channel;
+    LonglivedLock lock;
+    tile.Connect(channel, lock, Dirs::EAST);
+    assert(tile.IsLiveSite(cache) && cache.GetX() >= W - R);
+    stamp = tile.GetChangeStamp();
+    tile.PlaceAtom(res.GetDefaultAtom(), cache);
+    assert(tile.IsSiteChangedSince(cacheNum, stamp));
+    assert(!tile.IsSiteChangedSince(ownedNum, stamp));
+
+    // Writes that bypass PlaceAtom mark every site
+    stamp = tile.GetChangeStamp();
+    *tile.GetWritableAtom(owned) = tile.GetEmptyAtom();
+    assert(tile.IsSiteChangedSince(otherNum, stamp));
+    assert(tile.IsSiteChangedSince(cacheNum, stamp));
+    stamp = tile.GetChangeStamp();
+    assert(!tile.IsSiteChangedSince(ownedNum, stamp));
+  }
+
+  void Tile_Test::Test_tileEventBatching()
+  {
+    const u32 ADVANCES = 200;
+
+    // Unbatched: one event per Advance
+    {
+      TestTile tile;
+      tile.RequestStateActive();
+      for (u32 i = 0; i < ADVANCES; ++i)
+      {
+        tile.Advance();
+      }
+      assert(tile.GetEventWindow().GetEventWindowsAttempted() == ADVANCES);
+    }
+
+    // Batched and unconnected: no backlog, so the batch size grows to
+    // the limit and runs of hidden events share an Advance
+    {
+      TestTile tile;
+      tile.SetEventBatchLimit(16);
+      assert(tile.GetEventBatchLimit() == 16);
+      assert(tile.GetEventBatchSize() == 1);
+      tile.RequestStateActive();
+      for (u32 i = 0; i < ADVANCES; ++i)
+      {
+        tile.Advance();
+      }
+      assert(tile.GetEventBatchSize() == 16);
+      assert(tile.GetEventWindow().GetEventWindowsAttempted() > ADVANCES);
+    }
+
+    // Unread packets waiting: the batch size backs off
+    {
+      TestTile tile;
+      tile.SetEventBatchLimit(16);
+      tile.RequestStateActive();
+      for (u32 i = 0; i < ADVANCES; ++i)
+      {
+        tile.Advance();
+      }
+      assert(tile.GetEventBatchSize() == 16);
+
+      SPSCChannel channel;
+      LonglivedLock lock;
+      tile.Connect(channel, lock, Dirs::EAST);
+      u8 byte = 0;
+      channel.Write(false, &byte, 1);  // From the far side
+      tile.Advance();
+      assert(tile.GetEventBatchSize() == 8);
+    }
+  }
+
+  void Tile_Test::Test_tileSnapshots()
+  {
+    typedef TileSnapshots<TestAtom>::Reader Reader;
+
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_Res<TestEventConfig>::THE_INSTANCE.AllocateType(etnm);
+    tile.RegisterElement(Element_Res<TestEventConfig>::THE_INSTANCE);
+    const u32 resType = Element_Res<TestEventConfig>::THE_INSTANCE.GetType();
+    const u32 R = TestTile::EVENT_WINDOW_RADIUS;
+
+    // Off by default, and nothing published
+    assert(tile.GetSnapshotInterval() == 0);
+    tile.PublishSnapshot();
+    {
+      Reader r(tile.GetSnapshots());
+      assert(!r.IsValid());
+    }
+
+    tile.SetSnapshotInterval(10);
+    {
+      Reader r(tile.GetSnapshots());
+      assert(!r.IsValid());
+    }
+    tile.PublishSnapshot();
+
+    // A pinned snapshot keeps its atoms while newer ones are published
+    Reader before(tile.GetSnapshots());
+    assert(before.IsValid());
+    assert(before.GetEpoch() == 0);
+    assert(before.GetAtom(3, 4).GetType() != resType);
+
+    TestAtom res(Element_Res<TestEventConfig>::THE_INSTANCE.GetDefaultAtom());
+    tile.PlaceAtom(res, SPoint(3 + R, 4 + R));
+    tile.PublishSnapshot();
+
+    Reader after(tile.GetSnapshots());
+    assert(after.IsValid());
+    assert(after.GetAtom(3, 4).GetType() == resType);
+    assert(before.GetAtom(3, 4).GetType() != resType);
+
+    // Both unpublished buffers pinned: publishing is skipped
+    tile.PublishSnapshot();  // Into the third buffer
+    tile.PlaceAtom(res, SPoint(5 + R, 6 + R));
+    tile.PublishSnapshot();  // Nowhere to go
+    {
+      Reader r(tile.GetSnapshots());
+      assert(r.GetAtom(3, 4).GetType() == resType);
+      assert(r.GetAtom(5, 6).GetType() != resType);
+    }
+  }
+
+  void Tile_Test::Test_tileSnapshotsWhileRunning()
+  {
+    typedef TileSnapshots<TestAtom>::Reader Reader;
+    const u32 INTERVAL = 10;
+
+    TestTile tile;
+    tile.SetSnapshotInterval(INTERVAL);
+    tile.RequestStateActive();
+    for (u32 i = 0; i < 200; ++i)
+    {
+      tile.Advance();
+    }
+
+    // Unbatched, each Advance executes at most one event, so we
+    // publish within INTERVAL events of the last snapshot
+    {
+      Reader r(tile.GetSnapshots());
+      assert(r.IsValid());
+      assert(r.GetEpoch() > 0);
+      assert(tile.GetEventsExecuted() - r.GetEpoch() < INTERVAL);
+    }
+
+    tile.SetSnapshotInterval(0);
+    {
+      Reader r(tile.GetSnapshots());
+      assert(!r.IsValid());
+    }
+  }
 } /* namespace MFM */
@@ -0,0 +1,131 @@
+#include "assert.h"
+#include "UlamClassRegistry_Test.h"
+#include "UlamContextRestricted.h"
+#include "UlamElement.h"
+#include "itype.h"
+
+namespace MFM {
+
+  typedef UlamClass<TestEventConfig> TestUlamClass;
+  typedef UlamClassRegistry<TestEventConfig> TestUlamClassRegistry;
+
+  /* A stand-in for a culam-generated quark with at most one base */
+  struct TestUlamQuark : public TestUlamClass
+  {
+    const char * m_name;
+    u32 m_regnum;
+    const TestUlamClass * m_base;
+
+    TestUlamQuark(const char * name, u32 regnum, const TestUlamClass * base)
+      : m_name(name)
+      , m_regnum(regnum)
+      , m_base(base)
+    { }
+
+    virtual const char * GetMangledClassName() const { return m_name; }
+
+    virtual u32 GetRegistrationNumber() const { return m_regnum; }
+
+    virtual bool internalCMethodImplementingIs(const TestUlamClass * cptrarg) const
+    {
+      return cptrarg == this || (m_base && m_base->internalCMethodImplementingIs(cptrarg));
+    }
+  };
+
+  /* And a stand-in for a culam-generated element */
+  struct TestUlamElement : public UlamElement<TestEventConfig>
+  {
+    typedef TestEventConfig EC;  // For MFM_UUID_FOR
+
+    const char * m_name;
+    u32 m_regnum;
+    const TestUlamClass * m_base;
+
+    TestUlamElement(const char * name, u32 regnum, const TestUlamClass * base)
+      : UlamElement<TestEventConfig>(MFM_UUID_FOR("UlamRegTest", 1))
+      , m_name(name)
+      , m_regnum(regnum)
+      , m_base(base)
+    { }
+
+    virtual const char * GetMangledClassName() const { return m_name; }
+
+    virtual u32 GetRegistrationNumber() const { return m_regnum; }
+
+    virtual bool internalCMethodImplementingIs(const TestUlamClass * cptrarg) const
+    {
+      return cptrarg == this || (m_base && m_base->internalCMethodImplementingIs(cptrarg));
+    }
+  };
+
+  void UlamClassRegistry_Test::Test_RunTests() {
+    Test_UlamClassRegistryMangledNames();
+    Test_UlamClassRegistryIsA();
+  }
+
+  void UlamClassRegistry_Test::Test_UlamClassRegistryMangledNames()
+  {
+    TestUlamQuark fail("Uq_10104Fail10", 3, 0);
+    TestUlamQuark intxy("Uq_102115IntXY12102321u16102321u15", 7, 0);
+    TestUlamElement display("Ue_102419212Display64x3210", 5, 0);
+
+    TestUlamClassRegistry ucr;
+    assert(ucr.RegisterUlamClass(fail));
+    assert(ucr.RegisterUlamClass(display));
+    assert(ucr.RegisterUlamClass(intxy));
+    assert(!ucr.RegisterUlamClass(intxy));
+
+    assert(ucr.GetUlamClassIndex("Uq_10104Fail10") == 3);
+    assert(ucr.GetUlamClassIndex("Uq_102115IntXY12102321u16102321u15") == 7);
+    assert(ucr.GetUlamClassByMangledName("Ue_102419212Display64x3210") == &display);
+    assert(ucr.IsRegisteredUlamClass("Uq_10104Fail10"));
+
+    assert(ucr.GetUlamClassIndex("Uq_102115IntXY12102321i16102321u15") < 0);
+    assert(!ucr.GetUlamClassByMangledName("Ue_102689214WindowServices10"));
+  }
+
+  void UlamClassRegistry_Test::Test_UlamClassRegistryIsA()
+  {
+    TestUlamQuark base("Uq_10104Base10", 0, 0);
+    TestUlamQuark mid("Uq_10103Mid10", 1, &base);
+    TestUlamQuark other("Uq_10105Other10", 2, 0);
+    TestUlamElement elt("Ue_10103Elt10", 3, &mid);
+    TestUlamElement plain("Ue_10105Plain10", 4, 0);
+    TestUlamQuark late("Uq_10104Late10", 5, &base);
+    TestUlamQuark stranger("Uq_10108Stranger10", 6, 0);  // Never registered
+
+    TestUlamClassRegistry ucr;
+    // Register some classes before and some after the elements
+    assert(ucr.RegisterUlamClass(mid));
+    assert(ucr.RegisterUlamClass(elt));
+    assert(ucr.RegisterUlamClass(base));
+    assert(ucr.RegisterUlamClass(plain));
+    assert(ucr.RegisterUlamClass(other));
+    assert(ucr.RegisterUlamClass(late));
+
+    const TestUlamClass * classes[] = { &base, &mid, &other, &elt, &plain, &late };
+    const TestUlamClass * elements[] = { &elt, &plain };
+
+    ElementTable<TestEventConfig> et;
+    UlamContextRestricted<TestEventConfig> uc(et, ucr);
+
+    for (u32 e = 0; e < sizeof(elements)/sizeof(elements[0]); ++e)
+    {
+      for (u32 c = 0; c < sizeof(classes)/sizeof(classes[0]); ++c)
+      {
+        bool expected = elements[e]->internalCMethodImplementingIs(classes[c]);
+        assert(ucr.IsA(*elements[e], *classes[c]) == (expected ? 1 : 0));
+        assert(TestUlamClass::IsA(uc, *elements[e], classes[c]) == expected);
+      }
+    }
+    assert(ucr.IsA(elt, base) == 1);
+    assert(ucr.IsA(elt, late) == 0);
+    assert(ucr.IsA(plain, plain) == 1);
+
+    // Quarks have no rows, and unregistered classes no columns
+    assert(ucr.IsA(mid, base) < 0);
+    assert(ucr.IsA(elt, stranger) < 0);
+    assert(!TestUlamClass::IsA(uc, elt, &stranger));
+  }
+
+} /* namespace MFM */
@@ -1,9 +1,65 @@
 #include "assert.h"
 #include "UlamElement_Test.h"
+#include "Test_Common.h"
 #include "itype.h"
 
 namespace MFM {
 
+  /**
+   * An element with costly atom colors, like an UlamElement, that
+   * counts how often they are computed
+   */
+  template <class EC>
+  class Element_ColorTest : public Element<EC>
+  {
+    typedef typename EC::ATOM_CONFIG AC;
+    typedef typename AC::ATOM_TYPE T;
+
+  public:
+    static Element_ColorTest THE_INSTANCE;
+
+    ElementParameterU32<EC> m_tint;
+    mutable u32 m_colorsComputed;
+
+    virtual u32 GetTypeFromThisElement() const
+    {
+      return 0xC010;
+    }
+
+    Element_ColorTest()
+      : Element<EC>(MFM_UUID_FOR("ColorTest", 1))
+      , m_tint(this, "tint", "Tint", "Added to every color", 0, 0, 255)
+      , m_colorsComputed(0)
+    {
+      Element<EC>::SetAtomicSymbol("Ct");
+      Element<EC>::SetName("ColorTest");
+      Element<EC>::SetCachingAtomColors(true);
+    }
+
+    virtual const T & GetDefaultAtom() const
+    {
+      static T defaultAtom(THE_INSTANCE.GetType(),0,0,0);
+      return defaultAtom;
+    }
+
+    virtual u32 GetElementColor() const
+    {
+      return 0xff00ff00;
+    }
+
+    virtual u32 GetAtomColor(const ElementTable<EC> & et, const UlamClassRegistry<EC> & ucr, const T& atom, u32 selector) const
+    {
+      ++m_colorsComputed;
+      return 0xff000000 + 1000 * selector + m_tint.GetValue() + Element<EC>::GetBits(atom).Read(T::ATOM_FIRST_STATE_BIT, 8);
+    }
+
+    virtual void Behavior(EventWindow<EC>& window) const
+    { }
+  };
+
+  template <class EC>
+  Element_ColorTest<EC> Element_ColorTest<EC>::THE_INSTANCE;
+
   struct UlamTypeCase {
     const char * mangled;
     const char * pretty;
@@ -39,6 +95,8 @@ namespace MFM {
 
   void UlamElement_Test::Test_RunTests() {
 
+    Test_UlamElementColorCache();
+
     for (u32 i = 0; i < sizeof(allCases)/sizeof(allCases[0]); ++i) {
       CharBufferByteSource cbs(allCases[i].mangled, strlen(allCases[i].mangled));
       UlamTypeInfo utin;
@@ -54,5 +112,46 @@ namespace MFM {
     }
   }
 
+  void UlamElement_Test::Test_UlamElementColorCache()
+  {
+    TestTile tile;
+    ElementTypeNumberMap<TestEventConfig> etnm;
+    Element_ColorTest<TestEventConfig> & elt = Element_ColorTest<TestEventConfig>::THE_INSTANCE;
+    elt.AllocateTypeForTesting(etnm);
+    tile.RegisterElement(elt);
+    assert(elt.IsCachingAtomColors());
 
+    const ElementTable<TestEventConfig> & et = tile.GetElementTable();
+    const UlamClassRegistry<TestEventConfig> & ucr = tile.GetUlamClassRegistry();
+
+    TestAtom atoms[4];
+    for (u32 i = 0; i < 4; ++i)
+    {
+      atoms[i] = elt.GetDefaultAtom();
+      Element<TestEventConfig>::GetBits(atoms[i]).Write(TestAtom::ATOM_FIRST_STATE_BIT, 8, 10 * i);
+    }
+
+    // Repeated states are computed once per selector
+    elt.m_colorsComputed = 0;
+    for (u32 pass = 0; pass < 10; ++pass)
+    {
+      for (u32 i = 0; i < 4; ++i)
+      {
+        assert(elt.GetDynamicColor(et, ucr, atoms[i], 1) == 0xff000000 + 1000 + 10 * i);
+        assert(elt.GetDynamicColor(et, ucr, atoms[i], 2) == 0xff000000 + 2000 + 10 * i);
+      }
+    }
+    assert(elt.m_colorsComputed == 8);
+
+    // Changing a parameter recomputes them
+    elt.m_tint.SetValue(5);
+    assert(elt.GetDynamicColor(et, ucr, atoms[3], 1) == 0xff000000 + 1000 + 30 + 5);
+    assert(elt.m_colorsComputed == 9);
+
+    // As does clearing the cache
+    elt.ClearAtomColorCache();
+    assert(elt.GetDynamicColor(et, ucr, atoms[3], 1) == 0xff000000 + 1000 + 30 + 5);
+    assert(elt.m_colorsComputed == 10);
+    elt.m_tint.SetValue(0);
+  }
 } /* namespace MFM */
@@ -5,6 +5,7 @@
 namespace MFM {
 
   typedef UlamRef<TestEventConfig> TestUlamRef;
+  typedef UlamRefTyped<TestEventConfig, AtomBitStorage<TestEventConfig> > TestUlamRefTyped;
   typedef ElementTable<TestEventConfig> TestElementTable;
   typedef UlamContext<TestEventConfig> TestUlamContext;
 
@@ -43,6 +44,7 @@ namespace MFM {
     Test_UlamRefWrite();
     Test_UlamRefWriteLong();
     Test_UlamRefEffSelf();
+    Test_UlamRefTyped();
   }
 
   void UlamRef_Test::Test_UlamRefRead()
@@ -494,5 +496,80 @@ namespace MFM {
   }
 
 
+  void UlamRef_Test::Test_UlamRefTyped()
+  {
+    TestElementTable tet;
+    TestUlamContext tuc(tet);
+
+    // Typed and virtual reads agree everywhere
+    {
+      AtomBitStorage<TestEventConfig> t(setup());
+      for (u32 pos = 0; pos < 96; ++pos)
+      {
+        for (u32 len = 1; pos + len <= 96 && len <= 64; ++len)
+        {
+          TestUlamRef ur(pos, len, t, 0, TestUlamRef::PRIMITIVE, tuc);
+          TestUlamRefTyped urt(pos, len, t, 0, TestUlamRef::PRIMITIVE, tuc);
+          if (len <= 32)
+            assert(urt.Read() == ur.Read());
+          assert(urt.ReadLong() == ur.ReadLong());
+          assert(urt.ReadBig() == ur.ReadBig());
+        }
+      }
+    }
+
+    // Typed writes land where virtual writes do
+    {
+      AtomBitStorage<TestEventConfig> t(setup());
+      AtomBitStorage<TestEventConfig> tt(setup());
+
+      TestUlamRef ur(20, 50, t, 0, TestUlamRef::PRIMITIVE, tuc);
+      TestUlamRefTyped urt(20, 50, tt, 0, TestUlamRef::PRIMITIVE, tuc);
+      ur.WriteLong(HexU64(0x2dead,0xbeefcafe));
+      urt.WriteLong(HexU64(0x2dead,0xbeefcafe));
+      assert(t.GetAtom().GetBits() == tt.GetAtom().GetBits());
+      assert(urt.ReadLong() == HexU64(0x2dead,0xbeefcafe));
+
+      TestUlamRefTyped urt2(urt, 5, 20, 0, TestUlamRef::PRIMITIVE);
+      assert(urt2.GetPos() == 25);
+      assert(urt2.GetLen() == 20);
+      TestUlamRef ur2(ur, 5, 20, 0, TestUlamRef::PRIMITIVE);
+      ur2.Write(0x12345);
+      urt2.Write(0x12345);
+      assert(t.GetAtom().GetBits() == tt.GetAtom().GetBits());
+      assert(urt2.Read() == 0x12345);
+
+      TestUlamRef whole(0, 96, t, 0, TestUlamRef::PRIMITIVE, tuc);
+      TestUlamRefTyped wholet(0, 96, tt, 0, TestUlamRef::PRIMITIVE, tuc);
+      BV96 big(whole.ReadBig());
+      big.Write(40, 16, 0xf00d);
+      whole.WriteBig(big);
+      wholet.WriteBig(big);
+      assert(t.GetAtom().GetBits() == tt.GetAtom().GetBits());
+      assert(wholet.ReadBig() == big);
+
+      BitVector<16> b16(0xabcd);
+      BitVector<16> r16;
+      wholet.WriteBV(72, b16);
+      wholet.ReadBV(72, r16);
+      assert(r16.Read(0,16) == 0xabcd);
+      assert(tt.Read(72,16) == 0xabcd);
+    }
+
+    // And on a BitVectorBitStorage
+    {
+      typedef BitVectorBitStorage<TestEventConfig,BitVector<320> > BVS;
+      BVS t;
+      for (u32 i = 0; i < 320/8; ++i)
+        t.Write(i * 8, 8, i + 1);
+
+      UlamRefTyped<TestEventConfig, BVS> urt(100, 64, t, 0, TestUlamRef::PRIMITIVE, tuc);
+      TestUlamRef ur(100, 64, t, 0, TestUlamRef::PRIMITIVE, tuc);
+      assert(urt.ReadLong() == ur.ReadLong());
+      urt.WriteLong(HexU64(0x01234567,0x89abcdef));
+      assert(ur.ReadLong() == HexU64(0x01234567,0x89abcdef));
+    }
+  }
+
 
 } /* namespace MFM */